@@ -0,0 +1,93 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/string/StringUtils.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		std::string EscapeJson(const std::string& str)
+		{
+			std::string result;
+			result.reserve(str.size());
+			for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+			{
+				if (*it == '"' || *it == '\\')
+					result.push_back('\\');
+				result.push_back(*it);
+			}
+			return result;
+		}
+
+	}
+
+
+	BenchmarkContext::BenchmarkContext(const std::string& filter, double scale) :
+		_filter(filter), _scale(scale)
+	{ }
+
+
+	bool BenchmarkContext::IsEnabled(const std::string& group) const
+	{ return _filter.empty() || Contains(group, _filter); }
+
+
+	u64 BenchmarkContext::Iterations(u64 defaultIterations) const
+	{
+		const u64 result = (u64)(defaultIterations * _scale);
+		return result ? result : 1;
+	}
+
+
+	void BenchmarkContext::Report(const BenchmarkResult& result)
+	{
+		_results.push_back(result);
+		fprintf(stderr, "%-10s %-32s %-12s %12.1f ns/op %14.0f op/s", result.Group.c_str(), result.Name.c_str(), result.Param.c_str(), result.GetNanosecondsPerOp(), result.GetOpsPerSecond());
+		if (result.HitRatio)
+			fprintf(stderr, " %8.2f%% hits", *result.HitRatio * 100);
+		fprintf(stderr, "\n");
+	}
+
+
+	void BenchmarkContext::Write(FILE* out, ReportFormat format) const
+	{
+		switch (format)
+		{
+		case ReportFormat::Csv:
+			fprintf(out, "group,name,param,operations,elapsed_ns,ns_per_op,ops_per_sec,hit_ratio\n");
+			for (Results::const_iterator it = _results.begin(); it != _results.end(); ++it)
+			{
+				fprintf(out, "%s,%s,%s,%llu,%llu,%.3f,%.1f,", it->Group.c_str(), it->Name.c_str(), it->Param.c_str(),
+						(unsigned long long)it->Operations, (unsigned long long)it->ElapsedNanoseconds, it->GetNanosecondsPerOp(), it->GetOpsPerSecond());
+				if (it->HitRatio)
+					fprintf(out, "%.4f", *it->HitRatio);
+				fprintf(out, "\n");
+			}
+			break;
+
+		case ReportFormat::Json:
+			fprintf(out, "[\n");
+			for (Results::const_iterator it = _results.begin(); it != _results.end(); ++it)
+			{
+				fprintf(out, "  { \"group\": \"%s\", \"name\": \"%s\", \"param\": \"%s\", \"operations\": %llu, \"elapsed_ns\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f",
+						EscapeJson(it->Group).c_str(), EscapeJson(it->Name).c_str(), EscapeJson(it->Param).c_str(),
+						(unsigned long long)it->Operations, (unsigned long long)it->ElapsedNanoseconds, it->GetNanosecondsPerOp(), it->GetOpsPerSecond());
+				if (it->HitRatio)
+					fprintf(out, ", \"hit_ratio\": %.4f", *it->HitRatio);
+				fprintf(out, " }%s\n", it + 1 == _results.end() ? "" : ",");
+			}
+			fprintf(out, "]\n");
+			break;
+		}
+	}
+
+}}
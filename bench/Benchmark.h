@@ -0,0 +1,149 @@
+#ifndef STINGRAYKIT_BENCH_BENCHMARK_H
+#define STINGRAYKIT_BENCH_BENCHMARK_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/core/NonCopyable.h>
+#include <stingraykit/thread/ConditionVariable.h>
+#include <stingraykit/time/TimeEngine.h>
+#include <stingraykit/toolkit.h>
+#include <stingraykit/optional.h>
+#include <stingraykit/Types.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace stingray {
+namespace bench
+{
+
+	struct ReportFormat
+	{
+		STINGRAYKIT_ENUM_VALUES(Csv, Json);
+		STINGRAYKIT_DECLARE_ENUM_CLASS(ReportFormat);
+	};
+
+
+	struct BenchmarkResult
+	{
+		std::string			Group;
+		std::string			Name;
+		std::string			Param;
+		u64					Operations;
+		u64					ElapsedNanoseconds;
+		optional<double>	HitRatio; // for the cache trace benchmarks
+
+		BenchmarkResult(const std::string& group, const std::string& name, const std::string& param, u64 operations, u64 elapsedNanoseconds) :
+			Group(group), Name(name), Param(param), Operations(operations), ElapsedNanoseconds(elapsedNanoseconds)
+		{ }
+
+		BenchmarkResult(const std::string& group, const std::string& name, const std::string& param, u64 operations, u64 elapsedNanoseconds, double hitRatio) :
+			Group(group), Name(name), Param(param), Operations(operations), ElapsedNanoseconds(elapsedNanoseconds), HitRatio(hitRatio)
+		{ }
+
+		double GetNanosecondsPerOp() const	{ return Operations ? (double)ElapsedNanoseconds / Operations : 0; }
+		double GetOpsPerSecond() const		{ return ElapsedNanoseconds ? (double)Operations * 1000000000 / ElapsedNanoseconds : 0; }
+	};
+
+
+	class BenchmarkContext
+	{
+		STINGRAYKIT_NONCOPYABLE(BenchmarkContext);
+
+		typedef std::vector<BenchmarkResult>	Results;
+
+	private:
+		std::string		_filter;
+		double			_scale;
+		Results			_results;
+
+	public:
+		BenchmarkContext(const std::string& filter, double scale);
+
+		/// @brief Checks whether a benchmark group was requested on the command line
+		bool IsEnabled(const std::string& group) const;
+
+		/// @brief Scales the default iteration count of a benchmark, never returns zero
+		u64 Iterations(u64 defaultIterations) const;
+
+		void Report(const BenchmarkResult& result);
+
+		void Write(FILE* out, ReportFormat format) const;
+	};
+
+
+	class Stopwatch
+	{
+	private:
+		u64		_start;
+
+	public:
+		Stopwatch() : _start(TimeEngine::GetMonotonicNanoseconds())
+		{ }
+
+		u64 ElapsedNanoseconds() const
+		{ return TimeEngine::GetMonotonicNanoseconds() - _start; }
+	};
+
+
+	/// @brief Counts down executed operations and lets the measuring thread wait for all of them
+	class CompletionLatch
+	{
+		STINGRAYKIT_NONCOPYABLE(CompletionLatch);
+
+	private:
+		Mutex				_mutex;
+		ConditionVariable	_cond;
+		u64					_remaining;
+
+	public:
+		explicit CompletionLatch(u64 count) : _remaining(count)
+		{ }
+
+		void Reset(u64 count)
+		{
+			MutexLock l(_mutex);
+			_remaining = count;
+		}
+
+		void CountDown()
+		{
+			MutexLock l(_mutex);
+			if (--_remaining == 0)
+				_cond.Broadcast();
+		}
+
+		void Wait()
+		{
+			MutexLock l(_mutex);
+			while (_remaining != 0)
+				_cond.Wait(_mutex);
+		}
+	};
+
+
+	/// @brief Prevents the compiler from throwing away the result of a benchmarked expression
+	template < typename T >
+	inline void DoNotOptimize(const T& value)
+	{ asm volatile("" : : "g"(&value) : "memory"); }
+
+
+	void RunFunctionBenchmarks(BenchmarkContext& context);
+	void RunSignalBenchmarks(BenchmarkContext& context);
+	void RunExecutorBenchmarks(BenchmarkContext& context);
+	void RunTimerBenchmarks(BenchmarkContext& context);
+	void RunLogBenchmarks(BenchmarkContext& context);
+	void RunCacheBenchmarks(BenchmarkContext& context);
+	void RunDictionaryBenchmarks(BenchmarkContext& context);
+	void RunOrderedBenchmarks(BenchmarkContext& context);
+	void RunIntervalTreeBenchmarks(BenchmarkContext& context);
+
+}}
+
+#endif
@@ -0,0 +1,270 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/collection/ExpiringCache.h>
+#include <stingraykit/collection/HashQueueCache.h>
+#include <stingraykit/collection/QueueCache.h>
+#include <stingraykit/collection/ShardedCache.h>
+#include <stingraykit/collection/TinyLfuCache.h>
+#include <stingraykit/collection/TwoQueueCache.h>
+#include <stingraykit/function/bind.h>
+
+#include <algorithm>
+#include <math.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const u32 CacheCapacity = 10000;
+		const size_t ReaderThreads = 4;
+
+		const u32 TraceKeys = 100000;
+		const u32 TraceCacheCapacity = TraceKeys / 100;
+		const u32 TraceScanPeriod = 20000;
+		const u32 TraceScanLength = TraceCacheCapacity * 4;
+
+
+		/// @brief Cheap deterministic key sequence, so that every cache sees the same accesses
+		class KeyGenerator
+		{
+		private:
+			u32		_state;
+
+		public:
+			KeyGenerator() : _state(12345)
+			{ }
+
+			u32 Next(u32 range)
+			{
+				_state = _state * 1664525 + 1013904223;
+				return (_state >> 8) % range;
+			}
+		};
+
+
+		/// @brief Zipf distributed keys with exponent 1: the key k is accessed with probability proportional to 1 / (k + 1)
+		class ZipfGenerator
+		{
+			static const u32 Resolution = 1 << 24;
+
+		private:
+			KeyGenerator		_keys;
+			std::vector<u32>	_cdf;
+
+		public:
+			explicit ZipfGenerator(u32 range) : _cdf(range)
+			{
+				double total = 0;
+				for (u32 i = 0; i < range; ++i)
+					total += 1.0 / (i + 1);
+
+				double sum = 0;
+				for (u32 i = 0; i < range; ++i)
+				{
+					sum += 1.0 / (i + 1);
+					_cdf[i] = (u32)ceil(sum / total * Resolution);
+				}
+				_cdf.back() = Resolution;
+			}
+
+			u32 Next()
+			{ return std::upper_bound(_cdf.begin(), _cdf.end(), _keys.Next(Resolution)) - _cdf.begin(); }
+		};
+
+
+		struct ZipfTrace : public ZipfGenerator
+		{
+			ZipfTrace() : ZipfGenerator(TraceKeys)
+			{ }
+		};
+
+
+		/// @brief The Zipf trace interrupted with sequential scans of the keys that are never accessed again
+		class ScanTrace
+		{
+		private:
+			ZipfGenerator	_zipf;
+			u32				_position;
+			u32				_scanKey;
+
+		public:
+			ScanTrace() : _zipf(TraceKeys), _position(), _scanKey(TraceKeys)
+			{ }
+
+			u32 Next()
+			{
+				_position = (_position + 1) % (TraceScanPeriod + TraceScanLength);
+				return _position < TraceScanPeriod ? _zipf.Next() : _scanKey++;
+			}
+		};
+
+
+		template < typename Trace_ >
+		void BenchmarkHitRatio(BenchmarkContext& context, ICache<u32, u32>& cache, const std::string& name, const std::string& param)
+		{
+			const u64 accesses = context.Iterations(1000000);
+
+			Trace_ trace;
+			u64 hits = 0;
+			Stopwatch sw;
+			for (u64 i = 0; i < accesses; ++i)
+			{
+				const u32 key = trace.Next();
+				u32 value = 0;
+				if (cache.TryGet(key, value))
+					++hits;
+				else
+					cache.Set(key, key);
+				DoNotOptimize(value);
+			}
+			context.Report(BenchmarkResult("cache", name, param, accesses, sw.ElapsedNanoseconds(), (double)hits / accesses));
+		}
+
+
+		template < typename Trace_ >
+		void BenchmarkHitRatios(BenchmarkContext& context, const std::string& name)
+		{
+			{
+				LruCache<u32, u32>::ValueT cache(TraceCacheCapacity);
+				BenchmarkHitRatio<Trace_>(context, cache, name, "lru");
+			}
+			{
+				FifoCache<u32, u32>::ValueT cache(TraceCacheCapacity);
+				BenchmarkHitRatio<Trace_>(context, cache, name, "fifo");
+			}
+			{
+				TwoQueueCache<u32, u32> cache(TraceCacheCapacity / 4, TraceCacheCapacity / 4, TraceCacheCapacity / 2);
+				BenchmarkHitRatio<Trace_>(context, cache, name, "two_queue");
+			}
+			{
+				TinyLfuCache<u32, u32> cache(TraceCacheCapacity);
+				BenchmarkHitRatio<Trace_>(context, cache, name, "tiny_lfu");
+			}
+		}
+
+
+		template < typename Cache_ >
+		void BenchmarkCache(BenchmarkContext& context, const std::string& param)
+		{
+			const u64 iterations = context.Iterations(2000000);
+
+			Cache_ cache(CacheCapacity);
+			for (u32 i = 0; i < CacheCapacity; ++i)
+				cache.Set(i, i);
+
+			{
+				KeyGenerator keys;
+				u32 value = 0;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					cache.TryGet(keys.Next(CacheCapacity), value);
+					DoNotOptimize(value);
+				}
+				context.Report(BenchmarkResult("cache", "hit", param, iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				u32 key = CacheCapacity;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i, ++key)
+					cache.Set(key, key);
+				context.Report(BenchmarkResult("cache", "set_evict", param, iterations, sw.ElapsedNanoseconds()));
+			}
+		}
+
+
+		/// @brief The way the caches were shared between threads before ShardedCache
+		class LockedCache : public virtual ICache<u32, u32>
+		{
+		private:
+			Mutex							_mutex;
+			HashLruCache<u32, u32>::ValueT	_cache;
+
+		public:
+			explicit LockedCache(size_t capacity) : _cache(capacity)
+			{ }
+
+			virtual bool TryGet(u32 key, u32& out)		{ MutexLock l(_mutex); return _cache.TryGet(key, out); }
+			virtual void Set(u32 key, u32 value)		{ MutexLock l(_mutex); _cache.Set(key, value); }
+			virtual bool TryRemove(u32 key)				{ MutexLock l(_mutex); return _cache.TryRemove(key); }
+			virtual void Clear()						{ MutexLock l(_mutex); _cache.Clear(); }
+			virtual size_t GetSize() const				{ MutexLock l(_mutex); return _cache.GetSize(); }
+
+			virtual signal_connector<OnEvictedSignature> OnEvicted() const
+			{ return _cache.OnEvicted(); }
+		};
+
+
+		shared_ptr<ICache<u32, u32> > CreateShard(size_t capacity)
+		{ return make_shared<HashLruCache<u32, u32>::ValueT>(capacity); }
+
+
+		void ReadCache(ICache<u32, u32>* cache, u64 count, CompletionLatch* latch, const ICancellationToken&)
+		{
+			KeyGenerator keys;
+			u32 value = 0;
+			for (u64 i = 0; i < count; ++i)
+			{
+				cache->TryGet(keys.Next(CacheCapacity), value);
+				DoNotOptimize(value);
+			}
+			latch->CountDown();
+		}
+
+
+		void BenchmarkConcurrentCache(BenchmarkContext& context, ICache<u32, u32>& cache, const std::string& param)
+		{
+			const u64 perThread = context.Iterations(1000000);
+
+			for (u32 i = 0; i < CacheCapacity; ++i)
+				cache.Set(i, i);
+
+			CompletionLatch latch(ReaderThreads);
+			Stopwatch sw;
+			{
+				std::vector<ThreadPtr> threads;
+				for (size_t i = 0; i < ReaderThreads; ++i)
+					threads.push_back(make_shared<Thread>(StringBuilder() % "benchCache" % i, bind(&ReadCache, &cache, perThread, &latch, _1)));
+				latch.Wait();
+			}
+			context.Report(BenchmarkResult("cache", "concurrent_hit", param, perThread * ReaderThreads, sw.ElapsedNanoseconds()));
+		}
+
+	}
+
+
+	void RunCacheBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkCache<LruCache<u32, u32>::ValueT>(context, "lru");
+		BenchmarkCache<HashLruCache<u32, u32>::ValueT>(context, "hash_lru");
+		BenchmarkCache<FifoCache<u32, u32>::ValueT>(context, "fifo");
+		BenchmarkCache<HashFifoCache<u32, u32>::ValueT>(context, "hash_fifo");
+		BenchmarkCache<ExpiringCache<u32, u32> >(context, "expiring_lru");
+		BenchmarkCache<TinyLfuCache<u32, u32> >(context, "tiny_lfu");
+
+		{
+			LockedCache cache(CacheCapacity);
+			BenchmarkConcurrentCache(context, cache, "locked_hash_lru");
+		}
+
+		{
+			ShardedCache<u32, u32> cache(16, bind(&CreateShard, CacheCapacity / 16));
+			BenchmarkConcurrentCache(context, cache, "sharded_hash_lru");
+		}
+
+		BenchmarkHitRatios<ZipfTrace>(context, "hit_ratio_zipf");
+		BenchmarkHitRatios<ScanTrace>(context, "hit_ratio_scan");
+	}
+
+}}
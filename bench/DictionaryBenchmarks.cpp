@@ -0,0 +1,92 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/collection/HashDictionary.h>
+#include <stingraykit/collection/MapDictionary.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const u32 DictionarySize = 100000;
+
+
+		/// @brief Spreads the keys over the whole u32 range, so that they are neither sequential nor sorted
+		inline u32 GetKey(u32 i)
+		{ return i * 2654435761u; }
+
+
+		template < typename Dictionary_ >
+		void BenchmarkDictionary(BenchmarkContext& context, const std::string& param)
+		{
+			const u64 iterations = context.Iterations(2000000);
+
+			Dictionary_ dict;
+			{
+				Stopwatch sw;
+				for (u32 i = 0; i < DictionarySize; ++i)
+					dict.Set(GetKey(i), i);
+				context.Report(BenchmarkResult("dictionary", "set_new", param, DictionarySize, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				u32 value = 0;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					dict.TryGet(GetKey((u32)(i * 7919 % DictionarySize)), value);
+					DoNotOptimize(value);
+				}
+				context.Report(BenchmarkResult("dictionary", "get_hit", param, iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				u32 sum = 0;
+				Stopwatch sw;
+				for (shared_ptr<IEnumerator<KeyValuePair<u32, u32> > > en = dict.GetEnumerator(); en->Valid(); en->Next())
+					sum += en->Get().Value;
+				DoNotOptimize(sum);
+				context.Report(BenchmarkResult("dictionary", "enumerate", param, DictionarySize, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const u64 writes = context.Iterations(1000);
+				Stopwatch sw;
+				for (u64 i = 0; i < writes; ++i)
+				{
+					const shared_ptr<IEnumerator<KeyValuePair<u32, u32> > > en = dict.GetEnumerator();
+					dict.Set(GetKey((u32)(i % DictionarySize)), 0);
+				}
+				context.Report(BenchmarkResult("dictionary", "set_while_enumerated", param, writes, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				Stopwatch sw;
+				for (u32 i = 0; i < DictionarySize; ++i)
+					dict.Remove(GetKey(i));
+				context.Report(BenchmarkResult("dictionary", "remove", param, DictionarySize, sw.ElapsedNanoseconds()));
+			}
+		}
+
+	}
+
+
+	void RunDictionaryBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkDictionary<MapDictionary<u32, u32> >(context, "map");
+		BenchmarkDictionary<PersistentMapDictionary<u32, u32>::Type>(context, "persistent_map");
+		BenchmarkDictionary<BTreeMapDictionary<u32, u32>::Type>(context, "btree_map");
+		BenchmarkDictionary<HashDictionary<u32, u32> >(context, "hash");
+		BenchmarkDictionary<HashDictionary<u32, u32, hashers::Hash, comparers::Equals, true> >(context, "hash_ordered");
+	}
+
+}}
@@ -0,0 +1,221 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/function/bind.h>
+#include <stingraykit/string/ToString.h>
+#include <stingraykit/thread/ThreadTaskExecutor.h>
+#include <stingraykit/timer/Timer.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const size_t ProducerCounts[] = { 1, 2, 4, 8 };
+
+
+		struct LatencyProbe
+		{
+			u64					PostedAt;
+			u64					TotalLatency;
+			CompletionLatch		Latch;
+
+			LatencyProbe() : PostedAt(0), TotalLatency(0), Latch(1) { }
+
+			void Run()
+			{
+				TotalLatency += TimeEngine::GetMonotonicNanoseconds() - PostedAt;
+				Latch.CountDown();
+			}
+		};
+
+
+		void BenchmarkPostToRunLatency(BenchmarkContext& context, const std::string& param, const optional<TimeDuration>& profileTimeout)
+		{
+			const u64 iterations = context.Iterations(20000);
+			const ThreadTaskExecutorPtr executor = make_shared<ThreadTaskExecutor>("benchLatency", profileTimeout);
+
+			LatencyProbe probe;
+			const function<void()> task(bind(&LatencyProbe::Run, &probe));
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				probe.Latch.Reset(1);
+				probe.PostedAt = TimeEngine::GetMonotonicNanoseconds();
+				executor->AddTask(task);
+				probe.Latch.Wait();
+			}
+
+			context.Report(BenchmarkResult("executor", "post_to_run_latency", param, iterations, probe.TotalLatency));
+		}
+
+
+		/// @brief Keeps the executor queue below ThreadTaskExecutor::TaskCountLimit, so that the measurement is not polluted by its overflow reports
+		class InFlightLimiter
+		{
+			STINGRAYKIT_NONCOPYABLE(InFlightLimiter);
+
+		private:
+			Mutex				_mutex;
+			ConditionVariable	_cond;
+			size_t				_available;
+			CompletionLatch&	_latch;
+
+		public:
+			InFlightLimiter(size_t limit, CompletionLatch& latch) : _available(limit), _latch(latch)
+			{ }
+
+			void Acquire()
+			{
+				MutexLock l(_mutex);
+				while (_available == 0)
+					_cond.Wait(_mutex);
+				--_available;
+			}
+
+			void Complete()
+			{
+				{
+					MutexLock l(_mutex);
+					if (_available++ == 0)
+						_cond.Broadcast();
+				}
+				_latch.CountDown();
+			}
+		};
+
+
+		struct Producer
+		{
+			ITaskExecutorPtr		Executor;
+			InFlightLimiter&		Limiter;
+			function<void()>		Task;
+			u64						Count;
+
+			Producer(const ITaskExecutorPtr& executor, InFlightLimiter& limiter, u64 count) :
+				Executor(executor), Limiter(limiter), Task(bind(&InFlightLimiter::Complete, &limiter)), Count(count)
+			{ }
+
+			void Run(const ICancellationToken& token)
+			{
+				for (u64 i = 0; i < Count; ++i)
+				{
+					Limiter.Acquire();
+					Executor->AddTask(Task);
+				}
+			}
+		};
+		STINGRAYKIT_DECLARE_PTR(Producer);
+
+
+		void BenchmarkThroughput(BenchmarkContext& context, const std::string& name, const optional<TimeDuration>& profileTimeout)
+		{
+			for (size_t i = 0; i < ArraySize(ProducerCounts); ++i)
+			{
+				const size_t producerCount = ProducerCounts[i];
+				const u64 tasksPerProducer = context.Iterations(400000 / producerCount);
+				const u64 total = tasksPerProducer * producerCount;
+
+				CompletionLatch latch(total);
+				InFlightLimiter limiter(512, latch);
+				const ITaskExecutorPtr executor = make_shared<ThreadTaskExecutor>("benchThroughput", profileTimeout);
+
+				std::vector<ProducerPtr> producers;
+				for (size_t j = 0; j < producerCount; ++j)
+					producers.push_back(make_shared<Producer>(executor, ref(limiter), tasksPerProducer));
+
+				Stopwatch sw;
+				{
+					std::vector<ThreadPtr> threads;
+					for (size_t j = 0; j < producerCount; ++j)
+						threads.push_back(make_shared<Thread>(StringBuilder() % "benchProducer" % j, bind(&Producer::Run, producers[j], _1)));
+					latch.Wait();
+				}
+				context.Report(BenchmarkResult("executor", name, StringBuilder() % producerCount % "_producers", total, sw.ElapsedNanoseconds()));
+			}
+		}
+
+
+		void BenchmarkTimerArmCancel(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(200000);
+			Timer timer("benchTimer");
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				Token token(timer.SetTimeout(TimeDuration::FromHours(1), &Thread::Yield));
+				DoNotOptimize(token);
+			}
+			context.Report(BenchmarkResult("timer", "arm_cancel", "timeout", iterations, sw.ElapsedNanoseconds()));
+
+			Stopwatch periodicSw;
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				Token token(timer.SetTimer(TimeDuration::FromHours(1), &Thread::Yield));
+				DoNotOptimize(token);
+			}
+			context.Report(BenchmarkResult("timer", "arm_cancel", "periodic", iterations, periodicSw.ElapsedNanoseconds()));
+		}
+
+
+		void BenchmarkTimerArmMany(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(100000);
+			Timer timer("benchTimer");
+
+			std::vector<Token> tokens;
+			tokens.reserve(iterations);
+
+			Stopwatch armSw;
+			for (u64 i = 0; i < iterations; ++i)
+				tokens.push_back(timer.SetTimeout(TimeDuration::FromSeconds(3600 + i % 1000), &Thread::Yield));
+			context.Report(BenchmarkResult("timer", "arm", "pending", iterations, armSw.ElapsedNanoseconds()));
+
+			Stopwatch cancelSw;
+			tokens.clear();
+			context.Report(BenchmarkResult("timer", "cancel", "pending", iterations, cancelSw.ElapsedNanoseconds()));
+		}
+
+
+		void BenchmarkTimerTasks(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(200000);
+			CompletionLatch latch(iterations);
+			Timer timer("benchTimer", null);
+			const function<void()> task(bind(&CompletionLatch::CountDown, &latch));
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				timer.AddTask(task);
+			latch.Wait();
+			context.Report(BenchmarkResult("timer", "add_task_throughput", "1_producers", iterations, sw.ElapsedNanoseconds()));
+		}
+
+	}
+
+
+	void RunExecutorBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkPostToRunLatency(context, "unprofiled", null);
+		BenchmarkPostToRunLatency(context, "profiled", ThreadTaskExecutor::DefaultProfileTimeout);
+		BenchmarkThroughput(context, "throughput_unprofiled", null);
+		BenchmarkThroughput(context, "throughput_profiled", ThreadTaskExecutor::DefaultProfileTimeout);
+	}
+
+
+	void RunTimerBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkTimerArmCancel(context);
+		BenchmarkTimerArmMany(context);
+		BenchmarkTimerTasks(context);
+	}
+
+}}
@@ -0,0 +1,170 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/function/bind.h>
+#include <stingraykit/function/function.h>
+#include <stingraykit/TaskLifeToken.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		void FreeFunction(int value)
+		{ DoNotOptimize(value); }
+
+
+		struct Receiver
+		{
+			int		Sum;
+
+			Receiver() : Sum(0) { }
+
+			void Method(int value)				{ Sum += value; }
+			void TwoArgs(int a, int b)			{ Sum += a + b; }
+		};
+
+
+		void BenchmarkFunctionConstruction(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(1000000);
+			Receiver receiver;
+
+			{
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					function<void(int)> f(&FreeFunction);
+					DoNotOptimize(f);
+				}
+				context.Report(BenchmarkResult("function", "construct", "free_function", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					function<void(int)> f(bind(&Receiver::Method, &receiver, _1));
+					DoNotOptimize(f);
+				}
+				context.Report(BenchmarkResult("function", "construct", "bind_method", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					function<void()> f(bind(&Receiver::TwoArgs, &receiver, 1, 2));
+					DoNotOptimize(f);
+				}
+				context.Report(BenchmarkResult("function", "construct", "bind_all_args", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const function<void(int)> source(bind(&Receiver::Method, &receiver, _1));
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					function<void(int)> f(source);
+					DoNotOptimize(f);
+				}
+				context.Report(BenchmarkResult("function", "copy", "bind_method", iterations, sw.ElapsedNanoseconds()));
+			}
+		}
+
+
+		void BenchmarkFunctionInvocation(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(10000000);
+			Receiver receiver;
+
+			{
+				const function<void(int)> f(&FreeFunction);
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					f((int)i);
+				context.Report(BenchmarkResult("function", "invoke", "free_function", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const function<void(int)> f(bind(&Receiver::Method, &receiver, _1));
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					f((int)i);
+				context.Report(BenchmarkResult("function", "invoke", "bind_method", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			DoNotOptimize(receiver.Sum);
+		}
+
+
+		void BenchmarkTaskLifeToken(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(10000000);
+
+			{
+				const FutureExecutionTester tester(null);
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					LocalExecutionGuard guard(tester);
+					DoNotOptimize(guard);
+				}
+				context.Report(BenchmarkResult("function", "execution_guard", "dummy", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const TaskLifeToken token;
+				const FutureExecutionTester tester(token.GetExecutionTester());
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					LocalExecutionGuard guard(tester);
+					DoNotOptimize(guard);
+				}
+				context.Report(BenchmarkResult("function", "execution_guard", "alive", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const TaskLifeToken token(TaskLifeToken::CreateDeadTaskToken());
+				const FutureExecutionTester tester(token.GetExecutionTester());
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+				{
+					LocalExecutionGuard guard(tester);
+					DoNotOptimize(guard);
+				}
+				context.Report(BenchmarkResult("function", "execution_guard", "dead", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const u64 createIterations = context.Iterations(1000000);
+				Stopwatch sw;
+				for (u64 i = 0; i < createIterations; ++i)
+				{
+					TaskLifeToken token;
+					token.Release();
+				}
+				context.Report(BenchmarkResult("function", "task_life_token", "create_release", createIterations, sw.ElapsedNanoseconds()));
+			}
+		}
+
+	}
+
+
+	void RunFunctionBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkFunctionConstruction(context);
+		BenchmarkFunctionInvocation(context);
+		BenchmarkTaskLifeToken(context);
+	}
+
+}}
@@ -0,0 +1,127 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/collection/IntervalTree.h>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const u32 IntervalCount = 100000;
+		const u32 IntervalTimeline = IntervalCount * 10;
+		const u32 IntervalMaxLength = 100;
+
+
+		/// @brief Something like a recording: starts at some point of the timeline and lasts for a while
+		struct TimeRange
+		{
+			typedef u32 PointType;
+
+			u32		Start;
+			u32		End;
+
+			TimeRange(u32 start, u32 end) : Start(start), End(end) { }
+
+			u32 GetLeft() const		{ return Start; }
+			u32 GetRight() const	{ return End; }
+		};
+
+
+		inline u32 GetPoint(u64 i)
+		{ return (u32)(i * 2654435761u % IntervalTimeline); }
+
+
+		inline TimeRange GetRange(u32 i)
+		{ return TimeRange(GetPoint(i), GetPoint(i) + i % IntervalMaxLength); }
+
+
+		/// @brief The way the stabbing queries were done before IntervalTree
+		template < typename OutputIter >
+		void GetIntersectingLinear(const std::vector<TimeRange>& ranges, u32 point, OutputIter it)
+		{
+			for (std::vector<TimeRange>::const_iterator range = ranges.begin(); range != ranges.end(); ++range)
+				if (range->Start <= point && point < range->End)
+					*it++ = *range;
+		}
+
+	}
+
+
+	void RunIntervalTreeBenchmarks(BenchmarkContext& context)
+	{
+		std::vector<TimeRange> ranges;
+		for (u32 i = 0; i < IntervalCount; ++i)
+			ranges.push_back(GetRange(i));
+
+		IntervalTree<TimeRange> tree;
+		{
+			Stopwatch sw;
+			for (u32 i = 0; i < IntervalCount; ++i)
+				tree.insert(ranges[i]);
+			context.Report(BenchmarkResult("interval", "insert", "tree", IntervalCount, sw.ElapsedNanoseconds()));
+		}
+
+		{
+			std::vector<TimeRange> sorted(tree.begin(), tree.end());
+			Stopwatch sw;
+			IntervalTree<TimeRange> built(sorted.begin(), sorted.end());
+			context.Report(BenchmarkResult("interval", "build_sorted", "tree", IntervalCount, sw.ElapsedNanoseconds()));
+			DoNotOptimize(built);
+		}
+
+		std::vector<TimeRange> found;
+		{
+			const u64 queries = context.Iterations(1000);
+			Stopwatch sw;
+			for (u64 i = 0; i < queries; ++i)
+			{
+				found.clear();
+				GetIntersectingLinear(ranges, GetPoint(i * 7919), std::back_inserter(found));
+				DoNotOptimize(found);
+			}
+			context.Report(BenchmarkResult("interval", "stab", "linear", queries, sw.ElapsedNanoseconds()));
+		}
+
+		{
+			const u64 queries = context.Iterations(1000000);
+			Stopwatch sw;
+			for (u64 i = 0; i < queries; ++i)
+			{
+				found.clear();
+				tree.get_intersecting(GetPoint(i * 7919), std::back_inserter(found));
+				DoNotOptimize(found);
+			}
+			context.Report(BenchmarkResult("interval", "stab", "tree", queries, sw.ElapsedNanoseconds()));
+		}
+
+		{
+			const u64 queries = context.Iterations(1000000);
+			Stopwatch sw;
+			for (u64 i = 0; i < queries; ++i)
+			{
+				const u32 point = GetPoint(i * 7919);
+				found.clear();
+				tree.get_intersecting(point, point + IntervalMaxLength * 10, std::back_inserter(found));
+				DoNotOptimize(found);
+			}
+			context.Report(BenchmarkResult("interval", "overlap", "tree", queries, sw.ElapsedNanoseconds()));
+		}
+
+		{
+			Stopwatch sw;
+			while (tree.size() != 0)
+				tree.erase(tree.begin());
+			context.Report(BenchmarkResult("interval", "erase", "tree", IntervalCount, sw.ElapsedNanoseconds()));
+		}
+	}
+
+}}
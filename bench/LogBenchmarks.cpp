@@ -0,0 +1,179 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/log/Logger.h>
+#ifdef PLATFORM_POSIX
+#	include <stingraykit/log/posix/FileLoggerSink.h>
+#	include <unistd.h>
+#endif
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		struct NullSink : public ILoggerSink
+		{
+			u64		Count;
+			u64		Size;
+
+			NullSink() : Count(0), Size(0) { }
+
+			virtual void Log(const LoggerMessage& message)
+			{
+				++Count;
+				Size += message.GetMessage().size();
+			}
+		};
+		STINGRAYKIT_DECLARE_PTR(NullSink);
+
+
+		struct BenchLogger
+		{
+			static NamedLogger	s_logger;
+		};
+		STINGRAYKIT_DEFINE_NAMED_LOGGER(BenchLogger, "benchLogger");
+
+
+		void BenchmarkDisabled(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(10000000);
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				BenchLogger::s_logger.Trace() << "disabled message " << i;
+			context.Report(BenchmarkResult("log", "statement", "disabled", iterations, sw.ElapsedNanoseconds()));
+
+			Stopwatch macroSw;
+			for (u64 i = 0; i < iterations; ++i)
+				STINGRAYKIT_LOG(BenchLogger::s_logger, Trace) << "disabled message " << i;
+			context.Report(BenchmarkResult("log", "statement", "disabled_macro", iterations, macroSw.ElapsedNanoseconds()));
+		}
+
+
+		void BenchmarkEnabled(BenchmarkContext& context, const std::string& param)
+		{
+			const u64 iterations = context.Iterations(200000);
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				BenchLogger::s_logger.Info() << "enabled message " << i << " of " << iterations;
+			const u64 elapsed = sw.ElapsedNanoseconds();
+
+			context.Report(BenchmarkResult("log", "statement", param, iterations, elapsed));
+		}
+
+
+		void BenchmarkAsync(BenchmarkContext& context, LogOverflowPolicy overflowPolicy, bool deferFormatting)
+		{
+			const u64 iterations = context.Iterations(200000);
+			const Token asyncToken(Logger::EnableAsyncMode(65536, overflowPolicy, deferFormatting));
+			const std::string param = StringBuilder() % "async_" % overflowPolicy % (deferFormatting ? "_deferred" : "");
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				BenchLogger::s_logger.Info() << "enabled message " << i << " of " << iterations;
+			const u64 elapsed = sw.ElapsedNanoseconds();
+			Logger::Flush();
+			const u64 flushed = sw.ElapsedNanoseconds();
+
+			context.Report(BenchmarkResult("log", "statement", param, iterations, elapsed));
+			context.Report(BenchmarkResult("log", "async_delivery", param, iterations, flushed));
+		}
+
+		void BenchmarkRateLimited(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(10000000);
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				STINGRAYKIT_LOG_RATE_LIMITED(BenchLogger::s_logger, Info, 10, 10) << "rate limited message " << i;
+			context.Report(BenchmarkResult("log", "statement", "rate_limited", iterations, sw.ElapsedNanoseconds()));
+		}
+
+
+		void BenchmarkToString(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(1000000);
+			const LoggerMessage message("benchLogger", LogLevel::Info, "formatted message", false);
+
+			u64 size = 0;
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				size += message.ToString().size();
+			context.Report(BenchmarkResult("log", "format", "message_to_string", iterations, sw.ElapsedNanoseconds()));
+			DoNotOptimize(size);
+		}
+
+		void BenchmarkFlightRecorder(BenchmarkContext& context)
+		{
+			// the recorder can't be disabled, so it must be the last log benchmark
+			FlightRecorder::Enable(64, 256, 200, LogLevel::Trace, false);
+
+			const u64 iterations = context.Iterations(1000000);
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+				STINGRAYKIT_LOG(BenchLogger::s_logger, Trace) << "recorded message " << i << " of " << iterations;
+			context.Report(BenchmarkResult("log", "statement", "flight_recorder", iterations, sw.ElapsedNanoseconds()));
+		}
+
+#ifdef PLATFORM_POSIX
+		void BenchmarkFileSink(BenchmarkContext& context)
+		{
+			const std::string path = StringBuilder() % "/tmp/stingraykit_bench_" % getpid() % ".log";
+			const u64 iterations = context.Iterations(200000);
+
+			{
+				const Token sinkToken(Logger::AddSink(make_shared<posix::FileLoggerSink>(path, 64 * 1024 * 1024)));
+				const Token asyncToken(Logger::EnableAsyncMode(65536, LogOverflowPolicy::Block));
+
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					BenchLogger::s_logger.Info() << "enabled message " << i << " of " << iterations;
+				const u64 elapsed = sw.ElapsedNanoseconds();
+				Logger::Flush();
+				const u64 flushed = sw.ElapsedNanoseconds();
+
+				context.Report(BenchmarkResult("log", "statement", "file_async", iterations, elapsed));
+				context.Report(BenchmarkResult("log", "async_delivery", "file_async", iterations, flushed));
+			}
+
+			unlink(path.c_str());
+			unlink((path + ".1").c_str());
+		}
+#endif
+
+	}
+
+
+	void RunLogBenchmarks(BenchmarkContext& context)
+	{
+		const NullSinkPtr sink = make_shared<NullSink>();
+		const Token sinkToken(Logger::AddSink(sink));
+
+		BenchmarkDisabled(context);
+		BenchmarkEnabled(context, "sync");
+		BenchmarkRateLimited(context);
+		BenchmarkToString(context);
+		BenchmarkAsync(context, LogOverflowPolicy::Block, false);
+		BenchmarkAsync(context, LogOverflowPolicy::CountDrops, false);
+		BenchmarkAsync(context, LogOverflowPolicy::Block, true);
+#ifdef PLATFORM_POSIX
+		BenchmarkFileSink(context);
+#endif
+		BenchmarkFlightRecorder(context);
+
+		DoNotOptimize(sink->Count);
+		DoNotOptimize(sink->Size);
+	}
+
+}}
@@ -0,0 +1,142 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/collection/btree_map.h>
+#include <stingraykit/collection/btree_set.h>
+#include <stingraykit/collection/flat_set.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const u32 OrderedSize = 1000000;
+		const u32 FlatSize = 100000;
+
+
+		/// @brief Spreads the keys over the whole u32 range, so that they are neither sequential nor sorted
+		inline u32 GetKey(u32 i)
+		{ return i * 2654435761u; }
+
+
+		template < typename Set_ >
+		void Insert(Set_& set, u32 key)
+		{ set.insert(key); }
+
+		template < typename K, typename V, typename C, typename A >
+		void Insert(std::map<K, V, C, A>& map, u32 key)
+		{ map.insert(std::make_pair(key, key)); }
+
+		template < typename K, typename V, typename C, typename A >
+		void Insert(btree_map<K, V, C, A>& map, u32 key)
+		{ map.insert(std::make_pair(key, key)); }
+
+
+		template < typename Container_ >
+		void BenchmarkOrdered(BenchmarkContext& context, const std::string& name)
+		{
+			Container_ container;
+			{
+				Stopwatch sw;
+				for (u32 i = 0; i < OrderedSize; ++i)
+					Insert(container, GetKey(i));
+				context.Report(BenchmarkResult("ordered", name, "insert", OrderedSize, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const u64 iterations = context.Iterations(2000000);
+				size_t found = 0;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					found += container.count(GetKey((u32)(i * 7919 % OrderedSize)));
+				DoNotOptimize(found);
+				context.Report(BenchmarkResult("ordered", name, "find_hit", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				size_t count = 0;
+				Stopwatch sw;
+				for (typename Container_::const_iterator it = container.begin(); it != container.end(); ++it)
+					++count;
+				DoNotOptimize(count);
+				context.Report(BenchmarkResult("ordered", name, "iterate", OrderedSize, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				Stopwatch sw;
+				for (u32 i = 0; i < OrderedSize; ++i)
+					container.erase(GetKey(i));
+				context.Report(BenchmarkResult("ordered", name, "erase", OrderedSize, sw.ElapsedNanoseconds()));
+			}
+		}
+
+
+		/// @brief One by one insertion into a flat_set moves the tail on every value, so it is compared with the bulk construction on a smaller size
+		void BenchmarkFlat(BenchmarkContext& context)
+		{
+			std::vector<u32> keys;
+			for (u32 i = 0; i < FlatSize; ++i)
+				keys.push_back(GetKey(i));
+
+			{
+				flat_set<u32> set;
+				Stopwatch sw;
+				for (u32 i = 0; i < FlatSize; ++i)
+					set.insert(keys[i]);
+				context.Report(BenchmarkResult("ordered", "flat_set", "insert", FlatSize, sw.ElapsedNanoseconds()));
+			}
+
+			flat_set<u32> set;
+			{
+				Stopwatch sw;
+				flat_set<u32> built(keys.begin(), keys.end());
+				context.Report(BenchmarkResult("ordered", "flat_set", "build", FlatSize, sw.ElapsedNanoseconds()));
+				set.swap(built);
+			}
+
+			const std::vector<u32> sorted(set.begin(), set.end());
+			const u64 iterations = context.Iterations(2000000);
+			{
+				size_t found = 0;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					found += std::binary_search(sorted.begin(), sorted.end(), GetKey((u32)(i * 7919 % FlatSize)));
+				DoNotOptimize(found);
+				context.Report(BenchmarkResult("ordered", "vector", "binary_search", iterations, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				size_t found = 0;
+				Stopwatch sw;
+				for (u64 i = 0; i < iterations; ++i)
+					found += set.count(GetKey((u32)(i * 7919 % FlatSize)));
+				DoNotOptimize(found);
+				context.Report(BenchmarkResult("ordered", "flat_set", "find_hit", iterations, sw.ElapsedNanoseconds()));
+			}
+		}
+
+	}
+
+
+	void RunOrderedBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkOrdered<std::set<u32> >(context, "set");
+		BenchmarkOrdered<btree_set<u32> >(context, "btree_set");
+		BenchmarkOrdered<std::map<u32, u32> >(context, "map");
+		BenchmarkOrdered<btree_map<u32, u32> >(context, "btree_map");
+		BenchmarkFlat(context);
+	}
+
+}}
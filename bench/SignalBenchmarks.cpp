@@ -0,0 +1,174 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/function/bind.h>
+#include <stingraykit/signal/signals.h>
+#include <stingraykit/string/ToString.h>
+#include <stingraykit/thread/ThreadTaskExecutor.h>
+
+#include <algorithm>
+
+namespace stingray {
+namespace bench
+{
+
+	namespace
+	{
+
+		const size_t SlotCounts[] = { 1, 16, 256 };
+
+
+		struct Counter
+		{
+			u64		Value;
+
+			Counter() : Value(0) { }
+
+			void Add(int value)					{ Value += value; }
+		};
+
+
+		struct LatchCounter
+		{
+			CompletionLatch&	Latch;
+
+			explicit LatchCounter(CompletionLatch& latch) : Latch(latch) { }
+
+			void Add(int value)					{ Latch.CountDown(); }
+		};
+
+
+		template < typename SignalType >
+		void BenchmarkSyncEmit(BenchmarkContext& context, const std::string& name)
+		{
+			for (size_t i = 0; i < ArraySize(SlotCounts); ++i)
+			{
+				const size_t slots = SlotCounts[i];
+				const u64 emits = context.Iterations(2000000 / slots + 1000);
+
+				SignalType signal;
+				Counter counter;
+				std::vector<Token> connections;
+				for (size_t j = 0; j < slots; ++j)
+					connections.push_back(signal.connect(bind(&Counter::Add, &counter, _1)));
+
+				Stopwatch sw;
+				for (u64 j = 0; j < emits; ++j)
+					signal(1);
+				const u64 elapsed = sw.ElapsedNanoseconds();
+
+				DoNotOptimize(counter.Value);
+				context.Report(BenchmarkResult("signal", name, StringBuilder() % slots % "_slots", emits, elapsed));
+			}
+		}
+
+
+		void BenchmarkAsyncEmit(BenchmarkContext& context)
+		{
+			const ITaskExecutorPtr worker = make_shared<ThreadTaskExecutor>("benchSignal", null);
+
+			for (size_t i = 0; i < ArraySize(SlotCounts); ++i)
+			{
+				const size_t slots = SlotCounts[i];
+				const u64 emits = context.Iterations(200000 / slots + 100);
+
+				// emitting in batches keeps the executor queue below its overflow report threshold
+				const u64 batch = 512 / slots;
+
+				signal<void(int)> signal;
+				CompletionLatch latch(0);
+				LatchCounter counter(latch);
+				std::vector<Token> connections;
+				for (size_t j = 0; j < slots; ++j)
+					connections.push_back(signal.connect(worker, bind(&LatchCounter::Add, &counter, _1)));
+
+				u64 emitElapsed = 0;
+				Stopwatch sw;
+				for (u64 j = 0; j < emits; j += batch)
+				{
+					const u64 count = std::min(batch, emits - j);
+					latch.Reset(count * slots);
+
+					Stopwatch emitSw;
+					for (u64 k = 0; k < count; ++k)
+						signal(1);
+					emitElapsed += emitSw.ElapsedNanoseconds();
+
+					latch.Wait();
+				}
+				const u64 deliveryElapsed = sw.ElapsedNanoseconds();
+
+				context.Report(BenchmarkResult("signal", "emit_async", StringBuilder() % slots % "_slots", emits, emitElapsed));
+				context.Report(BenchmarkResult("signal", "deliver_async", StringBuilder() % slots % "_slots", emits * slots, deliveryElapsed));
+			}
+		}
+
+
+		void BenchmarkConnect(BenchmarkContext& context)
+		{
+			const u64 iterations = context.Iterations(200000);
+
+			signal<void(int)> signal;
+			Counter counter;
+
+			Stopwatch sw;
+			for (u64 i = 0; i < iterations; ++i)
+			{
+				Token connection(signal.connect(bind(&Counter::Add, &counter, _1)));
+				DoNotOptimize(connection);
+			}
+			context.Report(BenchmarkResult("signal", "connect_disconnect", "sync", iterations, sw.ElapsedNanoseconds()));
+		}
+
+
+		void BenchmarkBulkConnect(BenchmarkContext& context)
+		{
+			const size_t slots = 256;
+			const u64 rounds = context.Iterations(2000);
+
+			signal<void(int)> signal;
+			Counter counter;
+			const function<void(int)> slot(bind(&Counter::Add, &counter, _1));
+
+			{
+				Stopwatch sw;
+				for (u64 i = 0; i < rounds; ++i)
+				{
+					TokenPool pool;
+					for (size_t j = 0; j < slots; ++j)
+						pool += signal.connect(slot);
+				}
+				context.Report(BenchmarkResult("signal", "bulk_connect_disconnect", "token_pool", rounds * slots, sw.ElapsedNanoseconds()));
+			}
+
+			{
+				const std::vector<function<void(int)> > batch(slots, slot);
+				Stopwatch sw;
+				for (u64 i = 0; i < rounds; ++i)
+				{
+					Token connection(signal.connect(batch));
+					DoNotOptimize(connection);
+				}
+				context.Report(BenchmarkResult("signal", "bulk_connect_disconnect", "batch", rounds * slots, sw.ElapsedNanoseconds()));
+			}
+		}
+
+	}
+
+
+	void RunSignalBenchmarks(BenchmarkContext& context)
+	{
+		BenchmarkSyncEmit<signal<void(int)> >(context, "emit_sync");
+		BenchmarkSyncEmit<signal<void(int), signal_policies::threading::Threadless> >(context, "emit_threadless");
+		BenchmarkAsyncEmit(context);
+		BenchmarkConnect(context);
+		BenchmarkBulkConnect(context);
+	}
+
+}}
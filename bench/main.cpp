@@ -0,0 +1,97 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/Benchmark.h>
+
+#include <stingraykit/exception.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace stingray;
+using namespace stingray::bench;
+
+namespace
+{
+
+	void PrintUsage(const char* argv0)
+	{
+		fprintf(stderr,
+				"Usage: %s [--format csv|json] [--output <file>] [--filter <group>] [--scale <factor>]\n"
+				"  --format   machine-readable report format written to the output (default: csv)\n"
+				"  --output   report file, stdout if omitted; human-readable progress always goes to stderr\n"
+				"  --filter   run only the groups whose name contains the given substring\n"
+				"  --scale    iteration count multiplier (default: 1.0)\n", argv0);
+	}
+
+}
+
+
+int main(int argc, char* argv[])
+{
+	ReportFormat format = ReportFormat::Csv;
+	std::string output;
+	std::string filter;
+	double scale = 1.0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--format") == 0 && hasValue && strcmp(argv[i + 1], "csv") == 0)
+			format = ReportFormat::Csv, ++i;
+		else if (strcmp(argv[i], "--format") == 0 && hasValue && strcmp(argv[i + 1], "json") == 0)
+			format = ReportFormat::Json, ++i;
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+			output = argv[++i];
+		else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+			filter = argv[++i];
+		else if (strcmp(argv[i], "--scale") == 0 && hasValue)
+			scale = atof(argv[++i]);
+		else
+		{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	try
+	{
+		BenchmarkContext context(filter, scale);
+
+		if (context.IsEnabled("function"))
+			RunFunctionBenchmarks(context);
+		if (context.IsEnabled("signal"))
+			RunSignalBenchmarks(context);
+		if (context.IsEnabled("executor"))
+			RunExecutorBenchmarks(context);
+		if (context.IsEnabled("timer"))
+			RunTimerBenchmarks(context);
+		if (context.IsEnabled("log"))
+			RunLogBenchmarks(context);
+		if (context.IsEnabled("cache"))
+			RunCacheBenchmarks(context);
+		if (context.IsEnabled("dictionary"))
+			RunDictionaryBenchmarks(context);
+		if (context.IsEnabled("ordered"))
+			RunOrderedBenchmarks(context);
+		if (context.IsEnabled("interval"))
+			RunIntervalTreeBenchmarks(context);
+
+		FILE* out = output.empty() ? stdout : fopen(output.c_str(), "w");
+		STINGRAYKIT_CHECK(out, "Can't open " + output);
+		context.Write(out, format);
+		if (out != stdout)
+			fclose(out);
+	}
+	catch (const std::exception& ex)
+	{
+		fprintf(stderr, "Benchmark failed: %s\n", diagnostic_information(ex).c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -29,7 +29,7 @@ namespace stingray
 		struct FailImpl
 		{
 			static Dst GetValue(Src from)
-			{ STINGRAYKIT_THROW(StringBuilder() % "Mapping " % Demangle(typeid(Src).name()) % " -> " % Demangle(typeid(Dst).name()) % " failed! Source value: " % ToString(from)); }
+			{ STINGRAYKIT_THROW(StringBuilder() % "Mapping " % Demangle(typeid(Src)) % " -> " % Demangle(typeid(Dst)) % " failed! Source value: " % ToString(from)); }
 			static bool HasValue(Src from)	{ return false; }
 		};
 
@@ -37,7 +37,7 @@ namespace stingray
 		struct FailImpl<Src, Dst, false>
 		{
 			static Dst GetValue(Src from)
-			{ STINGRAYKIT_THROW(StringBuilder() % "Mapping " % Demangle(typeid(Src).name()) % " -> " % Demangle(typeid(Dst).name()) % " failed! Source value is not string representable!"); }
+			{ STINGRAYKIT_THROW(StringBuilder() % "Mapping " % Demangle(typeid(Src)) % " -> " % Demangle(typeid(Dst)) % " failed! Source value is not string representable!"); }
 			static bool HasValue(Src from)	{ return false; }
 		};
 
@@ -0,0 +1,87 @@
+#ifndef STINGRAYKIT_POOLEDALLOCATOR_H
+#define STINGRAYKIT_POOLEDALLOCATOR_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/metaprogramming/CompileTimeAssert.h>
+#include <stingraykit/thread/atomic/AtomicFlag.h>
+#include <stingraykit/thread/atomic/Spinlock.h>
+
+#include <new>
+
+#include <stddef.h>
+
+namespace stingray
+{
+
+	/**
+	 * @brief Bounded free list of fixed-size blocks, meant to back class-specific operator new/delete of small frequently recreated objects
+	 * @par Blocks of any other size (e.g. of derived classes) are forwarded to the global operator new/delete
+	 */
+	template < size_t BlockSize_, size_t MaxFreeBlocks_ = 256 >
+	class PooledAllocator
+	{
+		struct FreeBlock
+		{
+			FreeBlock*		Next;
+		};
+
+	private:
+		static AtomicFlag::Type		s_lock;
+		static FreeBlock*			s_freeList;
+		static size_t				s_freeCount;
+
+	public:
+		static void* Allocate(size_t size)
+		{
+			CompileTimeAssert<(BlockSize_ >= sizeof(FreeBlock))>();
+
+			if (size == BlockSize_)
+			{
+				Spinlock l(s_lock);
+				if (s_freeList)
+				{
+					FreeBlock* const block = s_freeList;
+					s_freeList = block->Next;
+					--s_freeCount;
+					return block;
+				}
+			}
+
+			return ::operator new(size);
+		}
+
+		static void Deallocate(void* ptr, size_t size)
+		{
+			if (!ptr)
+				return;
+
+			if (size == BlockSize_)
+			{
+				Spinlock l(s_lock);
+				if (s_freeCount < MaxFreeBlocks_)
+				{
+					FreeBlock* const block = static_cast<FreeBlock*>(ptr);
+					block->Next = s_freeList;
+					s_freeList = block;
+					++s_freeCount;
+					return;
+				}
+			}
+
+			::operator delete(ptr);
+		}
+	};
+
+	template < size_t BlockSize_, size_t MaxFreeBlocks_ > AtomicFlag::Type PooledAllocator<BlockSize_, MaxFreeBlocks_>::s_lock = 0;
+	template < size_t BlockSize_, size_t MaxFreeBlocks_ > typename PooledAllocator<BlockSize_, MaxFreeBlocks_>::FreeBlock* PooledAllocator<BlockSize_, MaxFreeBlocks_>::s_freeList = NULL;
+	template < size_t BlockSize_, size_t MaxFreeBlocks_ > size_t PooledAllocator<BlockSize_, MaxFreeBlocks_>::s_freeCount = 0;
+
+}
+
+#endif
@@ -55,13 +55,13 @@ namespace stingray
 			try
 			{ ptr.reset(new InstanceHolderType()); }
 			catch(const std::exception& ex)
-			{ Logger::Error() << "An exception in " << Demangle(typeid(T).name()) << " singleton constructor: " << ex; }
+			{ Logger::Error() << "An exception in " << Demangle(typeid(T)) << " singleton constructor: " << ex; }
 			ptr.swap(GetInstancePtr());
 		}
 
 		static void AssertInstance()
 		{
-			STINGRAYKIT_FATAL("Singleton '" + Demangle(typeid(T).name()) + "' has not been created!");
+			STINGRAYKIT_FATAL("Singleton '" + Demangle(typeid(T)) + "' has not been created!");
 		}
 
 		static InstanceHolderTypePtr& GetInstancePtr()
@@ -79,7 +79,7 @@ namespace stingray
 		{
 			call_once(s_initFlag, &Singleton::InitInstance);
 			if (!GetInstancePtr())
-				STINGRAYKIT_THROW("Singleton '" + Demangle(typeid(T).name()) + "' could not be created!");
+				STINGRAYKIT_THROW("Singleton '" + Demangle(typeid(T)) + "' could not be created!");
 			return GetInstancePtr()->Get();
 		}
 
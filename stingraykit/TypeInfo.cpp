@@ -14,7 +14,7 @@ namespace stingray
 
 	std::string TypeInfo::GetName() const
 	{
-		return Demangle(GetRawName());
+		return Demangle(*_info);
 	}
 
 
@@ -128,7 +128,7 @@ namespace stingray
 		case Type::Object:
 		case Type::SerializableObject:
 			{
-				STINGRAYKIT_CHECK(_data.Object->IsSerializable(), "'any' object (" + Demangle(typeid(*_data.Object).name()) + ") is not a serializable one!");
+				STINGRAYKIT_CHECK(_data.Object->IsSerializable(), "'any' object (" + Demangle(typeid(*_data.Object)) + ") is not a serializable one!");
 				std::string classname(_data.Object->GetClassName());
 				ar.Serialize(".class", classname);
 				_data.Object->Serialize(ar);
@@ -311,7 +311,7 @@ namespace stingray
 	{
 		T* ptr = operand.template Get<T>();
 		if (!ptr)
-			STINGRAYKIT_THROW(bad_any_cast(operand._type.ToString(), Demangle(typeid(T).name())));
+			STINGRAYKIT_THROW(bad_any_cast(operand._type.ToString(), Demangle(typeid(T))));
 		return *ptr;
 	}
 
@@ -320,7 +320,7 @@ namespace stingray
 	{
 		const T* ptr = operand.template Get<T>();
 		if (!ptr)
-			STINGRAYKIT_THROW(bad_any_cast(operand._type.ToString(), Demangle(typeid(T).name())));
+			STINGRAYKIT_THROW(bad_any_cast(operand._type.ToString(), Demangle(typeid(T))));
 		return *ptr;
 	}
 
@@ -0,0 +1,699 @@
+#ifndef STINGRAYKIT_COLLECTION_BTREE_H
+#define STINGRAYKIT_COLLECTION_BTREE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/aligned_storage.h>
+#include <stingraykit/exception.h>
+
+#include <algorithm>
+#include <new>
+
+namespace stingray
+{
+
+	namespace Detail
+	{
+
+		/**
+		 * @brief B+tree with the nodes of a few cache lines, the base of btree_set, btree_multiset and btree_map
+		 * @par The values are stored in the leaves only, dozens per node, so a lookup touches a node per level and the iteration
+		 * goes through contiguous arrays. The nodes keep their parent and their index in it, so the iteration and the erasing by position
+		 * take amortized O(1) and O(log n), and the equal keys of the multi variant are kept in the insertion order.
+		 * @par The separator keys of the inner nodes satisfy: every key of child i <= key i <= every key of child i + 1.
+		 * Any insert or erase invalidates all the positions, the values are moved within and between the nodes.
+		 */
+		template < typename Key_, typename Value_, typename KeyOfValue_, typename Compare_, typename Allocator_, bool Multi_ >
+		class BTree
+		{
+			static const size_t CacheLineSize = 64;
+			static const size_t NodeBytes = 4 * CacheLineSize;
+
+			struct Inner;
+
+			struct Node
+			{
+				Inner*		Parent;
+				u16			Index; // in the parent
+				u16			Count; // values in a leaf, children in an inner node
+				bool		IsLeaf;
+
+				explicit Node(bool isLeaf) : Parent(), Index(), Count(), IsLeaf(isLeaf) { }
+			};
+
+		public:
+			static const size_t LeafCapacity = (NodeBytes - sizeof(Node)) / sizeof(Value_) > 4 ? (NodeBytes - sizeof(Node)) / sizeof(Value_) : 4;
+			static const size_t InnerCapacity = (NodeBytes - sizeof(Node) + sizeof(Key_)) / (sizeof(Key_) + sizeof(Node*)) > 4 ?
+					(NodeBytes - sizeof(Node) + sizeof(Key_)) / (sizeof(Key_) + sizeof(Node*)) : 4;
+
+		private:
+			static const size_t LeafMinCount = LeafCapacity / 2;
+			static const size_t InnerMinCount = InnerCapacity / 2;
+
+			struct Leaf : public Node
+			{
+				StorageFor<Value_>	Values[LeafCapacity];
+
+				Leaf() : Node(true) { }
+			};
+
+			struct Inner : public Node
+			{
+				StorageFor<Key_>	Keys[InnerCapacity - 1];
+				Node*				Children[InnerCapacity];
+
+				Inner() : Node(false) { }
+			};
+
+			typedef typename Allocator_::template rebind<Leaf>::other	LeafAllocator;
+			typedef typename Allocator_::template rebind<Inner>::other	InnerAllocator;
+
+		public:
+			struct Position
+			{
+				Leaf*		LeafNode;
+				size_t		Index;
+
+				Position() : LeafNode(), Index() { }
+				Position(Leaf* leaf, size_t index) : LeafNode(leaf), Index(index) { }
+
+				bool operator == (const Position& other) const	{ return LeafNode == other.LeafNode && Index == other.Index; }
+				bool operator != (const Position& other) const	{ return !(*this == other); }
+			};
+
+		private:
+			Node*					_root;
+			size_t					_size;
+			Compare_				_cmp;
+			KeyOfValue_				_keyOf;
+			LeafAllocator			_leafAllocator;
+			InnerAllocator			_innerAllocator;
+
+		public:
+			BTree(const Compare_& cmp, const Allocator_& alloc)
+				: _root(), _size(), _cmp(cmp), _leafAllocator(alloc), _innerAllocator(alloc)
+			{ }
+
+			BTree(const BTree& other)
+				: _root(), _size(other._size), _cmp(other._cmp), _leafAllocator(other._leafAllocator), _innerAllocator(other._innerAllocator)
+			{
+				if (other._root)
+					_root = Clone(other._root);
+			}
+
+			~BTree()
+			{ Clear(); }
+
+			BTree& operator = (const BTree& other)
+			{
+				BTree copy(other);
+				Swap(copy);
+				return *this;
+			}
+
+			void Swap(BTree& other)
+			{
+				std::swap(_root, other._root);
+				std::swap(_size, other._size);
+				std::swap(_cmp, other._cmp);
+				std::swap(_leafAllocator, other._leafAllocator);
+				std::swap(_innerAllocator, other._innerAllocator);
+			}
+
+			size_t GetSize() const				{ return _size; }
+			const Compare_& GetCompare() const	{ return _cmp; }
+			Allocator_ GetAllocator() const		{ return Allocator_(_leafAllocator); }
+
+			void Clear()
+			{
+				if (_root)
+					DeleteNode(_root);
+				_root = NULL;
+				_size = 0;
+			}
+
+			Position Begin() const
+			{
+				if (!_root)
+					return Position();
+				return Position(GetLeftmostLeaf(_root), 0);
+			}
+
+			Position End() const
+			{ return Position(); }
+
+			static Position Next(const Position& position)
+			{
+				if (position.Index + 1 < position.LeafNode->Count)
+					return Position(position.LeafNode, position.Index + 1);
+				return GetNextLeafBegin(position.LeafNode);
+			}
+
+			Position Prev(const Position& position) const
+			{
+				if (!position.LeafNode)
+				{
+					STINGRAYKIT_CHECK(_root, "Iterator is out of range!");
+					Leaf* const leaf = GetRightmostLeaf(_root);
+					return Position(leaf, leaf->Count - 1);
+				}
+
+				if (position.Index != 0)
+					return Position(position.LeafNode, position.Index - 1);
+
+				Node* node = position.LeafNode;
+				while (node->Parent && node->Index == 0)
+					node = node->Parent;
+
+				STINGRAYKIT_CHECK(node->Parent, "Iterator is out of range!");
+				Leaf* const leaf = GetRightmostLeaf(node->Parent->Children[node->Index - 1]);
+				return Position(leaf, leaf->Count - 1);
+			}
+
+			static const Value_& GetValue(const Position& position)
+			{ return position.LeafNode->Values[position.Index].Ref(); }
+
+			static Value_& GetMutableValue(const Position& position)
+			{ return position.LeafNode->Values[position.Index].Ref(); }
+
+			Position Find(const Key_& key) const
+			{
+				const Position result = LowerBound(key);
+				return result.LeafNode && !_cmp(key, GetKey(result.LeafNode, result.Index)) ? result : Position();
+			}
+
+			Position LowerBound(const Key_& key) const
+			{ return Normalize(FindLeafPosition(key, false)); }
+
+			Position UpperBound(const Key_& key) const
+			{ return Normalize(FindLeafPosition(key, true)); }
+
+			/// @brief Inserts the value unless there is an equal one, the equal keys are inserted after the existing ones in the multi variant
+			std::pair<Position, bool> Insert(const Value_& value)
+			{
+				const Key_& key = _keyOf(value);
+				const Position position = FindLeafPosition(key, Multi_);
+
+				if (!Multi_)
+				{
+					const Position existing = Normalize(position);
+					if (existing.LeafNode && !_cmp(key, GetKey(existing.LeafNode, existing.Index)))
+						return std::make_pair(existing, false);
+				}
+
+				return std::make_pair(InsertAt(position, value), true);
+			}
+
+			/// @brief Returns the position of the next value
+			Position Erase(const Position& position)
+			{
+				Leaf* leaf = position.LeafNode;
+				size_t index = position.Index;
+
+				leaf->Values[index].Dtor();
+				ShiftLeft(leaf->Values, index, leaf->Count);
+				--leaf->Count;
+				--_size;
+
+				if (leaf == _root)
+				{
+					if (leaf->Count != 0)
+						return Normalize(Position(leaf, index));
+
+					DeleteNode(leaf);
+					_root = NULL;
+					return Position();
+				}
+
+				if (leaf->Count < LeafMinCount)
+					FillLeaf(leaf, index);
+
+				return Normalize(Position(leaf, index));
+			}
+
+		private:
+			const Key_& GetKey(const Leaf* leaf, size_t index) const
+			{ return _keyOf(leaf->Values[index].Ref()); }
+
+			/// @brief Returns the position to insert the key at, it may be past the end of the leaf
+			Position FindLeafPosition(const Key_& key, bool upper) const
+			{
+				Node* node = _root;
+				if (!node)
+					return Position();
+
+				while (!node->IsLeaf)
+				{
+					const Inner* const inner = static_cast<const Inner*>(node);
+					size_t begin = 0, end = inner->Count - 1;
+					while (begin < end)
+					{
+						const size_t middle = (begin + end) / 2;
+						if (upper ? _cmp(key, inner->Keys[middle].Ref()) : !_cmp(inner->Keys[middle].Ref(), key))
+							end = middle;
+						else
+							begin = middle + 1;
+					}
+					node = inner->Children[begin];
+				}
+
+				Leaf* const leaf = static_cast<Leaf*>(node);
+				size_t begin = 0, end = leaf->Count;
+				while (begin < end)
+				{
+					const size_t middle = (begin + end) / 2;
+					if (upper ? _cmp(key, GetKey(leaf, middle)) : !_cmp(GetKey(leaf, middle), key))
+						end = middle;
+					else
+						begin = middle + 1;
+				}
+				return Position(leaf, begin);
+			}
+
+			static Position Normalize(const Position& position)
+			{ return position.LeafNode && position.Index == position.LeafNode->Count ? GetNextLeafBegin(position.LeafNode) : position; }
+
+			static Position GetNextLeafBegin(Node* node)
+			{
+				while (node->Parent && node->Index + 1 == node->Parent->Count)
+					node = node->Parent;
+
+				if (!node->Parent)
+					return Position();
+				return Position(GetLeftmostLeaf(node->Parent->Children[node->Index + 1]), 0);
+			}
+
+			static Leaf* GetLeftmostLeaf(Node* node)
+			{
+				while (!node->IsLeaf)
+					node = static_cast<Inner*>(node)->Children[0];
+				return static_cast<Leaf*>(node);
+			}
+
+			static Leaf* GetRightmostLeaf(Node* node)
+			{
+				while (!node->IsLeaf)
+					node = static_cast<Inner*>(node)->Children[node->Count - 1];
+				return static_cast<Leaf*>(node);
+			}
+
+			Position InsertAt(Position position, const Value_& value)
+			{
+				if (!_root)
+				{
+					_root = NewLeaf();
+					position = Position(static_cast<Leaf*>(_root), 0);
+				}
+
+				Leaf* leaf = position.LeafNode;
+				size_t index = position.Index;
+				if (leaf->Count == LeafCapacity)
+				{
+					Leaf* const right = SplitLeaf(leaf);
+					if (index > leaf->Count)
+					{
+						index -= leaf->Count;
+						leaf = right;
+					}
+				}
+
+				ShiftRight(leaf->Values, index, leaf->Count);
+				try
+				{ leaf->Values[index].Ctor(value); }
+				catch (...)
+				{
+					ShiftLeft(leaf->Values, index, leaf->Count + 1);
+					if (leaf->Count == 0)
+					{
+						DeleteNode(leaf);
+						_root = NULL;
+					}
+					throw;
+				}
+				++leaf->Count;
+				++_size;
+
+				return Position(leaf, index);
+			}
+
+			/// @brief Makes sure the node has a parent with a room for one more child, splitting the parents up to the root if needed
+			Inner* PrepareParent(Node* node)
+			{
+				if (!node->Parent)
+				{
+					Inner* const root = NewInner();
+					SetChild(root, 0, node);
+					root->Count = 1;
+					_root = root;
+				}
+				else if (node->Parent->Count == InnerCapacity)
+					SplitInner(node->Parent);
+
+				return node->Parent;
+			}
+
+			/// @brief The upper half is copied before the originals are destroyed, so that a throwing copy leaves the tree intact
+			Leaf* SplitLeaf(Leaf* leaf)
+			{
+				Inner* const parent = PrepareParent(leaf);
+				Leaf* const right = NewLeaf();
+
+				const size_t middle = LeafCapacity / 2;
+				try
+				{
+					for (; right->Count < leaf->Count - middle; ++right->Count)
+						right->Values[right->Count].Ctor(leaf->Values[middle + right->Count].Ref());
+					InsertChild(parent, leaf->Index + 1, right, GetKey(right, 0));
+				}
+				catch (...)
+				{
+					DeleteNode(right);
+					if (parent->Count == 1)
+						ShrinkRoot();
+					throw;
+				}
+
+				for (size_t i = middle; i < leaf->Count; ++i)
+					leaf->Values[i].Dtor();
+				leaf->Count = middle;
+				return right;
+			}
+
+			/// @brief The upper half is copied before the originals are destroyed, so that a throwing copy leaves the tree intact
+			void SplitInner(Inner* inner)
+			{
+				Inner* const parent = PrepareParent(inner);
+				Inner* const right = NewInner();
+
+				const size_t middle = InnerCapacity / 2;
+				size_t copied = 0;
+				try
+				{
+					for (; middle + copied + 1 < inner->Count; ++copied)
+						right->Keys[copied].Ctor(inner->Keys[middle + copied].Ref());
+					InsertChild(parent, inner->Index + 1, right, inner->Keys[middle - 1].Ref());
+				}
+				catch (...)
+				{
+					for (size_t i = 0; i < copied; ++i)
+						right->Keys[i].Dtor();
+					DeleteNode(right);
+					if (parent->Count == 1)
+						ShrinkRoot();
+					throw;
+				}
+
+				for (size_t i = middle; i < inner->Count; ++i)
+				{
+					SetChild(right, i - middle, inner->Children[i]);
+					inner->Keys[i - 1].Dtor();
+				}
+				right->Count = inner->Count - middle;
+				inner->Count = middle;
+			}
+
+			/// @brief Inserts the child at the index, the separator goes before it
+			void InsertChild(Inner* parent, size_t index, Node* child, const Key_& separator)
+			{
+				ShiftRight(parent->Keys, index - 1, parent->Count - 1);
+				try
+				{ parent->Keys[index - 1].Ctor(separator); }
+				catch (...)
+				{
+					ShiftLeft(parent->Keys, index - 1, parent->Count);
+					throw;
+				}
+
+				for (size_t i = parent->Count; i > index; --i)
+					SetChild(parent, i, parent->Children[i - 1]);
+				SetChild(parent, index, child);
+				++parent->Count;
+			}
+
+			/// @brief Removes the child at the index along with the separator before it, the child must be deleted already
+			void RemoveChild(Inner* parent, size_t index)
+			{
+				parent->Keys[index - 1].Dtor();
+				ShiftLeft(parent->Keys, index - 1, parent->Count - 1);
+
+				for (size_t i = index; i + 1 < parent->Count; ++i)
+					SetChild(parent, i, parent->Children[i + 1]);
+				--parent->Count;
+
+				if (parent == _root)
+				{
+					if (parent->Count == 1)
+						ShrinkRoot();
+				}
+				else if (parent->Count < InnerMinCount)
+					FillInner(parent);
+			}
+
+			/// @brief Replaces the root that has a single child with that child
+			void ShrinkRoot()
+			{
+				Inner* const root = static_cast<Inner*>(_root);
+				_root = root->Children[0];
+				_root->Parent = NULL;
+				_root->Index = 0;
+				root->Count = 0;
+				DeleteNode(root);
+			}
+
+			static void SetChild(Inner* parent, size_t index, Node* child)
+			{
+				parent->Children[index] = child;
+				child->Parent = parent;
+				child->Index = (u16)index;
+			}
+
+			/// @brief Borrows a value from a sibling or merges with it, the index of a value in the leaf is updated to follow it
+			void FillLeaf(Leaf*& leaf, size_t& index)
+			{
+				Inner* const parent = leaf->Parent;
+				Leaf* const left = leaf->Index != 0 ? static_cast<Leaf*>(parent->Children[leaf->Index - 1]) : NULL;
+				Leaf* const right = leaf->Index + 1 < parent->Count ? static_cast<Leaf*>(parent->Children[leaf->Index + 1]) : NULL;
+
+				if (left && left->Count > LeafMinCount)
+				{
+					ShiftRight(leaf->Values, 0, leaf->Count);
+					Relocate(leaf->Values[0], left->Values[left->Count - 1]);
+					++leaf->Count;
+					--left->Count;
+
+					parent->Keys[leaf->Index - 1].Ref() = GetKey(leaf, 0);
+					++index;
+				}
+				else if (right && right->Count > LeafMinCount)
+				{
+					Relocate(leaf->Values[leaf->Count], right->Values[0]);
+					ShiftLeft(right->Values, 0, right->Count);
+					++leaf->Count;
+					--right->Count;
+
+					parent->Keys[leaf->Index].Ref() = GetKey(right, 0);
+				}
+				else if (left)
+				{
+					index += left->Count;
+					MergeLeaves(left, leaf);
+					leaf = left;
+				}
+				else
+					MergeLeaves(leaf, right);
+			}
+
+			void MergeLeaves(Leaf* left, Leaf* right)
+			{
+				for (size_t i = 0; i < right->Count; ++i)
+					Relocate(left->Values[left->Count + i], right->Values[i]);
+				left->Count += right->Count;
+				right->Count = 0;
+
+				Inner* const parent = right->Parent;
+				const size_t index = right->Index;
+				DeleteNode(right);
+				RemoveChild(parent, index);
+			}
+
+			void FillInner(Inner* inner)
+			{
+				Inner* const parent = inner->Parent;
+				Inner* const left = inner->Index != 0 ? static_cast<Inner*>(parent->Children[inner->Index - 1]) : NULL;
+				Inner* const right = inner->Index + 1 < parent->Count ? static_cast<Inner*>(parent->Children[inner->Index + 1]) : NULL;
+
+				if (left && left->Count > InnerMinCount)
+				{
+					ShiftRight(inner->Keys, 0, inner->Count - 1);
+					for (size_t i = inner->Count; i > 0; --i)
+						SetChild(inner, i, inner->Children[i - 1]);
+
+					Relocate(inner->Keys[0], parent->Keys[inner->Index - 1]);
+					SetChild(inner, 0, left->Children[left->Count - 1]);
+					Relocate(parent->Keys[inner->Index - 1], left->Keys[left->Count - 2]);
+					++inner->Count;
+					--left->Count;
+				}
+				else if (right && right->Count > InnerMinCount)
+				{
+					Relocate(inner->Keys[inner->Count - 1], parent->Keys[inner->Index]);
+					SetChild(inner, inner->Count, right->Children[0]);
+					++inner->Count;
+
+					Relocate(parent->Keys[inner->Index], right->Keys[0]);
+					ShiftLeft(right->Keys, 0, right->Count - 1);
+					for (size_t i = 0; i + 1 < right->Count; ++i)
+						SetChild(right, i, right->Children[i + 1]);
+					--right->Count;
+				}
+				else if (left)
+					MergeInners(left, inner);
+				else
+					MergeInners(inner, right);
+			}
+
+			void MergeInners(Inner* left, Inner* right)
+			{
+				Inner* const parent = right->Parent;
+				const size_t index = right->Index;
+
+				left->Keys[left->Count - 1].Ctor(parent->Keys[index - 1].Ref());
+				for (size_t i = 0; i < right->Count; ++i)
+				{
+					SetChild(left, left->Count + i, right->Children[i]);
+					if (i + 1 < right->Count)
+						Relocate(left->Keys[left->Count + i], right->Keys[i]);
+				}
+				left->Count += right->Count;
+				right->Count = 0;
+
+				DeleteNode(right);
+				RemoveChild(parent, index);
+			}
+
+			template < typename T >
+			static void Relocate(StorageFor<T>& dst, StorageFor<T>& src)
+			{
+				dst.Ctor(src.Ref());
+				src.Dtor();
+			}
+
+			/// @brief Moves [index, count) to [index + 1, count + 1), or moves the items back if a copy throws
+			template < typename T >
+			static void ShiftRight(StorageFor<T>* items, size_t index, size_t count)
+			{
+				size_t i = count;
+				try
+				{
+					for (; i > index; --i)
+						Relocate(items[i], items[i - 1]);
+				}
+				catch (...)
+				{
+					ShiftLeft(items, i, count + 1);
+					throw;
+				}
+			}
+
+			/// @brief Moves [index + 1, count) to [index, count - 1), the item at index must be destroyed already
+			template < typename T >
+			static void ShiftLeft(StorageFor<T>* items, size_t index, size_t count)
+			{
+				for (size_t i = index; i + 1 < count; ++i)
+					Relocate(items[i], items[i + 1]);
+			}
+
+			Node* Clone(const Node* node)
+			{
+				if (node->IsLeaf)
+				{
+					const Leaf* const leaf = static_cast<const Leaf*>(node);
+					Leaf* const result = NewLeaf();
+					try
+					{
+						for (; result->Count < leaf->Count; ++result->Count)
+							result->Values[result->Count].Ctor(leaf->Values[result->Count].Ref());
+					}
+					catch (...)
+					{
+						DeleteNode(result);
+						throw;
+					}
+					return result;
+				}
+
+				const Inner* const inner = static_cast<const Inner*>(node);
+				Inner* const result = NewInner();
+				try
+				{
+					for (; result->Count < inner->Count; ++result->Count)
+					{
+						Node* const child = Clone(inner->Children[result->Count]);
+						if (result->Count != 0)
+						{
+							try
+							{ result->Keys[result->Count - 1].Ctor(inner->Keys[result->Count - 1].Ref()); }
+							catch (...)
+							{
+								DeleteNode(child);
+								throw;
+							}
+						}
+						SetChild(result, result->Count, child);
+					}
+				}
+				catch (...)
+				{
+					DeleteNode(result);
+					throw;
+				}
+				return result;
+			}
+
+			Leaf* NewLeaf()
+			{
+				Leaf* const leaf = _leafAllocator.allocate(1);
+				return new(leaf) Leaf();
+			}
+
+			Inner* NewInner()
+			{
+				Inner* const inner = _innerAllocator.allocate(1);
+				return new(inner) Inner();
+			}
+
+			/// @brief Deletes the node along with its values or children
+			void DeleteNode(Node* node)
+			{
+				if (node->IsLeaf)
+				{
+					Leaf* const leaf = static_cast<Leaf*>(node);
+					for (size_t i = 0; i < leaf->Count; ++i)
+						leaf->Values[i].Dtor();
+					leaf->~Leaf();
+					_leafAllocator.deallocate(leaf, 1);
+					return;
+				}
+
+				Inner* const inner = static_cast<Inner*>(node);
+				for (size_t i = 0; i < inner->Count; ++i)
+				{
+					if (i != 0)
+						inner->Keys[i - 1].Dtor();
+					DeleteNode(inner->Children[i]);
+				}
+				inner->~Inner();
+				_innerAllocator.deallocate(inner, 1);
+			}
+		};
+
+	}
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef STINGRAYKIT_COLLECTION_CACHESTATS_H
+#define STINGRAYKIT_COLLECTION_CACHESTATS_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/string/ToString.h>
+#include <stingraykit/time/Time.h>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	struct CacheStats
+	{
+		u64				Hits;
+		u64				Misses;
+		u64				Evictions;		// by capacity
+		u64				Expirations;	// by time
+		u64				Loads;
+		TimeDuration	LoadTime;		// total time spent in the loads
+
+	public:
+		CacheStats() : Hits(), Misses(), Evictions(), Expirations(), Loads()
+		{ }
+
+		double GetHitRatio() const
+		{ return Hits + Misses != 0 ? (double)Hits / (Hits + Misses) : 0; }
+
+		TimeDuration GetAverageLoadTime() const
+		{ return Loads != 0 ? TimeDuration::FromMicroseconds(LoadTime.GetMicroseconds() / (s64)Loads) : TimeDuration(); }
+
+		CacheStats& operator += (const CacheStats& other)
+		{
+			Hits += other.Hits;
+			Misses += other.Misses;
+			Evictions += other.Evictions;
+			Expirations += other.Expirations;
+			Loads += other.Loads;
+			LoadTime += other.LoadTime;
+			return *this;
+		}
+
+		std::string ToString() const
+		{
+			return StringBuilder() % "{ hits: " % Hits % ", misses: " % Misses % ", evictions: " % Evictions % ", expirations: " % Expirations %
+					", loads: " % Loads % ", load time: " % LoadTime % " }";
+		}
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef STINGRAYKIT_COLLECTION_EXPIRINGCACHE_H
+#define STINGRAYKIT_COLLECTION_EXPIRINGCACHE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/CacheStats.h>
+#include <stingraykit/collection/HashQueueCache.h>
+#include <stingraykit/timer/Timer.h>
+#include <stingraykit/time/TimeEngine.h>
+#include <stingraykit/Token.h>
+
+#include <map>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief Thread-safe LRU cache with a weight budget and time-to-live expiry
+	 * @par The capacity is the total weight of the values given by SizeMapper_, e.g. their size in bytes. Each value gets either the default TTL or its own one,
+	 * or does not expire at all if neither is given. An expired value is removed when it is looked up, and, if a timer is given, by a periodic sweep.
+	 * OnEvicted is invoked for the values removed both by capacity and by time, after the cache is unlocked.
+	 */
+	template < typename Key_, typename Value_, typename SizeMapper_ = DefaultCacheSizeMapper, typename Hash_ = hashers::Hash, typename Equals_ = comparers::Equals >
+	class ExpiringCache : public virtual ICache<Key_, Value_>
+	{
+		STINGRAYKIT_NONCOPYABLE(ExpiringCache);
+
+		typedef ICache<Key_, Value_> Base;
+
+		typedef typename Base::KeyPassingType KeyPassingType;
+		typedef typename Base::ValuePassingType ValuePassingType;
+
+		typedef typename Base::OnEvictedSignature OnEvictedSignature;
+
+		struct Entry;
+		typedef std::multimap<u64, Entry*> Deadlines; // monotonic microseconds
+
+		struct Entry : public IntrusiveListNodeData
+		{
+			Key_							Key;
+			Value_							Value;
+			size_t							Hash;
+			Entry*							NextInBucket;
+
+			size_t							Weight;
+			bool							Expires;
+			typename Deadlines::iterator	Deadline;
+
+		public:
+			Entry(KeyPassingType key, ValuePassingType value, size_t hash, size_t weight)
+				:	Key(key),
+					Value(value),
+					Hash(hash),
+					NextInBucket(),
+					Weight(weight),
+					Expires(false)
+			{ }
+		};
+
+		typedef Detail::CacheHashIndex<Entry, Key_, Hash_, Equals_> Index;
+		typedef IntrusiveList<Entry> Queue;
+
+		typedef std::vector<std::pair<Key_, Value_> > RemovedEntries;
+
+	private:
+		size_t							_capacity;
+		optional<TimeDuration>			_defaultTtl;
+		SizeMapper_						_sizeMapper;
+
+		Mutex							_mutex;
+		size_t							_size;
+		Index							_index;
+		Queue							_queue; // least recently used first
+		Deadlines						_deadlines;
+		CacheStats						_stats;
+
+		signal<OnEvictedSignature>		_onEvicted;
+
+		TimerPtr						_timer;
+		TokenHolder						_sweepConnection;
+
+	public:
+		explicit ExpiringCache(size_t capacity, const optional<TimeDuration>& defaultTtl = null)
+			:	_capacity(capacity),
+				_defaultTtl(defaultTtl),
+				_size()
+		{ }
+
+		ExpiringCache(size_t capacity, const optional<TimeDuration>& defaultTtl, const TimerPtr& timer, TimeDuration sweepInterval)
+			:	_capacity(capacity),
+				_defaultTtl(defaultTtl),
+				_size(),
+				_timer(STINGRAYKIT_REQUIRE_NOT_NULL(timer))
+		{ _sweepConnection = _timer->SetTimer(sweepInterval, bind(&ExpiringCache::RemoveExpired, this)); }
+
+		virtual ~ExpiringCache()
+		{
+			_sweepConnection.Reset();
+			DoClear();
+		}
+
+		virtual bool TryGet(KeyPassingType key, Value_& out)
+		{
+			RemovedEntries removed;
+			bool result = false;
+			{
+				MutexLock l(_mutex);
+
+				Entry* entry = _index.Find(key, _index.GetHash(key));
+				if (entry && entry->Expires && entry->Deadline->first <= TimeEngine::GetMonotonicMicroseconds())
+				{
+					++_stats.Expirations;
+					TakeEntry(entry, removed);
+					entry = NULL;
+				}
+
+				if (entry)
+				{
+					++_stats.Hits;
+					_queue.erase(*entry);
+					_queue.push_back(*entry);
+
+					out = entry->Value;
+					result = true;
+				}
+				else
+					++_stats.Misses;
+			}
+
+			NotifyRemoved(removed);
+			return result;
+		}
+
+		virtual void Set(KeyPassingType key, ValuePassingType value)
+		{ DoSet(key, value, _defaultTtl); }
+
+		void Set(KeyPassingType key, ValuePassingType value, TimeDuration ttl)
+		{ DoSet(key, value, ttl); }
+
+		virtual bool TryRemove(KeyPassingType key)
+		{
+			MutexLock l(_mutex);
+
+			Entry* const entry = _index.Find(key, _index.GetHash(key));
+			if (!entry)
+				return false;
+
+			DoRemove(entry);
+			return true;
+		}
+
+		virtual void Clear()
+		{
+			MutexLock l(_mutex);
+			DoClear();
+		}
+
+		virtual size_t GetSize() const
+		{
+			MutexLock l(_mutex);
+			return _size;
+		}
+
+		virtual signal_connector<OnEvictedSignature> OnEvicted() const
+		{ return _onEvicted.connector(); }
+
+		/// @brief Removes the expired values, is invoked by the timer if there is one
+		void RemoveExpired()
+		{
+			RemovedEntries removed;
+			{
+				MutexLock l(_mutex);
+
+				const u64 now = TimeEngine::GetMonotonicMicroseconds();
+				while (!_deadlines.empty() && _deadlines.begin()->first <= now)
+				{
+					++_stats.Expirations;
+					TakeEntry(_deadlines.begin()->second, removed);
+				}
+			}
+
+			NotifyRemoved(removed);
+		}
+
+		CacheStats GetStats() const
+		{
+			MutexLock l(_mutex);
+			return _stats;
+		}
+
+	private:
+		void DoSet(KeyPassingType key, ValuePassingType value, const optional<TimeDuration>& ttl)
+		{
+			RemovedEntries removed;
+			{
+				MutexLock l(_mutex);
+
+				const size_t weight = _sizeMapper(value);
+				const size_t hash = _index.GetHash(key);
+
+				Entry* entry = _index.Find(key, hash);
+				if (entry)
+				{
+					entry->Value = value;
+					_size = _size - entry->Weight + weight;
+					entry->Weight = weight;
+
+					_queue.erase(*entry);
+					ResetDeadline(entry);
+				}
+				else
+				{
+					_index.Reserve();
+
+					entry = new Entry(key, value, hash, weight);
+					_index.Insert(entry);
+					_size += weight;
+				}
+
+				_queue.push_back(*entry);
+
+				if (ttl)
+				{
+					entry->Deadline = _deadlines.insert(std::make_pair(TimeEngine::GetMonotonicMicroseconds() + ttl->GetMicroseconds(), entry));
+					entry->Expires = true;
+				}
+
+				while (_size > _capacity)
+				{
+					STINGRAYKIT_CHECK(!_queue.empty(), StringBuilder() % "Size limit reached, but the queue is empty. Size: " % _size % ", capacity: " % _capacity);
+
+					++_stats.Evictions;
+					TakeEntry(&*_queue.begin(), removed);
+				}
+			}
+
+			NotifyRemoved(removed);
+		}
+
+		void TakeEntry(Entry* entry, RemovedEntries& removed)
+		{
+			removed.push_back(std::make_pair(entry->Key, entry->Value));
+			DoRemove(entry);
+		}
+
+		void DoRemove(Entry* entry)
+		{
+			_index.Remove(entry);
+			_queue.erase(*entry);
+			ResetDeadline(entry);
+
+			_size -= entry->Weight;
+			delete entry;
+		}
+
+		void ResetDeadline(Entry* entry)
+		{
+			if (!entry->Expires)
+				return;
+
+			_deadlines.erase(entry->Deadline);
+			entry->Expires = false;
+		}
+
+		void DoClear()
+		{
+			while (!_queue.empty())
+			{
+				Entry& entry = *_queue.begin();
+				_queue.erase(entry);
+				delete &entry;
+			}
+
+			_deadlines.clear();
+			_index.Clear();
+			_size = 0;
+		}
+
+		void NotifyRemoved(const RemovedEntries& removed)
+		{
+			for (typename RemovedEntries::const_iterator it = removed.begin(); it != removed.end(); ++it)
+				_onEvicted(it->first, it->second);
+		}
+	};
+
+	/** @} */
+
+}
+
+#endif
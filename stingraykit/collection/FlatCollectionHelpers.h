@@ -0,0 +1,138 @@
+#ifndef STINGRAYKIT_COLLECTION_FLATCOLLECTIONHELPERS_H
+#define STINGRAYKIT_COLLECTION_FLATCOLLECTIONHELPERS_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/assert.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace stingray
+{
+
+	/// @brief Tells flat_map and flat_set that the range is sorted by the key and has no equal keys, so it is taken as is
+	struct sorted_unique_tag { };
+
+
+	namespace Detail
+	{
+
+		template < typename Compare_ >
+		struct FlatReversedCompare
+		{
+			Compare_	Cmp;
+
+			explicit FlatReversedCompare(const Compare_& cmp) : Cmp(cmp) { }
+
+			template < typename T >
+			bool operator () (const T& lhs, const T& rhs) const	{ return Cmp(rhs, lhs); }
+		};
+
+
+		/// @brief Tells whether the neighbours of a sorted range are equal
+		template < typename Compare_ >
+		struct FlatEquivalentNeighbours
+		{
+			Compare_	Cmp;
+
+			explicit FlatEquivalentNeighbours(const Compare_& cmp) : Cmp(cmp) { }
+
+			template < typename T >
+			bool operator () (const T& lhs, const T& rhs) const	{ return !Cmp(lhs, rhs); }
+		};
+
+
+		template < typename RandomIterator_, typename Compare_ >
+		bool FlatIsSortedUnique(RandomIterator_ first, RandomIterator_ last, const Compare_& cmp)
+		{ return std::adjacent_find(first, last, FlatEquivalentNeighbours<Compare_>(cmp)) == last; }
+
+
+		/// @brief Sorts the values appended after the first count ones and merges them in, in O(m log m + n) instead of O(m * n) for one by one insertion
+		/// @par Of the equal values the one inserted earlier stays, as std::map::insert does
+		template < typename Container_, typename Compare_ >
+		void FlatMergeAppended(Container_& container, size_t count, const Compare_& cmp, bool sortedUnique = false)
+		{
+			typedef typename Container_::iterator Iterator;
+
+			const Iterator middle = container.begin() + count;
+			Iterator end = container.end();
+
+			if (sortedUnique)
+				STINGRAYKIT_DEBUG_ASSERT(FlatIsSortedUnique(middle, end, cmp));
+			else if (!FlatIsSortedUnique(middle, end, cmp))
+			{
+				if (std::adjacent_find(middle, end, FlatReversedCompare<Compare_>(cmp)) != end)
+					std::stable_sort(middle, end, cmp);
+				end = std::unique(middle, end, FlatEquivalentNeighbours<Compare_>(cmp));
+			}
+
+			if (middle != container.begin() && middle != end && !cmp(*(middle - 1), *middle))
+			{
+				std::inplace_merge(container.begin(), middle, end, cmp);
+				end = std::unique(container.begin(), end, FlatEquivalentNeighbours<Compare_>(cmp));
+			}
+
+			container.erase(end, container.end());
+		}
+
+
+		/// @brief std::lower_bound without the unpredictable branch: the range is halved by a conditional move every step,
+		/// and both of the next midpoints are prefetched, so that the large arrays don't wait for the memory on every step
+		template < typename RandomIterator_, typename T, typename Compare_ >
+		RandomIterator_ FlatLowerBound(RandomIterator_ first, RandomIterator_ last, const T& value, const Compare_& cmp)
+		{
+			typedef typename std::iterator_traits<RandomIterator_>::difference_type Difference;
+
+			Difference length = last - first;
+			if (length == 0)
+				return first;
+
+			while (length > 1)
+			{
+				const Difference half = length / 2;
+#if defined(__GNUC__) || defined(__clang__)
+				__builtin_prefetch(&*(first + half / 2));
+				__builtin_prefetch(&*(first + half + half / 2));
+#endif
+				first = cmp(first[half], value) ? first + half : first;
+				length -= half;
+			}
+			return cmp(*first, value) ? first + 1 : first;
+		}
+
+
+		/// @brief Branchless std::upper_bound
+		/// @see FlatLowerBound
+		template < typename RandomIterator_, typename T, typename Compare_ >
+		RandomIterator_ FlatUpperBound(RandomIterator_ first, RandomIterator_ last, const T& value, const Compare_& cmp)
+		{
+			typedef typename std::iterator_traits<RandomIterator_>::difference_type Difference;
+
+			Difference length = last - first;
+			if (length == 0)
+				return first;
+
+			while (length > 1)
+			{
+				const Difference half = length / 2;
+#if defined(__GNUC__) || defined(__clang__)
+				__builtin_prefetch(&*(first + half / 2));
+				__builtin_prefetch(&*(first + half + half / 2));
+#endif
+				first = cmp(value, first[half]) ? first : first + half;
+				length -= half;
+			}
+			return cmp(value, *first) ? first : first + 1;
+		}
+
+	}
+
+}
+
+#endif
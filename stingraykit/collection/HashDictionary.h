@@ -0,0 +1,442 @@
+#ifndef STINGRAYKIT_COLLECTION_HASHDICTIONARY_H
+#define STINGRAYKIT_COLLECTION_HASHDICTIONARY_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/EnumerableHelpers.h>
+#include <stingraykit/collection/ForEach.h>
+#include <stingraykit/collection/IDictionary.h>
+#include <stingraykit/collection/KeyNotFoundExceptionCreator.h>
+#include <stingraykit/compare/comparers.h>
+#include <stingraykit/compare/hashers.h>
+
+#include <vector>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief Dictionary on an open addressing hash table, copy-on-write for the enumerators as MapDictionary
+	 * @par The pairs are stored in a plain vector, the table is a power of two vector of slots with the pair index and the high hash bits, probed linearly.
+	 * A lookup usually reads one slot and one pair, there are no per-pair allocations.
+	 * @par The enumeration order is unspecified unless InsertionOrdered_ is set: by default a removed pair is replaced with the last one,
+	 * otherwise it is marked as removed and the vector is compacted once the removed pairs outnumber the rest.
+	 * Find and ReverseFind enumerate from the found pair to the end or to the beginning in the enumeration order.
+	 */
+	template <
+			typename KeyType_,
+			typename ValueType_,
+			typename HashType_ = hashers::Hash,
+			typename EqualsType_ = comparers::Equals,
+			bool InsertionOrdered_ = false
+			>
+	class HashDictionary : public virtual IDictionary<KeyType_, ValueType_>
+	{
+	public:
+		typedef KeyType_									KeyType;
+		typedef ValueType_									ValueType;
+		typedef HashType_									HashType;
+		typedef EqualsType_									EqualsType;
+
+		typedef KeyValuePair<KeyType, ValueType>			PairType;
+
+	private:
+		static const size_t MinSlotsCount = 8;
+		static const u32 EmptySlot = 0;
+
+		struct Entry
+		{
+			PairType		Pair;
+			u32				Hash;
+			bool			Removed;
+
+			Entry(const KeyType& key, const ValueType& value, u32 hash) : Pair(key, value), Hash(hash), Removed(false) { }
+		};
+
+		struct Slot
+		{
+			u32				Index; // index of the entry plus one, EmptySlot if there is none
+			u32				Hash;
+
+			Slot() : Index(EmptySlot), Hash() { }
+		};
+
+		struct Table
+		{
+			std::vector<Entry>	Entries;
+			std::vector<Slot>	Slots;
+			size_t				Count;
+
+			Table() : Slots(MinSlotsCount), Count() { }
+		};
+		STINGRAYKIT_DECLARE_PTR(Table);
+
+		struct Holder
+		{
+			TablePtr		Table;
+			Holder(const TablePtr& table) : Table(table) { }
+		};
+		STINGRAYKIT_DECLARE_PTR(Holder);
+
+		class Enumerator : public virtual IEnumerator<PairType>
+		{
+		private:
+			HolderPtr		_holder;
+			size_t			_position; // index of the current entry plus one when reversed, so that zero is the end
+			bool			_reversed;
+
+		public:
+			Enumerator(const HolderPtr& holder, size_t index, bool reversed)
+				: _holder(holder), _position(reversed ? index + 1 : index), _reversed(reversed)
+			{ SkipRemoved(); }
+
+			virtual bool Valid() const
+			{ return _reversed ? _position != 0 : _position < _holder->Table->Entries.size(); }
+
+			virtual PairType Get() const
+			{
+				STINGRAYKIT_CHECK(Valid(), "Enumerator is not valid!");
+				return _holder->Table->Entries[_reversed ? _position - 1 : _position].Pair;
+			}
+
+			virtual void Next()
+			{
+				STINGRAYKIT_CHECK(Valid(), "Enumerator is not valid!");
+				_reversed ? --_position : ++_position;
+				SkipRemoved();
+			}
+
+		private:
+			void SkipRemoved()
+			{
+				const std::vector<Entry>& entries = _holder->Table->Entries;
+				while (Valid() && entries[_reversed ? _position - 1 : _position].Removed)
+					_reversed ? --_position : ++_position;
+			}
+		};
+
+		struct ReverseEnumerable : public virtual IEnumerable<PairType>
+		{
+			HolderPtr		_holder;
+
+			ReverseEnumerable(const HolderPtr& holder) : _holder(holder) { }
+
+			virtual shared_ptr<IEnumerator<PairType> > GetEnumerator() const
+			{ return make_shared<Enumerator>(_holder, _holder->Table->Entries.size() - 1, true); }
+		};
+
+	private:
+		TablePtr				_table;
+		mutable HolderWeakPtr	_tableHolder;
+		HashType				_hash;
+		EqualsType				_equals;
+
+	public:
+		HashDictionary()
+			:	_table(make_shared<Table>())
+		{ }
+
+		HashDictionary(const HashDictionary& other)
+		{ CopyTable(other._table); }
+
+		HashDictionary(shared_ptr<IEnumerable<PairType> > enumerable)
+			:	_table(make_shared<Table>())
+		{
+			STINGRAYKIT_REQUIRE_NOT_NULL(enumerable);
+			FOR_EACH(const PairType p IN enumerable)
+				Set(p.Key, p.Value);
+		}
+
+		HashDictionary(shared_ptr<IEnumerator<PairType> > enumerator)
+			:	_table(make_shared<Table>())
+		{
+			STINGRAYKIT_REQUIRE_NOT_NULL(enumerator);
+			FOR_EACH(const PairType p IN enumerator)
+				Set(p.Key, p.Value);
+		}
+
+		HashDictionary& operator =(const HashDictionary& other)
+		{ CopyTable(other._table); return *this; }
+
+		virtual shared_ptr<IEnumerator<PairType> > GetEnumerator() const
+		{ return make_shared<Enumerator>(GetTableHolder(), 0, false); }
+
+		virtual shared_ptr<IEnumerable<PairType> > Reverse() const
+		{ return make_shared<ReverseEnumerable>(GetTableHolder()); }
+
+		virtual size_t GetCount() const
+		{ return _table->Count; }
+
+		virtual bool IsEmpty() const
+		{ return _table->Count == 0; }
+
+		virtual bool ContainsKey(const KeyType& key) const
+		{ return FindSlot(key, GetHash(key)) != NotFound(); }
+
+		virtual shared_ptr<IEnumerator<PairType> > Find(const KeyType& key) const
+		{
+			const size_t slot = FindSlot(key, GetHash(key));
+			if (slot == NotFound())
+				return MakeEmptyEnumerator();
+
+			return make_shared<Enumerator>(GetTableHolder(), _table->Slots[slot].Index - 1, false);
+		}
+
+		virtual shared_ptr<IEnumerator<PairType> > ReverseFind(const KeyType& key) const
+		{
+			const size_t slot = FindSlot(key, GetHash(key));
+			if (slot == NotFound())
+				return MakeEmptyEnumerator();
+
+			return make_shared<Enumerator>(GetTableHolder(), _table->Slots[slot].Index - 1, true);
+		}
+
+		virtual ValueType Get(const KeyType& key) const
+		{
+			const size_t slot = FindSlot(key, GetHash(key));
+			STINGRAYKIT_CHECK(slot != NotFound(), CreateKeyNotFoundException(key));
+			return _table->Entries[_table->Slots[slot].Index - 1].Pair.Value;
+		}
+
+		virtual bool TryGet(const KeyType& key, ValueType& outValue) const
+		{
+			const size_t slot = FindSlot(key, GetHash(key));
+			if (slot == NotFound())
+				return false;
+
+			outValue = _table->Entries[_table->Slots[slot].Index - 1].Pair.Value;
+			return true;
+		}
+
+		virtual void Set(const KeyType& key, const ValueType& value)
+		{
+			CopyOnWrite();
+
+			const u32 hash = GetHash(key);
+			const size_t slot = FindSlot(key, hash);
+			if (slot != NotFound())
+			{
+				_table->Entries[_table->Slots[slot].Index - 1].Pair.Value = value;
+				return;
+			}
+
+			if ((_table->Count + 1) * 4 > _table->Slots.size() * 3)
+				Rehash(_table->Slots.size() * 2);
+
+			_table->Entries.push_back(Entry(key, value, hash));
+			InsertSlot(_table->Entries.size() - 1);
+			++_table->Count;
+		}
+
+		virtual void Remove(const KeyType& key)
+		{
+			CopyOnWrite();
+
+			const size_t slot = FindSlot(key, GetHash(key));
+			if (slot != NotFound())
+				RemoveAt(slot);
+
+			TryCompact();
+		}
+
+		virtual bool TryRemove(const KeyType& key)
+		{
+			const size_t slot = FindSlot(key, GetHash(key));
+			if (slot == NotFound())
+				return false;
+
+			CopyOnWrite();
+			RemoveAt(slot);
+			TryCompact();
+			return true;
+		}
+
+		virtual size_t RemoveWhere(const function<bool (const KeyType&, const ValueType&)>& pred)
+		{
+			CopyOnWrite();
+			size_t ret = 0;
+			for (size_t index = 0; index < _table->Entries.size(); )
+			{
+				const Entry& entry = _table->Entries[index];
+				if (entry.Removed || !pred(entry.Pair.Key, entry.Pair.Value))
+				{
+					++index;
+					continue;
+				}
+
+				RemoveAt(FindSlot(entry.Pair.Key, entry.Hash));
+				++ret;
+
+				if (InsertionOrdered_)
+					++index;
+			}
+
+			TryCompact();
+			return ret;
+		}
+
+		virtual void Clear()
+		{
+			if (_tableHolder.lock())
+			{
+				_table = make_shared<Table>();
+				_tableHolder.reset();
+			}
+			else
+				*_table = Table();
+		}
+
+	private:
+		static size_t NotFound()
+		{ return (size_t)-1; }
+
+		u32 GetHash(const KeyType& key) const
+		{ return (u32)_hash(key); }
+
+		static u32 GetSlotHash(u32 hash)
+		{ return hash | 1; }
+
+		size_t FindSlot(const KeyType& key, u32 hash) const
+		{
+			const std::vector<Slot>& slots = _table->Slots;
+			const size_t mask = slots.size() - 1;
+			const u32 slotHash = GetSlotHash(hash);
+
+			for (size_t slot = hash & mask; slots[slot].Index != EmptySlot; slot = (slot + 1) & mask)
+				if (slots[slot].Hash == slotHash && _equals(_table->Entries[slots[slot].Index - 1].Pair.Key, key))
+					return slot;
+
+			return NotFound();
+		}
+
+		void InsertSlot(size_t index)
+		{
+			std::vector<Slot>& slots = _table->Slots;
+			const size_t mask = slots.size() - 1;
+			const u32 hash = _table->Entries[index].Hash;
+
+			size_t slot = hash & mask;
+			while (slots[slot].Index != EmptySlot)
+				slot = (slot + 1) & mask;
+
+			slots[slot].Index = (u32)index + 1;
+			slots[slot].Hash = GetSlotHash(hash);
+		}
+
+		void RemoveAt(size_t slot)
+		{
+			std::vector<Entry>& entries = _table->Entries;
+			const size_t index = _table->Slots[slot].Index - 1;
+
+			RemoveSlot(slot);
+			--_table->Count;
+
+			if (InsertionOrdered_)
+			{
+				entries[index].Removed = true;
+				entries[index].Pair.Value = ValueType();
+				return;
+			}
+
+			const size_t last = entries.size() - 1;
+			if (index != last)
+			{
+				const size_t mask = _table->Slots.size() - 1;
+				size_t lastSlot = entries[last].Hash & mask;
+				while (_table->Slots[lastSlot].Index != last + 1)
+					lastSlot = (lastSlot + 1) & mask;
+
+				_table->Slots[lastSlot].Index = (u32)index + 1;
+				entries[index] = entries[last];
+			}
+			entries.pop_back();
+		}
+
+		/// @brief Backward shift deletion, keeps the probe sequences without gaps and so without tombstones
+		void RemoveSlot(size_t slot)
+		{
+			std::vector<Slot>& slots = _table->Slots;
+			const size_t mask = slots.size() - 1;
+
+			size_t next = (slot + 1) & mask;
+			for (; slots[next].Index != EmptySlot; next = (next + 1) & mask)
+			{
+				const size_t home = _table->Entries[slots[next].Index - 1].Hash & mask;
+				if (((next - home) & mask) >= ((next - slot) & mask))
+				{
+					slots[slot] = slots[next];
+					slot = next;
+				}
+			}
+
+			slots[slot] = Slot();
+		}
+
+		void Rehash(size_t slotsCount)
+		{
+			_table->Slots.assign(slotsCount, Slot());
+			for (size_t index = 0; index < _table->Entries.size(); ++index)
+				if (!_table->Entries[index].Removed)
+					InsertSlot(index);
+		}
+
+		void TryCompact()
+		{
+			std::vector<Entry>& entries = _table->Entries;
+			if (!InsertionOrdered_ || entries.size() - _table->Count <= std::max(_table->Count, MinSlotsCount))
+				return;
+
+			std::vector<Entry> live;
+			live.reserve(_table->Count);
+			for (typename std::vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+				if (!it->Removed)
+					live.push_back(*it);
+
+			entries.swap(live);
+			Rehash(_table->Slots.size());
+		}
+
+		void CopyTable(const TablePtr& table)
+		{
+			_table = make_shared<Table>(*table);
+			_tableHolder.reset();
+		}
+
+		HolderPtr GetTableHolder() const
+		{
+			HolderPtr tableHolder = _tableHolder.lock();
+
+			if (!tableHolder)
+				_tableHolder = (tableHolder = make_shared<Holder>(_table));
+
+			return tableHolder;
+		}
+
+		void CopyOnWrite()
+		{
+			if (_tableHolder.lock())
+				CopyTable(_table);
+		}
+	};
+
+	template < typename KeyType_, typename ValueType_, typename HashType_, typename EqualsType_, bool InsertionOrdered_ >
+	const size_t HashDictionary<KeyType_, ValueType_, HashType_, EqualsType_, InsertionOrdered_>::MinSlotsCount;
+
+	template < typename KeyType_, typename ValueType_, typename HashType_, typename EqualsType_, bool InsertionOrdered_ >
+	const u32 HashDictionary<KeyType_, ValueType_, HashType_, EqualsType_, InsertionOrdered_>::EmptySlot;
+
+	/** @} */
+
+}
+
+#endif
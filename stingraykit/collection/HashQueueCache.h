@@ -0,0 +1,292 @@
+#ifndef STINGRAYKIT_COLLECTION_HASHQUEUECACHE_H
+#define STINGRAYKIT_COLLECTION_HASHQUEUECACHE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/IntrusiveList.h>
+#include <stingraykit/collection/QueueCache.h>
+#include <stingraykit/compare/hashers.h>
+
+#include <vector>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	namespace Detail
+	{
+
+		/// @brief Chained hash table of entries that have Key, Hash and NextInBucket members, the entries are owned by the caller
+		template < typename Entry_, typename Key_, typename Hash_, typename Equals_ >
+		class CacheHashIndex
+		{
+			STINGRAYKIT_NONCOPYABLE(CacheHashIndex);
+
+			typedef typename GetParamPassingType<Key_>::ValueT KeyPassingType;
+			typedef std::vector<Entry_*> Buckets;
+
+			static const size_t MinBucketsCount = 16;
+
+		private:
+			Hash_			_hash;
+			Equals_			_equals;
+
+			Buckets			_buckets; // power of two sized
+			size_t			_count;
+
+		public:
+			CacheHashIndex() : _buckets(MinBucketsCount), _count()
+			{ }
+
+			size_t GetHash(KeyPassingType key) const
+			{ return _hash(key); }
+
+			Entry_* Find(KeyPassingType key, size_t hash) const
+			{
+				for (Entry_* entry = _buckets[hash & (_buckets.size() - 1)]; entry; entry = entry->NextInBucket)
+					if (entry->Hash == hash && _equals(entry->Key, key))
+						return entry;
+
+				return NULL;
+			}
+
+			/// @brief Grows the table beforehand, so that the following Insert does not throw
+			void Reserve()
+			{
+				if (_count >= _buckets.size())
+					Rehash(_buckets.size() * 2);
+			}
+
+			void Insert(Entry_* entry)
+			{
+				Entry_*& bucket = _buckets[entry->Hash & (_buckets.size() - 1)];
+				entry->NextInBucket = bucket;
+				bucket = entry;
+				++_count;
+			}
+
+			void Remove(Entry_* entry)
+			{
+				Entry_** link = &_buckets[entry->Hash & (_buckets.size() - 1)];
+				while (*link != entry)
+					link = &(*link)->NextInBucket;
+				*link = entry->NextInBucket;
+				--_count;
+			}
+
+			void Clear()
+			{
+				std::fill(_buckets.begin(), _buckets.end(), (Entry_*)NULL);
+				_count = 0;
+			}
+
+			size_t GetCount() const
+			{ return _count; }
+
+		private:
+			void Rehash(size_t bucketsCount)
+			{
+				Buckets buckets(bucketsCount);
+				for (typename Buckets::const_iterator it = _buckets.begin(); it != _buckets.end(); ++it)
+				{
+					for (Entry_* entry = *it; entry; )
+					{
+						Entry_* const next = entry->NextInBucket;
+						Entry_*& bucket = buckets[entry->Hash & (bucketsCount - 1)];
+						entry->NextInBucket = bucket;
+						bucket = entry;
+						entry = next;
+					}
+				}
+
+				_buckets.swap(buckets);
+			}
+		};
+
+	}
+
+
+	/**
+	 * @brief QueueCache counterpart that keeps the entries in a chained hash table linked into an intrusive queue,
+	 * so that lookups, queue updates and evictions take constant time and cache hits do not allocate
+	 * @par Has the same eviction and OnEvicted semantics as QueueCache: Set moves the entry to the back of the queue in both modes,
+	 * TryGet does it only in the Lru mode, evicted entries are taken from the front of the queue until the size fits into the capacity.
+	 */
+	template < typename Key_, typename Value_, QueueEvictionPolicy::Enum EvictionPolicy_, typename SizeMapper_ = DefaultCacheSizeMapper, typename Hash_ = hashers::Hash, typename Equals_ = comparers::Equals >
+	class HashQueueCache : public virtual ICache<Key_, Value_>
+	{
+		STINGRAYKIT_NONCOPYABLE(HashQueueCache);
+
+		typedef ICache<Key_, Value_> Base;
+
+		typedef typename Base::KeyPassingType KeyPassingType;
+		typedef typename Base::ValuePassingType ValuePassingType;
+
+		typedef typename Base::OnEvictedSignature OnEvictedSignature;
+
+		struct Entry : public IntrusiveListNodeData
+		{
+			Key_		Key;
+			Value_		Value;
+			size_t		Hash;
+			Entry*		NextInBucket;
+
+		public:
+			Entry(KeyPassingType key, ValuePassingType value, size_t hash)
+				:	Key(key),
+					Value(value),
+					Hash(hash),
+					NextInBucket()
+			{ }
+		};
+
+		typedef Detail::CacheHashIndex<Entry, Key_, Hash_, Equals_> Index;
+		typedef IntrusiveList<Entry> Queue;
+
+	private:
+		size_t							_capacity;
+		size_t							_size;
+		SizeMapper_						_sizeMapper;
+
+		Index							_index;
+		Queue							_queue;
+
+		signal<OnEvictedSignature>		_onEvicted;
+
+	public:
+		HashQueueCache(size_t capacity)
+			:	_capacity(capacity),
+				_size()
+		{ }
+
+		virtual ~HashQueueCache()
+		{ Clear(); }
+
+		virtual bool TryGet(KeyPassingType key, Value_& out)
+		{
+			Entry* const entry = _index.Find(key, _index.GetHash(key));
+			if (!entry)
+				return false;
+
+			if (EvictionPolicy_ == QueueEvictionPolicy::Lru)
+			{
+				_queue.erase(*entry);
+				_queue.push_back(*entry);
+			}
+
+			out = entry->Value;
+			return true;
+		}
+
+		virtual void Set(KeyPassingType key, ValuePassingType value)
+		{
+			const size_t hash = _index.GetHash(key);
+
+			if (Entry* const entry = _index.Find(key, hash))
+			{
+				const size_t oldSize = _sizeMapper(entry->Value);
+				entry->Value = value;
+				_size -= oldSize;
+
+				_queue.erase(*entry);
+				_queue.push_back(*entry);
+			}
+			else
+			{
+				_index.Reserve();
+
+				Entry* const newEntry = new Entry(key, value, hash);
+				_index.Insert(newEntry);
+				_queue.push_back(*newEntry);
+			}
+
+			_size += _sizeMapper(value);
+
+			EvictExpired();
+		}
+
+		virtual bool TryRemove(KeyPassingType key)
+		{
+			Entry* const entry = _index.Find(key, _index.GetHash(key));
+			if (!entry)
+				return false;
+
+			DoRemove(entry);
+			return true;
+		}
+
+		virtual void Clear()
+		{
+			while (!_queue.empty())
+			{
+				Entry& entry = *_queue.begin();
+				_queue.erase(entry);
+				delete &entry;
+			}
+
+			_index.Clear();
+			_size = 0;
+		}
+
+		virtual size_t GetSize() const
+		{ return _size; }
+
+		virtual signal_connector<OnEvictedSignature> OnEvicted() const
+		{ return _onEvicted.connector(); }
+
+	private:
+		void EvictExpired()
+		{
+			while (_size > _capacity)
+			{
+				STINGRAYKIT_CHECK(!_queue.empty(), StringBuilder() % "Size limit reached, but the queue is empty. Size: " % _size % ", capacity: " % _capacity);
+
+				Entry* const entry = &*_queue.begin();
+
+				const Key_ key = entry->Key;
+				const Value_ value = entry->Value;
+
+				DoRemove(entry);
+
+				_onEvicted(key, value);
+			}
+		}
+
+		void DoRemove(Entry* entry)
+		{
+			_index.Remove(entry);
+
+			_size -= _sizeMapper(entry->Value);
+			_queue.erase(*entry);
+			delete entry;
+		}
+	};
+
+
+	template < typename Key_, typename Value_, typename SizeMapper_ = DefaultCacheSizeMapper, typename Hash_ = hashers::Hash, typename Equals_ = comparers::Equals >
+	struct HashFifoCache
+	{
+		typedef HashQueueCache<Key_, Value_, QueueEvictionPolicy::Fifo, SizeMapper_, Hash_, Equals_> ValueT;
+	};
+
+
+	template < typename Key_, typename Value_, typename SizeMapper_ = DefaultCacheSizeMapper, typename Hash_ = hashers::Hash, typename Equals_ = comparers::Equals >
+	struct HashLruCache
+	{
+		typedef HashQueueCache<Key_, Value_, QueueEvictionPolicy::Lru, SizeMapper_, Hash_, Equals_> ValueT;
+	};
+
+	/** @} */
+
+}
+
+#endif
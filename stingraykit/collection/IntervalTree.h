@@ -9,12 +9,19 @@
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <stingraykit/collection/iterator_base.h>
+#include <stingraykit/exception.h>
 
-#include <list>
+#include <algorithm>
+#include <vector>
 
 namespace stingray
 {
 
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
 	namespace Detail
 	{
 		template < typename T >
@@ -27,282 +34,379 @@ namespace stingray
 		};
 	}
 
-#if 0
 
+	/**
+	 * @brief Multiset of intervals [left, right) ordered by the left point, with stabbing and overlap queries in O(log n + k)
+	 * @par It's a treap, i.e. a binary search tree balanced by random heap priorities, every node keeps the maximum right point of its subtree,
+	 * so the subtrees that end before the queried point are skipped. The intervals with the same left point are kept in the insertion order.
+	 * @par The iterators are bidirectional and constant, as the intervals may not be changed in place. Insert doesn't invalidate them,
+	 * erase invalidates only the erased one.
+	 */
 	template < typename T, typename IntervalPointsGetter = Detail::DefaultIntervalPointsGetter<T> >
-	class IntervalTree // TODO: Implement balancing
+	class IntervalTree
 	{
-	private:
 		typedef typename IntervalPointsGetter::PointType	PointType;
-		typedef std::list<T>								Intervals;
-		typedef Intervals::iterator							IntervalsIterator;
 
 		struct Node
 		{
-			PointType	Point;
+			T			Value;
+			PointType	MaxRight; // of the subtree
+			u32			Priority;
 			Node*		Parent;
 			Node*		Left;
 			Node*		Right;
-			Intervals	Intervals;
 
-			Node(const PointType& point, Node* parent)
-				: Point(point), Parent(parent)
+			Node(const T& value, u32 priority)
+				: Value(value), MaxRight(IntervalPointsGetter::GetRight(value)), Priority(priority), Parent(), Left(), Right()
 			{ }
 		};
 
 	public:
-		template < typename ValueType >
-		class basic_iterator : public iterator_base<iterator, ValueType, std::bidirectional_iterator_tag>
+		class const_iterator : public iterator_base<const_iterator, T, std::bidirectional_iterator_tag, std::ptrdiff_t, const T*, const T&>
 		{
 			friend class IntervalTree;
-			typedef iterator_base<iterator, ValueType, std::bidirectional_iterator_tag>	base;
 
 		private:
-			Node*				_node;
-			IntervalsIterator	_intervalsIt;
+			const IntervalTree*		_tree;
+			Node*					_node;
 
 		public:
-			iterator(Node* node)
-				: _node(node)
-			{ if (node) _intervalsIt = _node->Intervals.begin(); }
+			const_iterator() : _tree(), _node() { }
 
-			iterator(Node* node, const IntervalsIterator& intervalsIt)
-				: _node(node), _intervalsIt(intervalsIt)
-			{ }
-
-			typename base::reference dereference() const;
+			const T& dereference() const
+			{
+				STINGRAYKIT_CHECK(_node, "Invalid iterator!");
+				return _node->Value;
+			}
 
 			bool equal(const const_iterator& other) const
-			{ return _node == other._node && (_intervalsIt == other._intervalsIt || (!_node && !_other._node)); }
+			{ return _node == other._node; }
 
 			void increment()
 			{
-				if (!_node)
-					throw std::runtime_error("Invalid iterator!");
-
-				if (_intervalsIt != _node->Intervals.end())
-					++_intervalsIt;
-
-				if (_intervalsIt == _node->Intervals.end())
+				STINGRAYKIT_CHECK(_node, "Invalid iterator!");
+				if (_node->Right)
+					_node = GetLeftmost(_node->Right);
+				else
 				{
-					do
-					{
-						if (_node->Right != NULL)
-						{
-							_node = _node->Right;
-							while (_node->Left)
-								_node = _node->Left;
-						}
-						else
-						{
-							Node* prev;
-							do { prev = _node; _node = _node->Parent; }
-							while (_node && prev == _node->Right);
-						}
-					} while (_node && _node->Intervals.empty());
-					if (_node)
-						_intervalsIt = _node->Intervals.begin();
+					Node* prev = _node;
+					for (_node = _node->Parent; _node && prev == _node->Right; _node = _node->Parent)
+						prev = _node;
 				}
 			}
 
 			void decrement()
 			{
 				if (!_node)
-					throw std::runtime_error("Invalid iterator!");
-
-				if (_intervalsIt != _node->Intervals.begin())
-					--_intervalsIt;
+					_node = _tree->_root ? GetRightmost(_tree->_root) : NULL;
+				else if (_node->Left)
+					_node = GetRightmost(_node->Left);
 				else
 				{
-					do
-					{
-						if (_node->Left != NULL)
-						{
-							_node = _node->Left;
-							while (_node->Right)
-								_node = _node->Right;
-						}
-						else
-						{
-							Node* prev;
-							do { prev = _node; _node = _node->Parent; }
-							while (_node && prev == _node->Left);
-						}
-					} while (_node && _node->Intervals.empty());
-					if (!_node)
-						throw std::runtime_error("Invalid iterator!");
-					_intervalsIt = --_node->Intervals.end();
+					Node* prev = _node;
+					for (_node = _node->Parent; _node && prev == _node->Left; _node = _node->Parent)
+						prev = _node;
 				}
+				STINGRAYKIT_CHECK(_node, "Invalid iterator!");
 			}
-		}
 
-		typedef basic_iterator<T>		iterator;
-		typedef basic_iterator<const T>	const_iterator;
-		typedef T						value_type;
+		private:
+			const_iterator(const IntervalTree* tree, Node* node) : _tree(tree), _node(node) { }
+		};
+
+		typedef const_iterator		iterator;
+		typedef T					value_type;
 
 	private:
 		Node*		_root;
 		size_t		_size;
+		u32			_seed;
 
 	public:
 		IntervalTree()
-			: _root(NULL), _size(0)
+			: _root(), _size(), _seed(InitialSeed())
 		{ }
 
+		/// @brief Builds a perfectly balanced tree in O(n) if the intervals are sorted by the left point, sorts them first otherwise
+		template < typename InputIterator >
+		IntervalTree(InputIterator first, InputIterator last)
+			: _root(), _size(), _seed(InitialSeed())
+		{ assign(first, last); }
+
+		IntervalTree(const IntervalTree& other)
+			: _root(), _size(), _seed(InitialSeed())
+		{ assign(other.begin(), other.end()); }
+
 		~IntervalTree()
 		{ DeleteNode(_root); }
 
-		iterator begin()
+		IntervalTree& operator = (const IntervalTree& other)
 		{
-			Node* n = _node;
-			while (n->Left) n = n->Left;
-			return iterator(n);
+			if (this != &other)
+				assign(other.begin(), other.end());
+			return *this;
 		}
 
-		const_iterator begin() const
+		iterator begin() const			{ return iterator(this, _root ? GetLeftmost(_root) : NULL); }
+		iterator end() const			{ return iterator(this, NULL); }
+
+		size_t size() const				{ return _size; }
+		bool empty() const				{ return _size == 0; }
+
+		iterator insert(const T& val)
 		{
-			Node* n = _node;
-			while (n->Left) n = n->Left;
-			return const_iterator(n);
+			Node* const node = new Node(val, NextPriority());
+
+			Node* parent = NULL;
+			Node** where = &_root;
+			while (*where)
+			{
+				parent = *where;
+				parent->MaxRight = std::max(parent->MaxRight, node->MaxRight);
+				where = IntervalPointsGetter::GetLeft(val) < IntervalPointsGetter::GetLeft(parent->Value) ? &parent->Left : &parent->Right;
+			}
+			node->Parent = parent;
+			*where = node;
+
+			while (node->Parent && node->Parent->Priority < node->Priority)
+				node == node->Parent->Left ? RotateRight(node->Parent) : RotateLeft(node->Parent);
+
+			++_size;
+			return iterator(this, node);
 		}
 
-		iterator end()				{ return iterator(NULL); }
-		const_iterator end() const	{ return const_iterator(NULL); }
+		template < typename InputIterator >
+		void assign(InputIterator first, InputIterator last)
+		{
+			clear();
 
-		size_t size() const			{ return _size; }
+			std::vector<T> values(first, last);
+			if (!IsSorted(values))
+				std::stable_sort(values.begin(), values.end(), &LeftIsLess);
 
-		void insert(const T& val)	{ InsertValue(_root, NULL, val); }
+			_root = Build(values, 0, values.size(), NULL, 0);
+			_size = values.size();
+		}
 
 		void erase(const iterator& it)
 		{
-			if (!it._node)
-				throw std::runtime_error("Invalid iterator!");
-			it._node->Intervals.erase(it._intervalsIt); // the iterator is invalidated
-			RemoveNodes(it._node);
+			Node* const node = it._node;
+			STINGRAYKIT_CHECK(node, "Invalid iterator!");
+
+			while (node->Left || node->Right)
+			{
+				if (!node->Right || (node->Left && node->Left->Priority > node->Right->Priority))
+					RotateRight(node);
+				else
+					RotateLeft(node);
+			}
+
+			Node* const parent = node->Parent;
+			GetLink(node) = NULL;
+			delete node;
+			--_size;
+
+			for (Node* ancestor = parent; ancestor; ancestor = ancestor->Parent)
+				Update(ancestor);
 		}
 
 		void clear()
 		{
-			STINGRAYKIT_THROW(NotImplementedException);
+			DeleteNode(_root);
+			_root = NULL;
+			_size = 0;
 		}
 
+		/// @brief Outputs the intervals that contain the point: left <= p < right, ordered by the left point
 		template < typename OutputIter >
 		void get_intersecting(const PointType& p, OutputIter it) const
-		{
-			STINGRAYKIT_THROW(NotImplementedException);
-		}
+		{ GetIntersecting(_root, PointQuery(p), it); }
+
+		/// @brief Outputs the intervals that overlap [l, r), ordered by the left point
+		/// @par The empty intervals and the empty query are treated as points: a point interval matches if l <= point < r, an empty query matches
+		/// the intervals that contain it and the point intervals equal to it
+		template < typename OutputIter >
+		void get_intersecting(const PointType& l, const PointType& r, OutputIter it) const
+		{ GetIntersecting(_root, RangeQuery(l, r), it); }
 
 		template < typename OutputIter >
 		void get_intersecting(const T& val, OutputIter it) const
+		{ get_intersecting(IntervalPointsGetter::GetLeft(val), IntervalPointsGetter::GetRight(val), it); }
+
+	private:
+		struct PointQuery
 		{
-			STINGRAYKIT_THROW(NotImplementedException);
+			PointType	Point;
+
+			explicit PointQuery(const PointType& point) : Point(point) { }
+
+			bool MayBeInSubtree(const PointType& maxRight) const	{ return Point < maxRight; }
+			bool MayBeToTheRight(const PointType& left) const		{ return !(Point < left); }
+
+			bool Matches(const T& val) const
+			{ return !(Point < IntervalPointsGetter::GetLeft(val)) && Point < IntervalPointsGetter::GetRight(val); }
+		};
+
+		struct RangeQuery
+		{
+			PointType	L;
+			PointType	R;
+
+			RangeQuery(const PointType& l, const PointType& r) : L(l), R(r) { }
+
+			bool MayBeInSubtree(const PointType& maxRight) const	{ return !(maxRight < L); }
+			bool MayBeToTheRight(const PointType& left) const		{ return !(R < left); }
+
+			bool Matches(const T& val) const
+			{
+				const PointType left = IntervalPointsGetter::GetLeft(val);
+				const PointType right = IntervalPointsGetter::GetRight(val);
+
+				// Boundary conditions for noncontinious events must be not strict
+				if (R == L && left == right && L == left)
+					return true;
+				if (left == right)
+					return !(left >= R || right < L);
+				if (R == L)
+					return !(left > R || right <= L);
+				return !(left >= R || right <= L);
+			}
+		};
+
+		template < typename Query_, typename OutputIter >
+		static void GetIntersecting(const Node* node, const Query_& query, OutputIter& it)
+		{
+			// the left subtree is always worth a visit if its max right fits, the right one only if its left points may still fit
+			while (node && query.MayBeInSubtree(node->MaxRight))
+			{
+				GetIntersecting(node->Left, query, it);
+
+				if (!query.MayBeToTheRight(IntervalPointsGetter::GetLeft(node->Value)))
+					return;
+
+				if (query.Matches(node->Value))
+					*it++ = node->Value;
+
+				node = node->Right;
+			}
 		}
 
-	private:
-		IntervalTree(const IntervalTree&);
-		void operator = (const IntervalTree&);
+		static u32 InitialSeed()
+		{ return 2463534242u; }
 
-		static bool IntervalIsAtLeft(const t& val, const PointType& point)
-		{ return IntervalPointsGetter::GetRight(val) <= point; }
+		u32 NextPriority()
+		{
+			// xorshift32
+			_seed ^= _seed << 13;
+			_seed ^= _seed >> 17;
+			_seed ^= _seed << 5;
+			return _seed;
+		}
 
-		static bool IntervalIsAtRight(const t& val, const PointType& point)
-		{ return IntervalPointsGetter::GetLeft(val) > point; }
+		static bool LeftIsLess(const T& lhs, const T& rhs)
+		{ return IntervalPointsGetter::GetLeft(lhs) < IntervalPointsGetter::GetLeft(rhs); }
 
-		static bool Intersects(const T& val, const PointType& point)
-		{ return !IntervalIsAtLeft(val, point) && !IntervalIsAtRight(val, point); }
+		static bool IsSorted(const std::vector<T>& values)
+		{
+			for (size_t i = 1; i < values.size(); ++i)
+				if (LeftIsLess(values[i], values[i - 1]))
+					return false;
+			return true;
+		}
 
-		void RemoveNodes(Node* where)
+		/// @brief The priorities decrease with the depth, so that the heap order holds, the low bits are random for the later inserts
+		Node* Build(const std::vector<T>& values, size_t begin, size_t end, Node* parent, u32 depth)
 		{
-			if (!where || where->Left || where->Right || !where->Intervals.empty())
-				return;
-
-			Node* parent = where->Parent;
-			if (where == _root)
-				_root = NULL;
-			delete where;
-			RemoveNodes(parent);
+			if (begin == end)
+				return NULL;
+
+			const size_t middle = begin + (end - begin) / 2;
+			Node* const node = new Node(values[middle], ((31 - std::min<u32>(depth, 31)) << 27) | (NextPriority() >> 5));
+			node->Parent = parent;
+			node->Left = Build(values, begin, middle, node, depth + 1);
+			node->Right = Build(values, middle + 1, end, node, depth + 1);
+			Update(node);
+			return node;
 		}
 
-		static void InsertValue(Node*& where, Node* parent, const T& val)
+		static void Update(Node* node)
 		{
-			if (!where)
-				where = new Node((IntervalPointsGetter::GetLeft(val) + IntervalPointsGetter::GetRight(val)) / 2, parent);
-
-			if (Intersects(val, where->Point))
-				where->Intervals.push_back(val);
-			else if (IntervalIsAtLeft(val, where->Point))
-				InsertNode(where->Left, where, val);
-			else if (IntervalIsAtRight(val, where->Point))
-				InsertNode(where->Right, where, val);
+			node->MaxRight = IntervalPointsGetter::GetRight(node->Value);
+			if (node->Left)
+				node->MaxRight = std::max(node->MaxRight, node->Left->MaxRight);
+			if (node->Right)
+				node->MaxRight = std::max(node->MaxRight, node->Right->MaxRight);
 		}
 
-		static void DeleteNode(const Node* node)
+		Node*& GetLink(Node* node)
 		{
-			if (!node)
-				return;
-			DeleteNode(node->Left);
-			DeleteNode(node->Right);
-			delete node;
+			if (!node->Parent)
+				return _root;
+			return node == node->Parent->Left ? node->Parent->Left : node->Parent->Right;
 		}
-	};
 
-#endif
+		void RotateLeft(Node* node)
+		{
+			Node* const pivot = node->Right;
+			GetLink(node) = pivot;
+			pivot->Parent = node->Parent;
 
-	template < typename T, typename IntervalPointsGetter = Detail::DefaultIntervalPointsGetter<T> >
-	class IntervalTree // TODO: remove this stupid stub after developing a normal implementation
-	{
-		typedef std::list<T>								Collection;
-		typedef typename IntervalPointsGetter::PointType	PointType;
+			node->Right = pivot->Left;
+			if (node->Right)
+				node->Right->Parent = node;
 
-		Collection		_collection;
+			pivot->Left = node;
+			node->Parent = pivot;
 
-	public:
-		typedef typename Collection::value_type		value_type;
-		typedef typename Collection::iterator		iterator;
-		typedef typename Collection::const_iterator	const_iterator;
+			Update(node);
+			Update(pivot);
+		}
 
-		iterator begin()				{ return _collection.begin(); }
-		const_iterator begin() const	{ return _collection.begin(); }
-		iterator end()					{ return _collection.end(); }
-		const_iterator end() const		{ return _collection.end(); }
+		void RotateRight(Node* node)
+		{
+			Node* const pivot = node->Left;
+			GetLink(node) = pivot;
+			pivot->Parent = node->Parent;
 
-		size_t size() const				{ return _collection.size(); }
-		void insert(const T& val)		{ _collection.push_back(val); }
-		void erase(const iterator& it)	{ _collection.erase(it); }
-		void clear()					{ _collection.clear(); }
+			node->Left = pivot->Right;
+			if (node->Left)
+				node->Left->Parent = node;
 
-		template < typename OutputIter >
-		void get_intersecting(const PointType& p, OutputIter it) const
+			pivot->Right = node;
+			node->Parent = pivot;
+
+			Update(node);
+			Update(pivot);
+		}
+
+		static Node* GetLeftmost(Node* node)
 		{
-			for (const_iterator i = begin(); i != end(); ++i)
-				if (IntervalPointsGetter::GetLeft(*i) <= p && p < IntervalPointsGetter::GetRight(*i))
-					*it++ = *i;
+			while (node->Left)
+				node = node->Left;
+			return node;
 		}
 
-		template < typename OutputIter >
-		void get_intersecting(const PointType& l, const PointType& r, OutputIter it) const
+		static Node* GetRightmost(Node* node)
 		{
-			for (const_iterator i = begin(); i != end(); ++i) {
-			// Boundary conditions for noncontinious events must be not strict
-			// Yes, this conditions can be written in a single line, but it will be very difficult to read
-				if (r == l && IntervalPointsGetter::GetLeft(*i) == IntervalPointsGetter::GetRight(*i) && l == IntervalPointsGetter::GetLeft(*i))
-						*it++ = *i;
-				else if (IntervalPointsGetter::GetLeft(*i) == IntervalPointsGetter::GetRight(*i) &&
-					!(IntervalPointsGetter::GetLeft(*i) >= r || IntervalPointsGetter::GetRight(*i) < l))
-						*it++ = *i;
-				else if (r == l &&
-					!(IntervalPointsGetter::GetLeft(*i) > r || IntervalPointsGetter::GetRight(*i) <= l))
-						*it++ = *i;
-				else if (!(IntervalPointsGetter::GetLeft(*i) >= r || IntervalPointsGetter::GetRight(*i) <= l))
-						*it++ = *i;
-			}
+			while (node->Right)
+				node = node->Right;
+			return node;
 		}
 
-		template < typename OutputIter >
-		void get_intersecting(const T& val, OutputIter it) const
-		{ get_intersecting(IntervalPointsGetter::GetLeft(val), IntervalPointsGetter::GetRight(val)); }
+		static void DeleteNode(Node* node)
+		{
+			while (node)
+			{
+				DeleteNode(node->Left);
+				Node* const right = node->Right;
+				delete node;
+				node = right;
+			}
+		}
 	};
 
+	/** @} */
+
 }
 
 
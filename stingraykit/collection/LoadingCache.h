@@ -0,0 +1,324 @@
+#ifndef STINGRAYKIT_COLLECTION_LOADINGCACHE_H
+#define STINGRAYKIT_COLLECTION_LOADINGCACHE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/CacheStats.h>
+#include <stingraykit/collection/ICache.h>
+#include <stingraykit/compare/comparers.h>
+#include <stingraykit/function/bind.h>
+#include <stingraykit/signal/signals.h>
+#include <stingraykit/thread/DummyCancellationToken.h>
+#include <stingraykit/thread/ITaskExecutor.h>
+#include <stingraykit/thread/Thread.h>
+#include <stingraykit/time/TimeEngine.h>
+#include <stingraykit/future.h>
+#include <stingraykit/TaskLifeToken.h>
+
+#include <map>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief Thread-safe cache that loads missing values with the loader function, each key is loaded by one caller at a time,
+	 * the other callers that miss the same key wait for the result of that load instead of loading it again
+	 * @par The values are kept in a single-threaded storage cache (e.g. HashLruCache of LoadedValue), which is only accessed with the LoadingCache mutex locked,
+	 * so OnEvicted is invoked with that mutex locked too. If refreshAfter is given, a value older than that is returned as is, but is reloaded in the background
+	 * by the refresh executor, so that the hot keys don't miss once the storage expires them.
+	 * A value that is being loaded is not cached if the key is set, removed or the cache is cleared meanwhile, though it is still returned to the waiting callers.
+	 */
+	template < typename Key_, typename Value_, typename Less_ = comparers::Less >
+	class LoadingCache : public virtual ICache<Key_, Value_>
+	{
+		STINGRAYKIT_NONCOPYABLE(LoadingCache);
+
+		typedef ICache<Key_, Value_> Base;
+
+		typedef typename Base::KeyPassingType KeyPassingType;
+		typedef typename Base::ValuePassingType ValuePassingType;
+
+		typedef typename Base::OnEvictedSignature OnEvictedSignature;
+
+	public:
+		struct LoadedValue
+		{
+			Value_		Value;
+			u64			LoadTime; // monotonic microseconds
+
+		public:
+			LoadedValue() : Value(), LoadTime()
+			{ }
+
+			LoadedValue(ValuePassingType value, u64 loadTime) : Value(value), LoadTime(loadTime)
+			{ }
+		};
+
+		typedef ICache<Key_, LoadedValue>			Storage;
+		typedef shared_ptr<Storage>					StoragePtr;
+
+		typedef function<Value_ (KeyPassingType)>	Loader;
+
+	private:
+		struct PendingLoad
+		{
+			promise<Value_>			Promise;
+			shared_future<Value_>	Future;
+
+		public:
+			PendingLoad() : Future(Promise.get_future().share())
+			{ }
+		};
+		STINGRAYKIT_DECLARE_PTR(PendingLoad);
+
+		/// @brief Runs the load, and fails it and forgets it if it was not completed, so that neither a loader throwing something
+		/// that is not a std::exception nor a refresh task dropped by the executor leave the waiting callers hanging
+		class PendingLoadGuard
+		{
+			STINGRAYKIT_NONCOPYABLE(PendingLoadGuard);
+
+		private:
+			LoadingCache*			_cache;
+			Key_					_key;
+			PendingLoadPtr			_load;
+			FutureExecutionTester	_tester; // the cache may be gone by the time the executor drops the task
+
+		public:
+			PendingLoadGuard(LoadingCache* cache, const Key_& key, const PendingLoadPtr& load, const FutureExecutionTester& tester)
+				:	_cache(cache), _key(key), _load(load), _tester(tester)
+			{ }
+
+			~PendingLoadGuard()
+			{
+				if (_load->Future.is_ready())
+					return;
+
+				LocalExecutionGuard guard(_tester);
+				if (guard)
+					_cache->FailLoad(_key, _load, make_exception_ptr(BrokenPromise()));
+				else
+					_load->Promise.set_exception(make_exception_ptr(BrokenPromise()));
+			}
+
+			void Run()
+			{ _cache->Load(_key, _load); }
+		};
+		STINGRAYKIT_DECLARE_PTR(PendingLoadGuard);
+
+		typedef std::map<Key_, PendingLoadPtr, Less_> PendingLoads;
+
+	private:
+		Mutex							_mutex;
+		StoragePtr						_storage;
+		Loader							_loader;
+
+		optional<TimeDuration>			_refreshAfter;
+		ITaskExecutorPtr				_refreshExecutor;
+
+		PendingLoads					_pendingLoads;
+		CacheStats						_stats;
+
+		signal<OnEvictedSignature>		_onEvicted;
+		Token							_connection;
+
+		TaskLifeToken					_refreshLifeToken;
+
+	public:
+		LoadingCache(const StoragePtr& storage, const Loader& loader)
+			:	_storage(STINGRAYKIT_REQUIRE_NOT_NULL(storage)),
+				_loader(loader)
+		{ _connection = _storage->OnEvicted().connect(bind(&LoadingCache::OnStorageEvicted, this, _1, _2)); }
+
+		LoadingCache(const StoragePtr& storage, const Loader& loader, TimeDuration refreshAfter, const ITaskExecutorPtr& refreshExecutor)
+			:	_storage(STINGRAYKIT_REQUIRE_NOT_NULL(storage)),
+				_loader(loader),
+				_refreshAfter(refreshAfter),
+				_refreshExecutor(STINGRAYKIT_REQUIRE_NOT_NULL(refreshExecutor))
+		{ _connection = _storage->OnEvicted().connect(bind(&LoadingCache::OnStorageEvicted, this, _1, _2)); }
+
+		virtual ~LoadingCache()
+		{ _refreshLifeToken.Release(); }
+
+		/// @brief Returns the cached value, or loads it if it is missing
+		/// @par The loader exception is rethrown to every caller waiting for that load
+		Value_ Get(KeyPassingType key, const ICancellationToken& token = DummyCancellationToken())
+		{
+			PendingLoadPtr load;
+			bool loadHere = false;
+			{
+				MutexLock l(_mutex);
+
+				LoadedValue loaded;
+				if (_storage->TryGet(key, loaded))
+				{
+					++_stats.Hits;
+
+					const PendingLoadPtr refresh = TryStartRefresh(key, loaded);
+					if (refresh)
+					{
+						MutexUnlock ul(l);
+						ScheduleRefresh(key, refresh);
+					}
+					return loaded.Value;
+				}
+
+				++_stats.Misses;
+
+				const typename PendingLoads::const_iterator it = _pendingLoads.find(key);
+				if (it != _pendingLoads.end())
+					load = it->second;
+				else
+				{
+					load = make_shared<PendingLoad>();
+					_pendingLoads.insert(std::make_pair(key, load));
+					loadHere = true;
+				}
+			}
+
+			if (loadHere)
+				PendingLoadGuard(this, key, load, null).Run();
+
+			load->Future.wait(token);
+			STINGRAYKIT_CHECK(load->Future.is_ready(), OperationCancelledException());
+			return load->Future.get();
+		}
+
+		virtual bool TryGet(KeyPassingType key, Value_& out)
+		{
+			MutexLock l(_mutex);
+
+			LoadedValue loaded;
+			if (!_storage->TryGet(key, loaded))
+			{
+				++_stats.Misses;
+				return false;
+			}
+
+			++_stats.Hits;
+			out = loaded.Value;
+			return true;
+		}
+
+		virtual void Set(KeyPassingType key, ValuePassingType value)
+		{
+			MutexLock l(_mutex);
+			_pendingLoads.erase(key);
+			_storage->Set(key, LoadedValue(value, TimeEngine::GetMonotonicMicroseconds()));
+		}
+
+		virtual bool TryRemove(KeyPassingType key)
+		{
+			MutexLock l(_mutex);
+			_pendingLoads.erase(key);
+			return _storage->TryRemove(key);
+		}
+
+		virtual void Clear()
+		{
+			MutexLock l(_mutex);
+			_pendingLoads.clear();
+			_storage->Clear();
+		}
+
+		virtual size_t GetSize() const
+		{
+			MutexLock l(_mutex);
+			return _storage->GetSize();
+		}
+
+		virtual signal_connector<OnEvictedSignature> OnEvicted() const
+		{ return _onEvicted.connector(); }
+
+		/// @brief Evictions are all the removals reported by the storage OnEvicted, the expirations are counted by the storage itself
+		CacheStats GetStats() const
+		{
+			MutexLock l(_mutex);
+			return _stats;
+		}
+
+	private:
+		PendingLoadPtr TryStartRefresh(KeyPassingType key, const LoadedValue& loaded)
+		{
+			if (!_refreshAfter || TimeEngine::GetMonotonicMicroseconds() - loaded.LoadTime < (u64)_refreshAfter->GetMicroseconds())
+				return null;
+
+			if (_pendingLoads.find(key) != _pendingLoads.end())
+				return null;
+
+			const PendingLoadPtr load = make_shared<PendingLoad>();
+			_pendingLoads.insert(std::make_pair(key, load));
+			return load;
+		}
+
+		void ScheduleRefresh(const Key_& key, const PendingLoadPtr& load)
+		{
+			const PendingLoadGuardPtr guard = make_shared<PendingLoadGuard>(this, key, load, _refreshLifeToken.GetExecutionTester());
+			try
+			{ _refreshExecutor->AddTask(bind(&PendingLoadGuard::Run, guard), _refreshLifeToken.GetExecutionTester()); }
+			catch (const std::exception& ex)
+			{ FailLoad(key, load, make_exception_ptr(ex)); }
+		}
+
+		void Load(const Key_& key, const PendingLoadPtr& load)
+		{
+			try
+			{
+				const u64 loadStart = TimeEngine::GetMonotonicMicroseconds();
+				const Value_ value = _loader(key);
+				const u64 loadTime = TimeEngine::GetMonotonicMicroseconds() - loadStart;
+				{
+					MutexLock l(_mutex);
+					++_stats.Loads;
+					_stats.LoadTime += TimeDuration::FromMicroseconds(loadTime);
+					if (TakePendingLoad(key, load))
+						_storage->Set(key, LoadedValue(value, TimeEngine::GetMonotonicMicroseconds()));
+				}
+				load->Promise.set_value(value);
+			}
+			catch (const std::exception& ex)
+			{ FailLoad(key, load, make_exception_ptr(ex)); }
+		}
+
+		void FailLoad(const Key_& key, const PendingLoadPtr& load, const exception_ptr& ex)
+		{
+			{
+				MutexLock l(_mutex);
+				TakePendingLoad(key, load);
+			}
+			load->Promise.set_exception(ex);
+		}
+
+		bool TakePendingLoad(const Key_& key, const PendingLoadPtr& load)
+		{
+			const typename PendingLoads::iterator it = _pendingLoads.find(key);
+			if (it == _pendingLoads.end() || it->second != load)
+				return false;
+
+			_pendingLoads.erase(it);
+			return true;
+		}
+
+		void OnStorageEvicted(KeyPassingType key, const LoadedValue& value)
+		{
+			// a storage with its own expiry timer notifies from the timer thread
+			MutexLock l(_mutex);
+			++_stats.Evictions;
+			_onEvicted(key, value.Value);
+		}
+	};
+
+	/** @} */
+
+}
+
+#endif
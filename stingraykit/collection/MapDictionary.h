@@ -8,6 +8,7 @@
 // IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <stingraykit/collection/btree_map.h>
 #include <stingraykit/collection/EnumerableHelpers.h>
 #include <stingraykit/collection/EnumeratorFromStlContainer.h>
 #include <stingraykit/collection/EnumeratorWrapper.h>
@@ -15,9 +16,11 @@
 #include <stingraykit/collection/ForEach.h>
 #include <stingraykit/collection/IDictionary.h>
 #include <stingraykit/collection/KeyNotFoundExceptionCreator.h>
+#include <stingraykit/collection/persistent_map.h>
 #include <stingraykit/compare/comparers.h>
 
 #include <map>
+#include <vector>
 
 namespace stingray
 {
@@ -61,7 +64,10 @@ namespace stingray
 			ReverseEnumerable(const HolderPtr& holder) : _holder(holder) { }
 
 			virtual shared_ptr<IEnumerator<PairType> > GetEnumerator() const
-			{ return WrapMapEnumerator(EnumeratorFromStlIterators(_holder->Map->rbegin(), _holder->Map->rend(), _holder)); }
+			{
+				const MapType& map = *_holder->Map;
+				return WrapMapEnumerator(EnumeratorFromStlIterators(map.rbegin(), map.rend(), _holder));
+			}
 		};
 
 	private:
@@ -154,11 +160,9 @@ namespace stingray
 		virtual void Set(const KeyType& key, const ValueType& value)
 		{
 			CopyOnWrite();
-			typename MapType::iterator it = _map->find(key);
-			if (it != _map->end())
-				it->second = value;
-			else
-				_map->insert(std::make_pair(key, value));
+			const std::pair<typename MapType::iterator, bool> res = _map->insert(std::make_pair(key, value));
+			if (!res.second)
+				res.first->second = value;
 		}
 
 		virtual void Remove(const KeyType& key)
@@ -177,18 +181,20 @@ namespace stingray
 
 		virtual size_t RemoveWhere(const function<bool (const KeyType&, const ValueType&)>& pred)
 		{
-			CopyOnWrite();
-			size_t ret = 0;
-			for (typename MapType::iterator it = _map->begin(); it != _map->end(); )
-			{
-				const typename MapType::iterator cur = it++;
-				if (!pred(cur->first, cur->second))
-					continue;
+			// erasing invalidates the following iterators of flat_map, persistent_map and btree_map, so the keys are collected first
+			std::vector<KeyType> keys;
+			const MapType& map = *_map;
+			for (typename MapType::const_iterator it = map.begin(); it != map.end(); ++it)
+				if (pred(it->first, it->second))
+					keys.push_back(it->first);
 
-				_map->erase(cur);
-				++ret;
-			}
-			return ret;
+			if (keys.empty())
+				return 0;
+
+			CopyOnWrite();
+			for (typename std::vector<KeyType>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+				_map->erase(*it);
+			return keys.size();
 		}
 
 		virtual void Clear()
@@ -233,6 +239,25 @@ namespace stingray
 	struct FlatMapDictionary
 	{ typedef MapDictionary<KeyType, ValueType, CompareType, flat_map, AllocatorType>		Type; };
 
+	/// @brief Copy-on-write takes O(1) and the following modifications O(log n) each, instead of copying the whole map
+	template <
+			typename KeyType,
+			typename ValueType,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename persistent_map<KeyType, ValueType, CompareType>::allocator_type
+			>
+	struct PersistentMapDictionary
+	{ typedef MapDictionary<KeyType, ValueType, CompareType, persistent_map, AllocatorType>	Type; };
+
+	template <
+			typename KeyType,
+			typename ValueType,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_map<KeyType, ValueType, CompareType>::allocator_type
+			>
+	struct BTreeMapDictionary
+	{ typedef MapDictionary<KeyType, ValueType, CompareType, btree_map, AllocatorType>		Type; };
+
 	/** @} */
 
 }
@@ -45,6 +45,15 @@ namespace stingray
 	struct FlatMapObservableDictionary
 	{ typedef MapObservableDictionary<KeyType, ValueType, CompareType, flat_map, AllocatorType>		Type; };
 
+	template <
+			typename KeyType,
+			typename ValueType,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_map<KeyType, ValueType, CompareType>::allocator_type
+			>
+	struct BTreeMapObservableDictionary
+	{ typedef MapObservableDictionary<KeyType, ValueType, CompareType, btree_map, AllocatorType>		Type; };
+
 	/** @} */
 
 }
@@ -0,0 +1,785 @@
+#ifndef STINGRAYKIT_COLLECTION_PERSISTENTBTREE_H
+#define STINGRAYKIT_COLLECTION_PERSISTENTBTREE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/thread/atomic/AtomicInt.h>
+#include <stingraykit/aligned_storage.h>
+
+#include <algorithm>
+#include <new>
+
+namespace stingray
+{
+
+	namespace Detail
+	{
+
+		/**
+		 * @brief B+tree with reference counted nodes, a copy of the tree shares all the nodes with the original one
+		 * @par A modification copies the shared nodes on the path to the modified leaf (path copying) and modifies the rest in place,
+		 * so it takes O(log n) whether the tree was copied or not. The nodes have no parent or sibling pointers, the positions are
+		 * leaf and index pairs, and moving to the next leaf searches it from the root by the key of the current leaf edge.
+		 * @par The separator keys of the inner nodes satisfy: every key of child i < key i <= every key of child i + 1.
+		 * The reference counters are atomic and copying does not modify the source, so the copies may be read, copied and destroyed from different threads,
+		 * but each copy is not thread-safe by itself.
+		 */
+		template < typename Key_, typename Value_, typename KeyOfValue_, typename Compare_, typename Allocator_ >
+		class PersistentBTree
+		{
+			static const size_t NodeBytes = 256;
+
+		public:
+			static const size_t LeafCapacity = NodeBytes / sizeof(Value_) > 4 ? NodeBytes / sizeof(Value_) : 4;
+			static const size_t InnerCapacity = NodeBytes / (sizeof(Key_) + sizeof(void*)) > 4 ? NodeBytes / (sizeof(Key_) + sizeof(void*)) : 4;
+
+		private:
+			struct Node
+			{
+				AtomicU32::Type		RefCount;
+				u16					Count; // values in a leaf, children in an inner node
+				bool				IsLeaf;
+
+				explicit Node(bool isLeaf) : RefCount(1), Count(), IsLeaf(isLeaf) { }
+			};
+
+			struct Leaf : public Node
+			{
+				StorageFor<Value_>	Values[LeafCapacity];
+
+				Leaf() : Node(true) { }
+			};
+
+			struct Inner : public Node
+			{
+				StorageFor<Key_>	Keys[InnerCapacity - 1];
+				Node*				Children[InnerCapacity];
+
+				Inner() : Node(false) { }
+			};
+
+			typedef typename Allocator_::template rebind<Leaf>::other	LeafAllocator;
+			typedef typename Allocator_::template rebind<Inner>::other	InnerAllocator;
+
+		public:
+			struct Position
+			{
+				Leaf*		LeafNode;
+				size_t		Index;
+
+				Position() : LeafNode(), Index() { }
+				Position(Leaf* leaf, size_t index) : LeafNode(leaf), Index(index) { }
+
+				bool operator == (const Position& other) const	{ return LeafNode == other.LeafNode && Index == other.Index; }
+				bool operator != (const Position& other) const	{ return !(*this == other); }
+			};
+
+		private:
+			Node*					_root;
+			size_t					_size;
+			Compare_				_cmp;
+			KeyOfValue_				_keyOf;
+			LeafAllocator			_leafAllocator;
+			InnerAllocator			_innerAllocator;
+
+		public:
+			PersistentBTree(const Compare_& cmp, const Allocator_& alloc)
+				: _root(), _size(), _cmp(cmp), _leafAllocator(alloc), _innerAllocator(alloc)
+			{ }
+
+			PersistentBTree(const PersistentBTree& other)
+				:	_root(other._root), _size(other._size), _cmp(other._cmp),
+					_leafAllocator(other._leafAllocator), _innerAllocator(other._innerAllocator)
+			{ AddRef(_root); }
+
+			~PersistentBTree()
+			{ Release(_root); }
+
+			PersistentBTree& operator = (const PersistentBTree& other)
+			{
+				PersistentBTree copy(other);
+				Swap(copy);
+				return *this;
+			}
+
+			void Swap(PersistentBTree& other)
+			{
+				std::swap(_root, other._root);
+				std::swap(_size, other._size);
+				std::swap(_cmp, other._cmp);
+				std::swap(_leafAllocator, other._leafAllocator);
+				std::swap(_innerAllocator, other._innerAllocator);
+			}
+
+			size_t GetSize() const				{ return _size; }
+			const Compare_& GetCompare() const	{ return _cmp; }
+			Allocator_ GetAllocator() const		{ return Allocator_(_leafAllocator); }
+
+			void Clear()
+			{
+				Release(_root);
+				_root = NULL;
+				_size = 0;
+			}
+
+			Position Begin() const
+			{
+				if (!_root)
+					return Position();
+				return Position(GetLeftmostLeaf(_root), 0);
+			}
+
+			Position End() const
+			{ return Position(); }
+
+			Position Next(const Position& position) const
+			{
+				if (position.Index + 1 < position.LeafNode->Count)
+					return Position(position.LeafNode, position.Index + 1);
+				return UpperBound(GetKey(position.LeafNode, position.LeafNode->Count - 1));
+			}
+
+			Position Prev(const Position& position) const
+			{
+				if (!position.LeafNode)
+				{
+					Leaf* const leaf = GetRightmostLeaf(_root);
+					return Position(leaf, leaf->Count - 1);
+				}
+
+				if (position.Index != 0)
+					return Position(position.LeafNode, position.Index - 1);
+				return FindLastLess(GetKey(position.LeafNode, 0));
+			}
+
+			static const Value_& GetValue(const Position& position)
+			{ return position.LeafNode->Values[position.Index].Ref(); }
+
+			/// @brief Returns the value for modification, the position must be returned by Insert, since the insertion copies the path to the value
+			static Value_& GetInsertedValue(const Position& position)
+			{ return position.LeafNode->Values[position.Index].Ref(); }
+
+			/// @brief Copies the path to the value if it is shared, returns the position of the value in the copied leaf, so that it may be modified
+			Position UnsharePath(const Position& position)
+			{
+				const Key_& key = GetKey(position.LeafNode, position.Index); // the copied leaf is kept by the other tree that shares it
+				Leaf* const leaf = UnshareLeaf(key);
+				return Position(leaf, LowerBoundInLeaf(leaf, key));
+			}
+
+			/// @brief Returns the value for modification, copies the path to it if it is shared, or returns NULL if there is no such key
+			Value_* FindMutable(const Key_& key)
+			{
+				if (!Find(key).LeafNode)
+					return NULL;
+
+				Leaf* const leaf = UnshareLeaf(key);
+				return &leaf->Values[LowerBoundInLeaf(leaf, key)].Ref();
+			}
+
+			Position Find(const Key_& key) const
+			{
+				const Position result = LowerBound(key);
+				return result.LeafNode && !_cmp(key, GetKey(result.LeafNode, result.Index)) ? result : Position();
+			}
+
+			Position LowerBound(const Key_& key) const
+			{
+				Node* nextSubtree = NULL;
+				Leaf* const leaf = FindLeaf(key, nextSubtree);
+				if (!leaf)
+					return Position();
+
+				const size_t index = LowerBoundInLeaf(leaf, key);
+				if (index < leaf->Count)
+					return Position(leaf, index);
+				return nextSubtree ? Position(GetLeftmostLeaf(nextSubtree), 0) : Position();
+			}
+
+			Position UpperBound(const Key_& key) const
+			{
+				Node* nextSubtree = NULL;
+				Leaf* const leaf = FindLeaf(key, nextSubtree);
+				if (!leaf)
+					return Position();
+
+				const size_t index = UpperBoundInLeaf(leaf, key);
+				if (index < leaf->Count)
+					return Position(leaf, index);
+				return nextSubtree ? Position(GetLeftmostLeaf(nextSubtree), 0) : Position();
+			}
+
+			std::pair<Position, bool> Insert(const Value_& value)
+			{
+				const Key_& key = _keyOf(value);
+
+				const Position existing = Find(key);
+				if (existing.LeafNode)
+					return std::make_pair(existing, false);
+
+				if (!_root)
+					_root = NewLeaf();
+
+				Unshare(_root);
+				if (IsFull(_root))
+				{
+					Inner* const root = NewInner();
+					root->Children[0] = _root;
+					root->Count = 1;
+					_root = root;
+					SplitChild(root, 0);
+				}
+
+				Node* node = _root;
+				while (!node->IsLeaf)
+				{
+					Inner* const inner = static_cast<Inner*>(node);
+					size_t child = FindChild(inner, key);
+
+					Unshare(inner->Children[child]);
+					if (IsFull(inner->Children[child]))
+					{
+						SplitChild(inner, child);
+						if (!_cmp(key, inner->Keys[child].Ref()))
+							++child;
+					}
+
+					node = inner->Children[child];
+				}
+
+				Leaf* const leaf = static_cast<Leaf*>(node);
+				const size_t index = LowerBoundInLeaf(leaf, key);
+				ShiftRight(leaf->Values, index, leaf->Count);
+				try
+				{ leaf->Values[index].Ctor(value); }
+				catch (...)
+				{
+					ShiftLeft(leaf->Values, index, leaf->Count + 1);
+					throw;
+				}
+				++leaf->Count;
+				++_size;
+
+				return std::make_pair(Position(leaf, index), true);
+			}
+
+			bool Erase(const Key_& key)
+			{
+				if (!Find(key).LeafNode)
+					return false;
+
+				Unshare(_root);
+
+				Node* node = _root;
+				while (!node->IsLeaf)
+				{
+					Inner* const inner = static_cast<Inner*>(node);
+					size_t child = FindChild(inner, key);
+
+					Unshare(inner->Children[child]);
+					if (inner->Children[child]->Count <= GetMinCount(inner->Children[child]))
+						child = Fill(inner, child);
+
+					node = inner->Children[child];
+				}
+
+				Leaf* const leaf = static_cast<Leaf*>(node);
+				const size_t index = LowerBoundInLeaf(leaf, key);
+				leaf->Values[index].Dtor();
+				ShiftLeft(leaf->Values, index, leaf->Count);
+				--leaf->Count;
+				--_size;
+
+				if (!_root->IsLeaf && _root->Count == 1)
+				{
+					Inner* const root = static_cast<Inner*>(_root);
+					_root = root->Children[0];
+					root->Count = 0;
+					DeleteInner(root);
+				}
+				else if (_root->IsLeaf && _root->Count == 0)
+				{
+					DeleteLeaf(static_cast<Leaf*>(_root));
+					_root = NULL;
+				}
+
+				return true;
+			}
+
+		private:
+			const Key_& GetKey(const Leaf* leaf, size_t index) const
+			{ return _keyOf(leaf->Values[index].Ref()); }
+
+			static size_t GetMinCount(const Node* node)
+			{ return node->IsLeaf ? LeafCapacity / 2 : InnerCapacity / 2; }
+
+			static bool IsFull(const Node* node)
+			{ return node->Count == (node->IsLeaf ? LeafCapacity : InnerCapacity); }
+
+			/// @brief Returns the number of the separators that are not greater than the key
+			size_t FindChild(const Inner* inner, const Key_& key) const
+			{
+				size_t begin = 0, end = inner->Count - 1;
+				while (begin < end)
+				{
+					const size_t middle = (begin + end) / 2;
+					if (_cmp(key, inner->Keys[middle].Ref()))
+						end = middle;
+					else
+						begin = middle + 1;
+				}
+				return begin;
+			}
+
+			size_t LowerBoundInLeaf(const Leaf* leaf, const Key_& key) const
+			{
+				size_t begin = 0, end = leaf->Count;
+				while (begin < end)
+				{
+					const size_t middle = (begin + end) / 2;
+					if (_cmp(GetKey(leaf, middle), key))
+						begin = middle + 1;
+					else
+						end = middle;
+				}
+				return begin;
+			}
+
+			size_t UpperBoundInLeaf(const Leaf* leaf, const Key_& key) const
+			{
+				size_t begin = 0, end = leaf->Count;
+				while (begin < end)
+				{
+					const size_t middle = (begin + end) / 2;
+					if (_cmp(key, GetKey(leaf, middle)))
+						end = middle;
+					else
+						begin = middle + 1;
+				}
+				return begin;
+			}
+
+			/// @brief Returns the leaf that may contain the key and the nearest subtree to the right of it
+			Leaf* FindLeaf(const Key_& key, Node*& nextSubtree) const
+			{
+				Node* node = _root;
+				if (!node)
+					return NULL;
+
+				while (!node->IsLeaf)
+				{
+					const Inner* const inner = static_cast<const Inner*>(node);
+					const size_t child = FindChild(inner, key);
+					if (child + 1 < inner->Count)
+						nextSubtree = inner->Children[child + 1];
+					node = inner->Children[child];
+				}
+				return static_cast<Leaf*>(node);
+			}
+
+			Position FindLastLess(const Key_& key) const
+			{
+				Node* prevSubtree = NULL;
+				Node* node = _root;
+				while (!node->IsLeaf)
+				{
+					const Inner* const inner = static_cast<const Inner*>(node);
+					const size_t child = FindChild(inner, key);
+					if (child != 0)
+						prevSubtree = inner->Children[child - 1];
+					node = inner->Children[child];
+				}
+
+				Leaf* leaf = static_cast<Leaf*>(node);
+				const size_t index = LowerBoundInLeaf(leaf, key);
+				if (index != 0)
+					return Position(leaf, index - 1);
+
+				STINGRAYKIT_CHECK(prevSubtree, "Iterator is out of range!");
+				leaf = GetRightmostLeaf(prevSubtree);
+				return Position(leaf, leaf->Count - 1);
+			}
+
+			static Leaf* GetLeftmostLeaf(Node* node)
+			{
+				while (!node->IsLeaf)
+					node = static_cast<Inner*>(node)->Children[0];
+				return static_cast<Leaf*>(node);
+			}
+
+			static Leaf* GetRightmostLeaf(Node* node)
+			{
+				while (!node->IsLeaf)
+					node = static_cast<Inner*>(node)->Children[node->Count - 1];
+				return static_cast<Leaf*>(node);
+			}
+
+			Leaf* UnshareLeaf(const Key_& key)
+			{
+				Unshare(_root);
+
+				Node* node = _root;
+				while (!node->IsLeaf)
+				{
+					Inner* const inner = static_cast<Inner*>(node);
+					const size_t child = FindChild(inner, key);
+					Unshare(inner->Children[child]);
+					node = inner->Children[child];
+				}
+				return static_cast<Leaf*>(node);
+			}
+
+			/// @brief Splits the full child into two halves, the parent must be unshared and not full
+			void SplitChild(Inner* parent, size_t index)
+			{
+				Node* const child = parent->Children[index];
+				Node* right = NULL;
+
+				// the halves are copied before the originals are destroyed, so that a throwing copy leaves the tree intact
+				if (child->IsLeaf)
+				{
+					Leaf* const left = static_cast<Leaf*>(child);
+					Leaf* const newLeaf = NewLeaf();
+
+					const size_t middle = LeafCapacity / 2;
+					try
+					{
+						for (; newLeaf->Count < LeafCapacity - middle; ++newLeaf->Count)
+							newLeaf->Values[newLeaf->Count].Ctor(left->Values[middle + newLeaf->Count].Ref());
+						InsertKey(parent, index, GetKey(newLeaf, 0));
+					}
+					catch (...)
+					{
+						DeleteLeaf(newLeaf);
+						throw;
+					}
+
+					for (size_t i = middle; i < LeafCapacity; ++i)
+						left->Values[i].Dtor();
+					left->Count = middle;
+					right = newLeaf;
+				}
+				else
+				{
+					Inner* const left = static_cast<Inner*>(child);
+					Inner* const newInner = NewInner();
+
+					const size_t middle = InnerCapacity / 2;
+					try
+					{
+						for (newInner->Count = 1; newInner->Count < InnerCapacity - middle; ++newInner->Count)
+							newInner->Keys[newInner->Count - 1].Ctor(left->Keys[middle + newInner->Count - 1].Ref());
+						InsertKey(parent, index, left->Keys[middle - 1].Ref());
+					}
+					catch (...)
+					{
+						DeleteInner(newInner);
+						throw;
+					}
+
+					std::copy(left->Children + middle, left->Children + InnerCapacity, newInner->Children);
+					for (size_t i = middle; i < InnerCapacity; ++i)
+						left->Keys[i - 1].Dtor();
+					left->Count = middle;
+					right = newInner;
+				}
+
+				std::copy_backward(parent->Children + index + 1, parent->Children + parent->Count, parent->Children + parent->Count + 1);
+				parent->Children[index + 1] = right;
+				++parent->Count;
+			}
+
+			/// @brief Makes the child bigger than the minimum by borrowing from or merging with a sibling, returns the new index of the child
+			size_t Fill(Inner* parent, size_t index)
+			{
+				if (index != 0 && parent->Children[index - 1]->Count > GetMinCount(parent->Children[index - 1]))
+				{
+					Unshare(parent->Children[index - 1]);
+					BorrowFromLeft(parent, index);
+					return index;
+				}
+
+				if (index + 1 < parent->Count && parent->Children[index + 1]->Count > GetMinCount(parent->Children[index + 1]))
+				{
+					Unshare(parent->Children[index + 1]);
+					BorrowFromRight(parent, index);
+					return index;
+				}
+
+				if (index + 1 < parent->Count)
+				{
+					Unshare(parent->Children[index + 1]);
+					Merge(parent, index);
+					return index;
+				}
+
+				Unshare(parent->Children[index - 1]);
+				Merge(parent, index - 1);
+				return index - 1;
+			}
+
+			void BorrowFromLeft(Inner* parent, size_t index)
+			{
+				Node* const child = parent->Children[index];
+				Node* const sibling = parent->Children[index - 1];
+
+				if (child->IsLeaf)
+				{
+					Leaf* const leaf = static_cast<Leaf*>(child);
+					Leaf* const left = static_cast<Leaf*>(sibling);
+
+					ShiftRight(leaf->Values, 0, leaf->Count);
+					Relocate(leaf->Values[0], left->Values[left->Count - 1]);
+					++leaf->Count;
+					--left->Count;
+
+					parent->Keys[index - 1].Ref() = GetKey(leaf, 0);
+				}
+				else
+				{
+					Inner* const inner = static_cast<Inner*>(child);
+					Inner* const left = static_cast<Inner*>(sibling);
+
+					ShiftRight(inner->Keys, 0, inner->Count - 1);
+					std::copy_backward(inner->Children, inner->Children + inner->Count, inner->Children + inner->Count + 1);
+
+					Relocate(inner->Keys[0], parent->Keys[index - 1]);
+					inner->Children[0] = left->Children[left->Count - 1];
+					Relocate(parent->Keys[index - 1], left->Keys[left->Count - 2]);
+					++inner->Count;
+					--left->Count;
+				}
+			}
+
+			void BorrowFromRight(Inner* parent, size_t index)
+			{
+				Node* const child = parent->Children[index];
+				Node* const sibling = parent->Children[index + 1];
+
+				if (child->IsLeaf)
+				{
+					Leaf* const leaf = static_cast<Leaf*>(child);
+					Leaf* const right = static_cast<Leaf*>(sibling);
+
+					Relocate(leaf->Values[leaf->Count], right->Values[0]);
+					ShiftLeft(right->Values, 0, right->Count);
+					++leaf->Count;
+					--right->Count;
+
+					parent->Keys[index].Ref() = GetKey(right, 0);
+				}
+				else
+				{
+					Inner* const inner = static_cast<Inner*>(child);
+					Inner* const right = static_cast<Inner*>(sibling);
+
+					Relocate(inner->Keys[inner->Count - 1], parent->Keys[index]);
+					inner->Children[inner->Count] = right->Children[0];
+					++inner->Count;
+
+					Relocate(parent->Keys[index], right->Keys[0]);
+					ShiftLeft(right->Keys, 0, right->Count - 1);
+					std::copy(right->Children + 1, right->Children + right->Count, right->Children);
+					--right->Count;
+				}
+			}
+
+			/// @brief Merges the child index + 1 into the child index, both of them must be unshared
+			void Merge(Inner* parent, size_t index)
+			{
+				Node* const child = parent->Children[index];
+				Node* const sibling = parent->Children[index + 1];
+
+				if (child->IsLeaf)
+				{
+					Leaf* const left = static_cast<Leaf*>(child);
+					Leaf* const right = static_cast<Leaf*>(sibling);
+
+					for (size_t i = 0; i < right->Count; ++i)
+						Relocate(left->Values[left->Count + i], right->Values[i]);
+					left->Count += right->Count;
+					right->Count = 0;
+					DeleteLeaf(right);
+
+					parent->Keys[index].Dtor();
+				}
+				else
+				{
+					Inner* const left = static_cast<Inner*>(child);
+					Inner* const right = static_cast<Inner*>(sibling);
+
+					Relocate(left->Keys[left->Count - 1], parent->Keys[index]);
+					for (size_t i = 0; i < right->Count; ++i)
+					{
+						left->Children[left->Count + i] = right->Children[i];
+						if (i + 1 < right->Count)
+							Relocate(left->Keys[left->Count + i], right->Keys[i]);
+					}
+					left->Count += right->Count;
+					right->Count = 0;
+					DeleteInner(right);
+				}
+
+				ShiftLeft(parent->Keys, index, parent->Count - 1);
+				std::copy(parent->Children + index + 2, parent->Children + parent->Count, parent->Children + index + 1);
+				--parent->Count;
+			}
+
+			/// @brief Inserts the separator key at index, the parent must not be full
+			static void InsertKey(Inner* parent, size_t index, const Key_& key)
+			{
+				ShiftRight(parent->Keys, index, parent->Count - 1);
+				try
+				{ parent->Keys[index].Ctor(key); }
+				catch (...)
+				{
+					ShiftLeft(parent->Keys, index, parent->Count);
+					throw;
+				}
+			}
+
+			template < typename T >
+			static void Relocate(StorageFor<T>& dst, StorageFor<T>& src)
+			{
+				dst.Ctor(src.Ref());
+				src.Dtor();
+			}
+
+			/// @brief Moves [index, count) to [index + 1, count + 1), or moves the items back if a copy throws
+			template < typename T >
+			static void ShiftRight(StorageFor<T>* items, size_t index, size_t count)
+			{
+				size_t i = count;
+				try
+				{
+					for (; i > index; --i)
+						Relocate(items[i], items[i - 1]);
+				}
+				catch (...)
+				{
+					ShiftLeft(items, i, count + 1);
+					throw;
+				}
+			}
+
+			/// @brief Moves [index + 1, count) to [index, count - 1), the item at index must be destroyed already
+			template < typename T >
+			static void ShiftLeft(StorageFor<T>* items, size_t index, size_t count)
+			{
+				for (size_t i = index; i + 1 < count; ++i)
+					Relocate(items[i], items[i + 1]);
+			}
+
+			void Unshare(Node*& node)
+			{
+				if (AtomicU32::Load(node->RefCount) == 1)
+					return;
+
+				Node* const copy = Clone(node);
+				Release(node);
+				node = copy;
+			}
+
+			Node* Clone(const Node* node)
+			{
+				if (node->IsLeaf)
+				{
+					const Leaf* const leaf = static_cast<const Leaf*>(node);
+					Leaf* const result = NewLeaf();
+					try
+					{
+						for (; result->Count < leaf->Count; ++result->Count)
+							result->Values[result->Count].Ctor(leaf->Values[result->Count].Ref());
+					}
+					catch (...)
+					{
+						DeleteLeaf(result);
+						throw;
+					}
+					return result;
+				}
+
+				const Inner* const inner = static_cast<const Inner*>(node);
+				Inner* const result = NewInner();
+				try
+				{
+					for (; result->Count < inner->Count; ++result->Count)
+					{
+						if (result->Count != 0)
+							result->Keys[result->Count - 1].Ctor(inner->Keys[result->Count - 1].Ref());
+						result->Children[result->Count] = inner->Children[result->Count];
+						AddRef(result->Children[result->Count]);
+					}
+				}
+				catch (...)
+				{
+					for (size_t i = 0; i < result->Count; ++i)
+						Release(result->Children[i]);
+					DeleteInner(result);
+					throw;
+				}
+				return result;
+			}
+
+			static void AddRef(Node* node)
+			{
+				if (node)
+					AtomicU32::Inc(node->RefCount);
+			}
+
+			void Release(Node* node)
+			{
+				if (!node || AtomicU32::Dec(node->RefCount) != 0)
+					return;
+
+				if (node->IsLeaf)
+					DeleteLeaf(static_cast<Leaf*>(node));
+				else
+				{
+					Inner* const inner = static_cast<Inner*>(node);
+					for (size_t i = 0; i < inner->Count; ++i)
+						Release(inner->Children[i]);
+					DeleteInner(inner);
+				}
+			}
+
+			Leaf* NewLeaf()
+			{
+				Leaf* const leaf = _leafAllocator.allocate(1);
+				return new(leaf) Leaf();
+			}
+
+			Inner* NewInner()
+			{
+				Inner* const inner = _innerAllocator.allocate(1);
+				return new(inner) Inner();
+			}
+
+			/// @brief Destroys the values, but not the children
+			void DeleteLeaf(Leaf* leaf)
+			{
+				for (size_t i = 0; i < leaf->Count; ++i)
+					leaf->Values[i].Dtor();
+				leaf->~Leaf();
+				_leafAllocator.deallocate(leaf, 1);
+			}
+
+			void DeleteInner(Inner* inner)
+			{
+				for (size_t i = 1; i < inner->Count; ++i)
+					inner->Keys[i - 1].Dtor();
+				inner->~Inner();
+				_innerAllocator.deallocate(inner, 1);
+			}
+		};
+
+	}
+
+}
+
+#endif
@@ -17,7 +17,13 @@
 namespace stingray
 {
 
-	template < typename Key_, typename Value_, typename Comparer_ = comparers::Less >
+	/// @brief MapType_ may be any std::map replacement, e.g. btree_map, but then the iterators are invalidated by add and erase, as the ones of the map
+	template <
+			typename Key_,
+			typename Value_,
+			typename Comparer_ = comparers::Less,
+			template <class, class, class, class> class MapType_ = std::map
+			>
 	class RefCountingMap
 	{
 		struct ValueHolder
@@ -30,7 +36,7 @@ namespace stingray
 			{ }
 		};
 
-		typedef std::map<Key_, ValueHolder, Comparer_>		Impl;
+		typedef MapType_<Key_, ValueHolder, Comparer_, std::allocator<std::pair<const Key_, ValueHolder> > >		Impl;
 
 		template < bool Const >
 		struct Iterator : public iterator_base<Iterator<Const>, std::pair<const Key_&, typename If<Const, const Value_&, Value_&>::ValueT>, std::bidirectional_iterator_tag>
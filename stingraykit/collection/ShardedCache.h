@@ -0,0 +1,195 @@
+#ifndef STINGRAYKIT_COLLECTION_SHARDEDCACHE_H
+#define STINGRAYKIT_COLLECTION_SHARDEDCACHE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/CacheStats.h>
+#include <stingraykit/collection/ICache.h>
+#include <stingraykit/compare/hashers.h>
+#include <stingraykit/function/bind.h>
+#include <stingraykit/signal/signals.h>
+#include <stingraykit/thread/Thread.h>
+
+#include <vector>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief Thread-safe cache made of independently locked shards, a key goes to the shard selected by the high bits of its hash
+	 * @par Each shard is a single-threaded ICache made by the factory, e.g. a LruCache or a TwoQueueCache with a part of the whole capacity.
+	 * OnEvicted is invoked with the shard locked. The statistics are counted per shard and summed up by GetStats.
+	 */
+	template < typename Key_, typename Value_, typename Hash_ = hashers::Hash >
+	class ShardedCache : public virtual ICache<Key_, Value_>
+	{
+		STINGRAYKIT_NONCOPYABLE(ShardedCache);
+
+		typedef ICache<Key_, Value_> Base;
+
+		typedef typename Base::KeyPassingType KeyPassingType;
+		typedef typename Base::ValuePassingType ValuePassingType;
+
+		typedef typename Base::OnEvictedSignature OnEvictedSignature;
+
+	public:
+		typedef shared_ptr<Base>					CachePtr;
+		typedef function<CachePtr ()>				ShardFactory;
+		typedef function<Value_ (KeyPassingType)>	ValueCreator;
+
+	private:
+		/// @brief The fields are kept on cache lines of their own, so that the threads working with different shards don't write to any shared one
+		struct Shard
+		{
+			static const size_t		CacheLineSize = 64;
+
+			u8						Padding0[CacheLineSize];
+			Mutex					Guard;
+			CachePtr				Cache;
+			CacheStats				Stats;
+			Token					Connection;
+			u8						Padding1[CacheLineSize];
+		};
+		STINGRAYKIT_DECLARE_PTR(Shard);
+
+		typedef std::vector<ShardPtr> Shards;
+
+	private:
+		Hash_							_hash;
+		size_t							_shardBits;
+
+		signal<OnEvictedSignature>		_onEvicted;
+
+		Shards							_shards;
+
+	public:
+		/// @param shardsCount is rounded up to a power of two
+		ShardedCache(size_t shardsCount, const ShardFactory& shardFactory)
+			:	_shardBits()
+		{
+			while (((size_t)1 << _shardBits) < shardsCount)
+				++_shardBits;
+
+			for (size_t i = 0; i < ((size_t)1 << _shardBits); ++i)
+			{
+				const ShardPtr shard = make_shared<Shard>();
+				shard->Cache = STINGRAYKIT_REQUIRE_NOT_NULL(shardFactory());
+				shard->Connection = shard->Cache->OnEvicted().connect(bind(&ShardedCache::OnShardEvicted, this, shard.get(), _1, _2));
+				_shards.push_back(shard);
+			}
+		}
+
+		virtual bool TryGet(KeyPassingType key, Value_& out)
+		{
+			Shard& shard = GetShard(key);
+			MutexLock l(shard.Guard);
+
+			if (!shard.Cache->TryGet(key, out))
+			{
+				++shard.Stats.Misses;
+				return false;
+			}
+
+			++shard.Stats.Hits;
+			return true;
+		}
+
+		/// @brief Gets the cached value or creates and caches a new one, the creator is invoked with the shard locked
+		/// @return true if the value was cached already
+		bool TryGetOrCreate(KeyPassingType key, Value_& out, const ValueCreator& creator)
+		{
+			Shard& shard = GetShard(key);
+			MutexLock l(shard.Guard);
+
+			if (shard.Cache->TryGet(key, out))
+			{
+				++shard.Stats.Hits;
+				return true;
+			}
+
+			++shard.Stats.Misses;
+			out = creator(key);
+			shard.Cache->Set(key, out);
+			return false;
+		}
+
+		virtual void Set(KeyPassingType key, ValuePassingType value)
+		{
+			Shard& shard = GetShard(key);
+			MutexLock l(shard.Guard);
+			shard.Cache->Set(key, value);
+		}
+
+		virtual bool TryRemove(KeyPassingType key)
+		{
+			Shard& shard = GetShard(key);
+			MutexLock l(shard.Guard);
+			return shard.Cache->TryRemove(key);
+		}
+
+		virtual void Clear()
+		{
+			for (typename Shards::const_iterator it = _shards.begin(); it != _shards.end(); ++it)
+			{
+				MutexLock l((*it)->Guard);
+				(*it)->Cache->Clear();
+			}
+		}
+
+		virtual size_t GetSize() const
+		{
+			size_t result = 0;
+			for (typename Shards::const_iterator it = _shards.begin(); it != _shards.end(); ++it)
+			{
+				MutexLock l((*it)->Guard);
+				result += (*it)->Cache->GetSize();
+			}
+			return result;
+		}
+
+		virtual signal_connector<OnEvictedSignature> OnEvicted() const
+		{ return _onEvicted.connector(); }
+
+		CacheStats GetStats() const
+		{
+			CacheStats result;
+			for (typename Shards::const_iterator it = _shards.begin(); it != _shards.end(); ++it)
+			{
+				MutexLock l((*it)->Guard);
+				result += (*it)->Stats;
+			}
+			return result;
+		}
+
+		size_t GetShardsCount() const
+		{ return _shards.size(); }
+
+	private:
+		Shard& GetShard(KeyPassingType key) const
+		{
+			// the shard caches take the low bits of the same hash for their buckets, so the high ones are used here
+			return _shardBits == 0 ? *_shards.front() : *_shards[_hash(key) >> (sizeof(size_t) * 8 - _shardBits)];
+		}
+
+		void OnShardEvicted(Shard* shard, KeyPassingType key, ValuePassingType value)
+		{
+			++shard->Stats.Evictions;
+			_onEvicted(key, value);
+		}
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 // IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <stingraykit/collection/btree_set.h>
 #include <stingraykit/collection/EnumerableHelpers.h>
 #include <stingraykit/collection/EnumeratorFromStlContainer.h>
 #include <stingraykit/collection/IEnumerable.h>
@@ -23,14 +24,43 @@ namespace stingray
 	 * @{
 	 */
 
-	template < typename T , typename CompareType_ = comparers::Less >
+	namespace Detail
+	{
+		/// @brief Erases the value and returns the iterator to the next one, std::multiset keeps the other iterators valid, but its erase returns nothing
+		template < typename SetType >
+		struct SortedMultiSetEraser
+		{
+			static typename SetType::iterator Erase(SetType& items, typename SetType::iterator it)
+			{
+				items.erase(it++);
+				return it;
+			}
+		};
+
+		/// @brief btree_multiset erase invalidates all the iterators, but returns the one to the next value
+		template < typename T, typename CompareType, typename AllocatorType >
+		struct SortedMultiSetEraser<btree_multiset<T, CompareType, AllocatorType> >
+		{
+			typedef btree_multiset<T, CompareType, AllocatorType>	SetType;
+
+			static typename SetType::iterator Erase(SetType& items, typename SetType::iterator it)
+			{ return items.erase(it); }
+		};
+	}
+
+	template <
+			typename T,
+			typename CompareType_ = comparers::Less,
+			template <class, class, class> class SetType_ = std::multiset,
+			typename AllocatorType_ = std::allocator<T>
+			>
 	class SortedMultiSet : public virtual IMultiSet<T>
 	{
 	public:
 		typedef typename IMultiSet<T>::ValueType				ValueType;
 
 	private:
-		typedef std::multiset<ValueType, CompareType_>	SetType;
+		typedef SetType_<ValueType, CompareType_, AllocatorType_>		SetType;
 		STINGRAYKIT_DECLARE_PTR(SetType);
 
 		struct Holder
@@ -138,11 +168,13 @@ namespace stingray
 			size_t ret = 0;
 			for (typename SetType::iterator it = _items->begin(); it != _items->end(); )
 			{
-				const typename SetType::iterator cur = it++;
-				if (!pred(*cur))
+				if (!pred(*it))
+				{
+					++it;
 					continue;
+				}
 
-				_items->erase(cur);
+				it = Detail::SortedMultiSetEraser<SetType>::Erase(*_items, it);
 				++ret;
 			}
 			return ret;
@@ -186,6 +218,14 @@ namespace stingray
 		}
 	};
 
+	template <
+			typename T,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_multiset<T, CompareType>::allocator_type
+			>
+	struct BTreeSortedMultiSet
+	{ typedef SortedMultiSet<T, CompareType, btree_multiset, AllocatorType>		Type; };
+
 	/** @} */
 
 }
@@ -21,12 +21,17 @@ namespace stingray
 	 * @{
 	 */
 
-	template < typename ValueType_, typename CompareType_ = comparers::Less >
+	template <
+			typename ValueType_,
+			typename CompareType_ = comparers::Less,
+			template <class, class, class> class SetType_ = std::multiset,
+			typename AllocatorType_ = std::allocator<ValueType_>
+			>
 	struct SortedObservableMultiSet
-		:	public SortedMultiSet<ValueType_, CompareType_>,
-			public virtual IObservableMultiSet<typename SortedMultiSet<ValueType_, CompareType_>::ValueType>
+		:	public SortedMultiSet<ValueType_, CompareType_, SetType_, AllocatorType_>,
+			public virtual IObservableMultiSet<typename SortedMultiSet<ValueType_, CompareType_, SetType_, AllocatorType_>::ValueType>
 	{
-		typedef SortedMultiSet<ValueType_, CompareType_> Wrapped;
+		typedef SortedMultiSet<ValueType_, CompareType_, SetType_, AllocatorType_> Wrapped;
 
 		typedef signal_policies::threading::ExternalMutexPointer ExternalMutexPointer;
 
@@ -181,6 +186,14 @@ namespace stingray
 		}
 	};
 
+	template <
+			typename T,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_multiset<T, CompareType>::allocator_type
+			>
+	struct BTreeSortedObservableMultiSet
+	{ typedef SortedObservableMultiSet<T, CompareType, btree_multiset, AllocatorType>		Type; };
+
 	/** @} */
 
 }
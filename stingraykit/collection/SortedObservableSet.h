@@ -43,6 +43,14 @@ namespace stingray
 	struct FlatSortedObservableSet
 	{ typedef SortedObservableSet<T, CompareType, flat_set, AllocatorType>		Type; };
 
+	template <
+			typename T,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_set<T, CompareType>::allocator_type
+			>
+	struct BTreeSortedObservableSet
+	{ typedef SortedObservableSet<T, CompareType, btree_set, AllocatorType>		Type; };
+
 	/** @} */
 
 }
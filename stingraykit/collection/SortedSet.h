@@ -8,6 +8,7 @@
 // IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <stingraykit/collection/btree_set.h>
 #include <stingraykit/collection/EnumerableHelpers.h>
 #include <stingraykit/collection/EnumeratorFromStlContainer.h>
 #include <stingraykit/collection/flat_set.h>
@@ -15,6 +16,7 @@
 #include <stingraykit/collection/ISet.h>
 
 #include <set>
+#include <vector>
 
 namespace stingray
 {
@@ -139,18 +141,19 @@ namespace stingray
 
 		virtual size_t RemoveWhere(const function<bool (const ValueType&)>& pred)
 		{
+			// erasing invalidates the following iterators of flat_set and btree_set, so the values are collected first
+			std::vector<ValueType> values;
+			for (typename SetType::const_iterator it = _items->begin(); it != _items->end(); ++it)
+				if (pred(*it))
+					values.push_back(*it);
+
+			if (values.empty())
+				return 0;
+
 			CopyOnWrite();
-			size_t ret = 0;
-			for (typename SetType::iterator it = _items->begin(); it != _items->end(); )
-			{
-				const typename SetType::iterator cur = it++;
-				if (!pred(*cur))
-					continue;
-
-				_items->erase(cur);
-				++ret;
-			}
-			return ret;
+			for (typename std::vector<ValueType>::const_iterator it = values.begin(); it != values.end(); ++it)
+				_items->erase(*it);
+			return values.size();
 		}
 
 		virtual void Clear()
@@ -188,6 +191,14 @@ namespace stingray
 	struct FlatSortedSet
 	{ typedef SortedSet<T, CompareType, flat_set, AllocatorType>		Type; };
 
+	template <
+			typename T,
+			typename CompareType = comparers::Less,
+			typename AllocatorType = typename btree_set<T, CompareType>::allocator_type
+			>
+	struct BTreeSortedSet
+	{ typedef SortedSet<T, CompareType, btree_set, AllocatorType>		Type; };
+
 	/** @} */
 
 }
@@ -0,0 +1,364 @@
+#ifndef STINGRAYKIT_COLLECTION_TINYLFUCACHE_H
+#define STINGRAYKIT_COLLECTION_TINYLFUCACHE_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/HashQueueCache.h>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	namespace Detail
+	{
+
+		/// @brief Count-Min sketch of 4-bit counters, all the counters are halved once the number of increments reaches the sample size,
+		/// so that the old popularity fades away
+		class FrequencySketch
+		{
+			static const size_t Depth = 4;
+			static const u8 MaxCounter = 15;
+
+		private:
+			std::vector<u64>	_table; // 16 counters per word
+			size_t				_sampleSize;
+			size_t				_additions;
+
+		public:
+			explicit FrequencySketch(size_t capacity)
+				:	_sampleSize(std::max<size_t>(capacity, 1) * 10),
+					_additions()
+			{
+				size_t words = 1;
+				while (words < capacity)
+					words *= 2;
+				_table.resize(words);
+			}
+
+			u8 GetFrequency(size_t hash) const
+			{
+				u8 result = MaxCounter;
+				for (size_t i = 0; i < Depth; ++i)
+					result = std::min(result, GetCounter(hash, i));
+				return result;
+			}
+
+			void Increment(size_t hash)
+			{
+				bool added = false;
+				for (size_t i = 0; i < Depth; ++i)
+				{
+					u64& word = _table[GetWordIndex(hash, i)];
+					const size_t shift = GetCounterShift(hash, i);
+					if (((word >> shift) & MaxCounter) != MaxCounter)
+					{
+						word += (u64)1 << shift;
+						added = true;
+					}
+				}
+
+				if (added && ++_additions >= _sampleSize)
+					Age();
+			}
+
+			void Clear()
+			{
+				std::fill(_table.begin(), _table.end(), 0);
+				_additions = 0;
+			}
+
+		private:
+			u8 GetCounter(size_t hash, size_t row) const
+			{ return (u8)((_table[GetWordIndex(hash, row)] >> GetCounterShift(hash, row)) & MaxCounter); }
+
+			size_t GetWordIndex(size_t hash, size_t row) const
+			{ return hashers::Detail::MixHash((u64)hash + row * 0x9e3779b97f4a7c15ULL) & (_table.size() - 1); }
+
+			static size_t GetCounterShift(size_t hash, size_t row)
+			{ return ((hash >> (row * 4)) & 15) * 4; }
+
+			void Age()
+			{
+				for (std::vector<u64>::iterator it = _table.begin(); it != _table.end(); ++it)
+					*it = (*it >> 1) & 0x7777777777777777ULL;
+				_additions /= 2;
+			}
+		};
+
+	}
+
+
+	/**
+	 * @brief W-TinyLFU cache: new entries go to a small LRU window, an entry leaving the window is admitted to the main segmented LRU
+	 * only if its estimated access frequency is higher than the one of the main LRU victim, otherwise the entry itself is evicted
+	 * @par The frequencies are estimated by a count-min sketch of both TryGet and Set calls that is periodically aged.
+	 * The main part is split into probation and protected segments, entries are promoted to the protected one on a hit.
+	 * The window takes 1% of the capacity and the protected segment 80% of the rest. OnEvicted is invoked both for the LRU victims and for the rejected candidates.
+	 */
+	template < typename Key_, typename Value_, typename SizeMapper_ = DefaultCacheSizeMapper, typename Hash_ = hashers::Hash, typename Equals_ = comparers::Equals >
+	class TinyLfuCache : public virtual ICache<Key_, Value_>
+	{
+		STINGRAYKIT_NONCOPYABLE(TinyLfuCache);
+
+		typedef ICache<Key_, Value_> Base;
+
+		typedef typename Base::KeyPassingType KeyPassingType;
+		typedef typename Base::ValuePassingType ValuePassingType;
+
+		typedef typename Base::OnEvictedSignature OnEvictedSignature;
+
+		struct Segment
+		{
+			enum Enum { Window, Probation, Protected };
+		};
+
+		struct Entry : public IntrusiveListNodeData
+		{
+			Key_			Key;
+			Value_			Value;
+			size_t			Hash;
+			Entry*			NextInBucket;
+
+			size_t			Weight;
+			typename Segment::Enum	Location;
+
+		public:
+			Entry(KeyPassingType key, ValuePassingType value, size_t hash, size_t weight)
+				:	Key(key),
+					Value(value),
+					Hash(hash),
+					NextInBucket(),
+					Weight(weight),
+					Location(Segment::Window)
+			{ }
+		};
+
+		typedef Detail::CacheHashIndex<Entry, Key_, Hash_, Equals_> Index;
+		typedef IntrusiveList<Entry> Queue;
+
+	private:
+		size_t							_windowCapacity;
+		size_t							_mainCapacity;
+		size_t							_protectedCapacity;
+		SizeMapper_						_sizeMapper;
+
+		Index							_index;
+		Detail::FrequencySketch			_sketch;
+
+		Queue							_window; // least recently used first, as the other queues
+		Queue							_probation;
+		Queue							_protected;
+		size_t							_windowSize;
+		size_t							_probationSize;
+		size_t							_protectedSize;
+
+		signal<OnEvictedSignature>		_onEvicted;
+
+	public:
+		TinyLfuCache(size_t capacity)
+			:	_windowCapacity(std::max<size_t>(capacity / 100, 1)),
+				_mainCapacity(capacity - std::min(capacity, _windowCapacity)),
+				_protectedCapacity(_mainCapacity * 4 / 5),
+				_sketch(capacity),
+				_windowSize(),
+				_probationSize(),
+				_protectedSize()
+		{ }
+
+		virtual ~TinyLfuCache()
+		{ Clear(); }
+
+		virtual bool TryGet(KeyPassingType key, Value_& out)
+		{
+			const size_t hash = _index.GetHash(key);
+			_sketch.Increment(hash);
+
+			Entry* const entry = _index.Find(key, hash);
+			if (!entry)
+				return false;
+
+			OnAccess(entry);
+
+			out = entry->Value;
+			return true;
+		}
+
+		virtual void Set(KeyPassingType key, ValuePassingType value)
+		{
+			const size_t hash = _index.GetHash(key);
+			_sketch.Increment(hash);
+
+			const size_t weight = _sizeMapper(value);
+
+			if (Entry* const entry = _index.Find(key, hash))
+			{
+				entry->Value = value;
+				GetSegmentSize(entry->Location) = GetSegmentSize(entry->Location) - entry->Weight + weight;
+				entry->Weight = weight;
+
+				OnAccess(entry);
+			}
+			else
+			{
+				_index.Reserve();
+
+				Entry* const newEntry = new Entry(key, value, hash, weight);
+				_index.Insert(newEntry);
+				_window.push_back(*newEntry);
+				_windowSize += weight;
+			}
+
+			DemoteProtected();
+			EvictWindow();
+		}
+
+		virtual bool TryRemove(KeyPassingType key)
+		{
+			Entry* const entry = _index.Find(key, _index.GetHash(key));
+			if (!entry)
+				return false;
+
+			DoRemove(entry);
+			return true;
+		}
+
+		virtual void Clear()
+		{
+			ClearQueue(_window);
+			ClearQueue(_probation);
+			ClearQueue(_protected);
+
+			_index.Clear();
+			_sketch.Clear();
+			_windowSize = _probationSize = _protectedSize = 0;
+		}
+
+		virtual size_t GetSize() const
+		{ return _windowSize + _probationSize + _protectedSize; }
+
+		virtual signal_connector<OnEvictedSignature> OnEvicted() const
+		{ return _onEvicted.connector(); }
+
+	private:
+		void OnAccess(Entry* entry)
+		{
+			switch (entry->Location)
+			{
+			case Segment::Window:
+				_window.erase(*entry);
+				_window.push_back(*entry);
+				break;
+
+			case Segment::Probation:
+				Move(entry, Segment::Protected);
+				DemoteProtected();
+				break;
+
+			case Segment::Protected:
+				_protected.erase(*entry);
+				_protected.push_back(*entry);
+				break;
+			}
+		}
+
+		void DemoteProtected()
+		{
+			while (_protectedSize > _protectedCapacity)
+				Move(&*_protected.begin(), Segment::Probation);
+		}
+
+		void EvictWindow()
+		{
+			while (_windowSize > _windowCapacity)
+			{
+				Entry* const candidate = &*_window.begin();
+				Move(candidate, Segment::Probation);
+				EvictMain(candidate);
+			}
+
+			EvictMain(NULL); // an updated value may be heavier than the old one
+		}
+
+		void EvictMain(Entry* candidate)
+		{
+			while (_probationSize + _protectedSize > _mainCapacity)
+			{
+				typename Queue::iterator it = _probation.begin();
+				if (it != _probation.end() && &*it == candidate)
+					++it;
+
+				Entry* victim = candidate;
+				if (it != _probation.end())
+					victim = &*it;
+				else if (!_protected.empty())
+					victim = &*_protected.begin();
+
+				if (candidate && victim != candidate && _sketch.GetFrequency(candidate->Hash) <= _sketch.GetFrequency(victim->Hash))
+					victim = candidate;
+
+				if (victim == candidate)
+					candidate = NULL;
+
+				Evict(victim);
+			}
+		}
+
+		void Move(Entry* entry, typename Segment::Enum location)
+		{
+			GetQueue(entry->Location).erase(*entry);
+			GetSegmentSize(entry->Location) -= entry->Weight;
+
+			entry->Location = location;
+			GetQueue(location).push_back(*entry);
+			GetSegmentSize(location) += entry->Weight;
+		}
+
+		void Evict(Entry* entry)
+		{
+			const Key_ key = entry->Key;
+			const Value_ value = entry->Value;
+
+			DoRemove(entry);
+
+			_onEvicted(key, value);
+		}
+
+		void DoRemove(Entry* entry)
+		{
+			_index.Remove(entry);
+			GetQueue(entry->Location).erase(*entry);
+			GetSegmentSize(entry->Location) -= entry->Weight;
+			delete entry;
+		}
+
+		Queue& GetQueue(typename Segment::Enum location)
+		{ return location == Segment::Window ? _window : (location == Segment::Probation ? _probation : _protected); }
+
+		size_t& GetSegmentSize(typename Segment::Enum location)
+		{ return location == Segment::Window ? _windowSize : (location == Segment::Probation ? _probationSize : _protectedSize); }
+
+		static void ClearQueue(Queue& queue)
+		{
+			while (!queue.empty())
+			{
+				Entry& entry = *queue.begin();
+				queue.erase(entry);
+				delete &entry;
+			}
+		}
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef STINGRAYKIT_COLLECTION_BTREE_MAP_H
+#define STINGRAYKIT_COLLECTION_BTREE_MAP_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/BTree.h>
+#include <stingraykit/collection/iterator_base.h>
+#include <stingraykit/collection/KeyNotFoundExceptionCreator.h>
+
+#include <functional>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief std::map replacement on a B+tree, the pairs are stored by dozens in the nodes of a few cache lines
+	 * @par It takes a few bytes of overhead per pair instead of a node allocation, and the iteration goes through contiguous arrays.
+	 * Unlike std::map, insert and erase invalidate all the iterators, erase returns the iterator to the next pair instead.
+	 */
+	template < class Key, class Value, class Compare = std::less<Key>, class Allocator = std::allocator<std::pair<const Key, Value> > >
+	class btree_map
+	{
+	public:
+		typedef Key														key_type;
+		typedef Value													mapped_type;
+		typedef std::pair<const Key, Value>								value_type;
+		typedef size_t													size_type;
+		typedef std::ptrdiff_t											difference_type;
+		typedef Compare													key_compare;
+		typedef Allocator												allocator_type;
+		typedef value_type&												reference;
+		typedef const value_type&										const_reference;
+		typedef value_type*												pointer;
+		typedef const value_type*										const_pointer;
+
+	private:
+		struct KeyOfValue
+		{
+			const Key& operator () (const value_type& value) const	{ return value.first; }
+		};
+
+		typedef Detail::BTree<Key, value_type, KeyOfValue, Compare, Allocator, false>	Tree;
+		typedef typename Tree::Position													Position;
+
+	public:
+		class const_iterator;
+
+		class iterator : public iterator_base<iterator, value_type, std::bidirectional_iterator_tag>
+		{
+			friend class btree_map;
+			friend class const_iterator;
+
+		private:
+			const Tree*			_tree;
+			Position			_position;
+
+		public:
+			iterator() : _tree() { }
+
+			value_type& dereference() const			{ return Tree::GetMutableValue(_position); }
+			bool equal(const iterator& other) const	{ return _position == other._position; }
+			void increment()						{ _position = Tree::Next(_position); }
+			void decrement()						{ _position = _tree->Prev(_position); }
+
+		private:
+			iterator(const Tree* tree, const Position& position) : _tree(tree), _position(position) { }
+		};
+
+		class const_iterator : public iterator_base<const_iterator, value_type, std::bidirectional_iterator_tag, std::ptrdiff_t, const value_type*, const value_type&>
+		{
+			friend class btree_map;
+
+		private:
+			const Tree*			_tree;
+			Position			_position;
+
+		public:
+			const_iterator() : _tree() { }
+			const_iterator(const iterator& other) : _tree(other._tree), _position(other._position) { }
+
+			const value_type& dereference() const			{ return Tree::GetValue(_position); }
+			bool equal(const const_iterator& other) const	{ return _position == other._position; }
+			void increment()								{ _position = Tree::Next(_position); }
+			void decrement()								{ _position = _tree->Prev(_position); }
+
+		private:
+			const_iterator(const Tree* tree, const Position& position) : _tree(tree), _position(position) { }
+		};
+
+		typedef std::reverse_iterator<iterator>							reverse_iterator;
+		typedef std::reverse_iterator<const_iterator>					const_reverse_iterator;
+
+		class value_compare : public std::binary_function<value_type, value_type, bool>
+		{
+			friend class btree_map;
+
+		private:
+			Compare _cmp;
+
+		protected:
+			value_compare(Compare comp) : _cmp(comp) { }
+
+		public:
+			bool operator() (const value_type& lhs, const value_type& rhs) const
+			{ return _cmp(lhs.first, rhs.first); }
+		};
+
+	private:
+		Tree			_tree;
+
+	public:
+		explicit btree_map(const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: _tree(comp, alloc)
+		{ }
+
+		template < class InputIterator >
+		btree_map(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: _tree(comp, alloc)
+		{ insert(first, last); }
+
+		allocator_type get_allocator() const	{ return _tree.GetAllocator(); }
+
+		iterator begin()						{ return iterator(&_tree, _tree.Begin()); }
+		const_iterator begin() const			{ return const_iterator(&_tree, _tree.Begin()); }
+		iterator end()							{ return iterator(&_tree, _tree.End()); }
+		const_iterator end() const				{ return const_iterator(&_tree, _tree.End()); }
+
+		reverse_iterator rbegin()				{ return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const	{ return const_reverse_iterator(end()); }
+		reverse_iterator rend()					{ return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const		{ return const_reverse_iterator(begin()); }
+
+		bool empty() const						{ return _tree.GetSize() == 0; }
+		size_type size() const					{ return _tree.GetSize(); }
+		size_type max_size() const				{ return (size_type)-1 / sizeof(value_type); }
+
+		void clear()							{ _tree.Clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			const std::pair<Position, bool> result = _tree.Insert(value);
+			return std::make_pair(iterator(&_tree, result.first), result.second);
+		}
+
+		iterator insert(iterator hint, const value_type& value)
+		{ return insert(value).first; }
+
+		template < class InputIterator >
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				_tree.Insert(*first);
+		}
+
+		size_type erase(const key_type& key)
+		{
+			const Position position = _tree.Find(key);
+			if (position == _tree.End())
+				return 0;
+
+			_tree.Erase(position);
+			return 1;
+		}
+
+		/// @brief Returns the iterator to the next pair, all the other iterators are invalidated
+		iterator erase(iterator pos)
+		{ return iterator(&_tree, _tree.Erase(pos._position)); }
+
+		iterator erase(iterator first, iterator last)
+		{
+			for (difference_type count = std::distance(first, last); count != 0; --count)
+				first = erase(first);
+			return first;
+		}
+
+		void swap(btree_map& other)					{ _tree.Swap(other._tree); }
+
+		iterator find(const Key& key)				{ return iterator(&_tree, _tree.Find(key)); }
+		const_iterator find(const Key& key) const	{ return const_iterator(&_tree, _tree.Find(key)); }
+
+		size_type count(const Key& key) const
+		{ return _tree.Find(key) == _tree.End() ? 0 : 1; }
+
+		Value& at(const Key& key)
+		{
+			iterator result = find(key);
+			STINGRAYKIT_CHECK(result != end(), CreateKeyNotFoundException(key));
+			return result->second;
+		}
+
+		const Value& at(const Key& key) const
+		{
+			const_iterator result = find(key);
+			STINGRAYKIT_CHECK(result != end(), CreateKeyNotFoundException(key));
+			return result->second;
+		}
+
+		Value& operator [] (const Key& key)
+		{
+			const Position position = _tree.Find(key);
+			if (position != _tree.End())
+				return Tree::GetMutableValue(position).second;
+			return Tree::GetMutableValue(_tree.Insert(value_type(key, Value())).first).second;
+		}
+
+		iterator lower_bound(const Key& key)										{ return iterator(&_tree, _tree.LowerBound(key)); }
+		const_iterator lower_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.LowerBound(key)); }
+		iterator upper_bound(const Key& key)										{ return iterator(&_tree, _tree.UpperBound(key)); }
+		const_iterator upper_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.UpperBound(key)); }
+
+		std::pair<iterator,iterator> equal_range(const Key& key)					{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+		std::pair<const_iterator,const_iterator> equal_range(const Key& key) const	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+		key_compare key_comp() const												{ return _tree.GetCompare(); }
+		value_compare value_comp() const											{ return value_compare(_tree.GetCompare()); }
+	};
+
+	template < class K, class V, class C, class A >
+	bool operator == (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin()); }
+
+	template < class K, class V, class C, class A >
+	bool operator != (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return !(lhs == rhs); }
+
+	template < class K, class V, class C, class A >
+	bool operator < (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()); }
+
+	template < class K, class V, class C, class A >
+	bool operator <= (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return !(rhs < lhs); }
+
+	template < class K, class V, class C, class A >
+	bool operator > (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return rhs < lhs; }
+
+	template < class K, class V, class C, class A >
+	bool operator >= (const btree_map<K, V, C, A>& lhs, const btree_map<K, V, C, A>& rhs)
+	{ return !(lhs < rhs); }
+
+	/** @} */
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef STINGRAYKIT_COLLECTION_BTREE_SET_H
+#define STINGRAYKIT_COLLECTION_BTREE_SET_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/BTree.h>
+#include <stingraykit/collection/iterator_base.h>
+
+#include <functional>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	namespace Detail
+	{
+
+		template < class Key, class Compare, class Allocator, bool Multi_ >
+		class BTreeSetBase
+		{
+		public:
+			typedef Key														key_type;
+			typedef Key														value_type;
+			typedef size_t													size_type;
+			typedef std::ptrdiff_t											difference_type;
+			typedef Compare													key_compare;
+			typedef Compare													value_compare;
+			typedef Allocator												allocator_type;
+			typedef const value_type&										reference;
+			typedef const value_type&										const_reference;
+			typedef const value_type*										pointer;
+			typedef const value_type*										const_pointer;
+
+		protected:
+			struct KeyOfValue
+			{
+				const Key& operator () (const value_type& value) const	{ return value; }
+			};
+
+			typedef BTree<Key, value_type, KeyOfValue, Compare, Allocator, Multi_>	Tree;
+			typedef typename Tree::Position											Position;
+
+		public:
+			class const_iterator : public iterator_base<const_iterator, value_type, std::bidirectional_iterator_tag, std::ptrdiff_t, const value_type*, const value_type&>
+			{
+				friend class BTreeSetBase;
+
+			private:
+				const Tree*			_tree;
+				Position			_position;
+
+			public:
+				const_iterator() : _tree() { }
+
+				const value_type& dereference() const			{ return Tree::GetValue(_position); }
+				bool equal(const const_iterator& other) const	{ return _position == other._position; }
+				void increment()								{ _position = Tree::Next(_position); }
+				void decrement()								{ _position = _tree->Prev(_position); }
+
+			private:
+				const_iterator(const Tree* tree, const Position& position) : _tree(tree), _position(position) { }
+			};
+
+			typedef const_iterator											iterator;
+			typedef std::reverse_iterator<const_iterator>					reverse_iterator;
+			typedef std::reverse_iterator<const_iterator>					const_reverse_iterator;
+
+		protected:
+			Tree			_tree;
+
+		public:
+			explicit BTreeSetBase(const Compare& comp, const Allocator& alloc)
+				: _tree(comp, alloc)
+			{ }
+
+			allocator_type get_allocator() const	{ return _tree.GetAllocator(); }
+
+			const_iterator begin() const			{ return const_iterator(&_tree, _tree.Begin()); }
+			const_iterator end() const				{ return const_iterator(&_tree, _tree.End()); }
+
+			const_reverse_iterator rbegin() const	{ return const_reverse_iterator(end()); }
+			const_reverse_iterator rend() const		{ return const_reverse_iterator(begin()); }
+
+			bool empty() const						{ return _tree.GetSize() == 0; }
+			size_type size() const					{ return _tree.GetSize(); }
+			size_type max_size() const				{ return (size_type)-1 / sizeof(value_type); }
+
+			void clear()							{ _tree.Clear(); }
+
+			size_type erase(const key_type& key)
+			{
+				size_type result = 0;
+				for (Position position = _tree.LowerBound(key); position != _tree.End() && !_tree.GetCompare()(key, Tree::GetValue(position)); ++result)
+					position = _tree.Erase(position);
+				return result;
+			}
+
+			/// @brief Returns the iterator to the next value, all the other iterators are invalidated
+			iterator erase(iterator pos)
+			{ return iterator(&_tree, _tree.Erase(pos._position)); }
+
+			iterator erase(iterator first, iterator last)
+			{
+				for (difference_type count = std::distance(first, last); count != 0; --count)
+					first = erase(first);
+				return first;
+			}
+
+			const_iterator find(const Key& key) const	{ return const_iterator(&_tree, _tree.Find(key)); }
+
+			size_type count(const Key& key) const
+			{
+				if (!Multi_)
+					return _tree.Find(key) == _tree.End() ? 0 : 1;
+
+				const std::pair<const_iterator, const_iterator> range = equal_range(key);
+				return std::distance(range.first, range.second);
+			}
+
+			const_iterator lower_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.LowerBound(key)); }
+			const_iterator upper_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.UpperBound(key)); }
+
+			std::pair<const_iterator,const_iterator> equal_range(const Key& key) const	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+			key_compare key_comp() const												{ return _tree.GetCompare(); }
+			value_compare value_comp() const											{ return _tree.GetCompare(); }
+
+		protected:
+			const_iterator MakeIterator(const Position& position) const					{ return const_iterator(&_tree, position); }
+		};
+
+		template < class K, class C, class A, bool M >
+		bool operator == (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin()); }
+
+		template < class K, class C, class A, bool M >
+		bool operator != (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return !(lhs == rhs); }
+
+		template < class K, class C, class A, bool M >
+		bool operator < (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()); }
+
+		template < class K, class C, class A, bool M >
+		bool operator <= (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return !(rhs < lhs); }
+
+		template < class K, class C, class A, bool M >
+		bool operator > (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return rhs < lhs; }
+
+		template < class K, class C, class A, bool M >
+		bool operator >= (const BTreeSetBase<K, C, A, M>& lhs, const BTreeSetBase<K, C, A, M>& rhs)
+		{ return !(lhs < rhs); }
+
+	}
+
+
+	/**
+	 * @brief std::set replacement on a B+tree, the values are stored by dozens in the nodes of a few cache lines
+	 * @par It takes a few bytes of overhead per value instead of a node allocation, and the iteration goes through contiguous arrays.
+	 * Unlike std::set, insert and erase invalidate all the iterators, erase returns the iterator to the next value instead.
+	 */
+	template < class Key, class Compare = std::less<Key>, class Allocator = std::allocator<Key> >
+	class btree_set : public Detail::BTreeSetBase<Key, Compare, Allocator, false>
+	{
+		typedef Detail::BTreeSetBase<Key, Compare, Allocator, false>	base;
+
+	public:
+		typedef typename base::value_type								value_type;
+		typedef typename base::iterator									iterator;
+
+	public:
+		explicit btree_set(const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: base(comp, alloc)
+		{ }
+
+		template < class InputIterator >
+		btree_set(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: base(comp, alloc)
+		{ insert(first, last); }
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			const std::pair<typename base::Position, bool> result = this->_tree.Insert(value);
+			return std::make_pair(this->MakeIterator(result.first), result.second);
+		}
+
+		iterator insert(iterator hint, const value_type& value)
+		{ return insert(value).first; }
+
+		template < class InputIterator >
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				this->_tree.Insert(*first);
+		}
+
+		void swap(btree_set& other)		{ this->_tree.Swap(other._tree); }
+	};
+
+
+	/**
+	 * @brief std::multiset replacement on a B+tree, the equal values are kept in the insertion order
+	 * @see btree_set
+	 */
+	template < class Key, class Compare = std::less<Key>, class Allocator = std::allocator<Key> >
+	class btree_multiset : public Detail::BTreeSetBase<Key, Compare, Allocator, true>
+	{
+		typedef Detail::BTreeSetBase<Key, Compare, Allocator, true>		base;
+
+	public:
+		typedef typename base::value_type								value_type;
+		typedef typename base::iterator									iterator;
+
+	public:
+		explicit btree_multiset(const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: base(comp, alloc)
+		{ }
+
+		template < class InputIterator >
+		btree_multiset(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: base(comp, alloc)
+		{ insert(first, last); }
+
+		iterator insert(const value_type& value)
+		{ return this->MakeIterator(this->_tree.Insert(value).first); }
+
+		iterator insert(iterator hint, const value_type& value)
+		{ return insert(value); }
+
+		template < class InputIterator >
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				this->_tree.Insert(*first);
+		}
+
+		void swap(btree_multiset& other)	{ this->_tree.Swap(other._tree); }
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 // IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <stingraykit/collection/FlatCollectionHelpers.h>
 #include <stingraykit/collection/KeyNotFoundExceptionCreator.h>
 
 #include <vector>
@@ -82,8 +83,14 @@ namespace stingray
 
 		template < class InputIterator >
 		flat_map(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
-			: _container(alloc), _cmp(comp)
-		{ insert(first, last); }
+			: _container(first, last, alloc), _cmp(comp)
+		{ Detail::FlatMergeAppended(_container, 0, _cmp); }
+
+		/// @brief Takes the range as is, it must be sorted and have no equal keys
+		template < class InputIterator >
+		flat_map(const sorted_unique_tag&, InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: _container(first, last, alloc), _cmp(comp)
+		{ STINGRAYKIT_DEBUG_ASSERT(Detail::FlatIsSortedUnique(_container.begin(), _container.end(), _cmp)); }
 
 		flat_map(const flat_map& other)
 			: _container(other._container), _cmp(other._cmp)
@@ -129,12 +136,22 @@ namespace stingray
 			return insert(value).first;
 		}
 
-
+		/// @brief Sorts the range and merges it in, takes O(m log m + n) instead of O(m * n) for one by one insertion
 		template < class InputIterator >
 		void insert(InputIterator first, InputIterator last)
 		{
-			while (first != last)
-				insert(*(first++));
+			const size_type count = _container.size();
+			_container.insert(_container.end(), first, last);
+			Detail::FlatMergeAppended(_container, count, _cmp);
+		}
+
+		/// @brief Merges the range in, it must be sorted and have no equal keys
+		template < class InputIterator >
+		void insert(const sorted_unique_tag&, InputIterator first, InputIterator last)
+		{
+			const size_type count = _container.size();
+			_container.insert(_container.end(), first, last);
+			Detail::FlatMergeAppended(_container, count, _cmp, true);
 		}
 
 		size_type erase(const key_type& key)
@@ -196,13 +213,22 @@ namespace stingray
 			return result->second;
 		}
 
-		iterator lower_bound(const Key& key)										{ return std::lower_bound(begin(), end(), key, _cmp); }
-		const_iterator lower_bound(const Key& key) const							{ return std::lower_bound(begin(), end(), key, _cmp); }
-		iterator upper_bound(const Key& key)										{ return std::upper_bound(begin(), end(), key, _cmp); }
-		const_iterator upper_bound(const Key& key) const							{ return std::upper_bound(begin(), end(), key, _cmp); }
+		iterator lower_bound(const Key& key)										{ return Detail::FlatLowerBound(begin(), end(), key, _cmp); }
+		const_iterator lower_bound(const Key& key) const							{ return Detail::FlatLowerBound(begin(), end(), key, _cmp); }
+		iterator upper_bound(const Key& key)										{ return Detail::FlatUpperBound(begin(), end(), key, _cmp); }
+		const_iterator upper_bound(const Key& key) const							{ return Detail::FlatUpperBound(begin(), end(), key, _cmp); }
+
+		std::pair<iterator,iterator> equal_range(const Key& key)
+		{
+			const iterator result(lower_bound(key));
+			return std::make_pair(result, result == end() || _cmp(key, *result) ? result : result + 1);
+		}
 
-		std::pair<iterator,iterator> equal_range(const Key& key)					{ return std::equal_range(begin(), end(), key, _cmp); }
-		std::pair<const_iterator,const_iterator> equal_range(const Key& key) const	{ return std::equal_range(begin(), end(), key, _cmp); }
+		std::pair<const_iterator,const_iterator> equal_range(const Key& key) const
+		{
+			const const_iterator result(lower_bound(key));
+			return std::make_pair(result, result == end() || _cmp(key, *result) ? result : result + 1);
+		}
 
 		key_compare key_comp() const												{ return _cmp._cmp; }
 		value_compare value_comp() const											{ return value_compare(_cmp._cmp); }
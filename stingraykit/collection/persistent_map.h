@@ -0,0 +1,266 @@
+#ifndef STINGRAYKIT_COLLECTION_PERSISTENT_MAP_H
+#define STINGRAYKIT_COLLECTION_PERSISTENT_MAP_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/collection/iterator_base.h>
+#include <stingraykit/collection/KeyNotFoundExceptionCreator.h>
+#include <stingraykit/collection/PersistentBTree.h>
+
+#include <functional>
+#include <vector>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_collections
+	 * @{
+	 */
+
+	/**
+	 * @brief std::map replacement with O(1) copying, the copies share the tree nodes until they are modified
+	 * @par Every modification copies O(log n) nodes at most, so it's a cheap snapshot for the copy-on-write collections, e.g. MapDictionary.
+	 * Unlike std::map, insert and erase invalidate all the iterators. The values are modified with operator[], at() and the non-constant iterators,
+	 * which copy the path to the value if it is shared with another copy of the map. Dereferencing a non-constant iterator invalidates the other ones,
+	 * so reading should go through the const_iterator, which never copies the shared nodes.
+	 */
+	template < class Key, class Value, class Compare = std::less<Key>, class Allocator = std::allocator<std::pair<const Key, Value> > >
+	class persistent_map
+	{
+	public:
+		typedef Key														key_type;
+		typedef Value													mapped_type;
+		typedef std::pair<const Key, Value>								value_type;
+		typedef size_t													size_type;
+		typedef std::ptrdiff_t											difference_type;
+		typedef Compare													key_compare;
+		typedef Allocator												allocator_type;
+		typedef value_type&												reference;
+		typedef const value_type&										const_reference;
+		typedef value_type*												pointer;
+		typedef const value_type*										const_pointer;
+
+	private:
+		struct KeyOfValue
+		{
+			const Key& operator () (const value_type& value) const	{ return value.first; }
+		};
+
+		typedef Detail::PersistentBTree<Key, value_type, KeyOfValue, Compare, Allocator>	Tree;
+		typedef typename Tree::Position														Position;
+
+	public:
+		class const_iterator;
+
+		/// @brief Copies the path to the value on the first dereference if it is shared with another copy of the map, the iterator returned by the insertion
+		/// of a new value doesn't need that, since the insertion copies the path already
+		class iterator : public iterator_base<iterator, value_type, std::bidirectional_iterator_tag>
+		{
+			friend class persistent_map;
+			friend class const_iterator;
+
+		private:
+			Tree*				_tree;
+			mutable Position	_position;
+			mutable bool		_unshared;
+
+		public:
+			iterator() : _tree(), _unshared() { }
+
+			value_type& dereference() const
+			{
+				if (!_unshared)
+				{
+					_position = _tree->UnsharePath(_position);
+					_unshared = true;
+				}
+				return Tree::GetInsertedValue(_position);
+			}
+
+			bool equal(const iterator& other) const	{ return _position == other._position; }
+			void increment()						{ _position = _tree->Next(_position); _unshared = false; }
+			void decrement()						{ _position = _tree->Prev(_position); _unshared = false; }
+
+		private:
+			iterator(Tree* tree, const Position& position, bool unshared = false) : _tree(tree), _position(position), _unshared(unshared) { }
+		};
+
+		class const_iterator : public iterator_base<const_iterator, value_type, std::bidirectional_iterator_tag, std::ptrdiff_t, const value_type*, const value_type&>
+		{
+			friend class persistent_map;
+
+		private:
+			const Tree*			_tree;
+			Position			_position;
+
+		public:
+			const_iterator() : _tree() { }
+			const_iterator(const iterator& other) : _tree(other._tree), _position(other._position) { }
+
+			const value_type& dereference() const		{ return Tree::GetValue(_position); }
+			bool equal(const const_iterator& other) const	{ return _position == other._position; }
+			void increment()							{ _position = _tree->Next(_position); }
+			void decrement()							{ _position = _tree->Prev(_position); }
+
+		private:
+			const_iterator(const Tree* tree, const Position& position) : _tree(tree), _position(position) { }
+		};
+
+		typedef std::reverse_iterator<iterator>							reverse_iterator;
+		typedef std::reverse_iterator<const_iterator>					const_reverse_iterator;
+
+		class value_compare : public std::binary_function<value_type, value_type, bool>
+		{
+			friend class persistent_map;
+
+		private:
+			Compare _cmp;
+
+		protected:
+			value_compare(Compare comp) : _cmp(comp) { }
+
+		public:
+			bool operator() (const value_type& lhs, const value_type& rhs) const
+			{ return _cmp(lhs.first, rhs.first); }
+		};
+
+	private:
+		Tree			_tree;
+
+	public:
+		explicit persistent_map(const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: _tree(comp, alloc)
+		{ }
+
+		template < class InputIterator >
+		persistent_map(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+			: _tree(comp, alloc)
+		{ insert(first, last); }
+
+		allocator_type get_allocator() const	{ return _tree.GetAllocator(); }
+
+		iterator begin()						{ return iterator(&_tree, _tree.Begin()); }
+		const_iterator begin() const			{ return const_iterator(&_tree, _tree.Begin()); }
+		iterator end()							{ return iterator(&_tree, _tree.End()); }
+		const_iterator end() const				{ return const_iterator(&_tree, _tree.End()); }
+
+		reverse_iterator rbegin()				{ return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const	{ return const_reverse_iterator(end()); }
+		reverse_iterator rend()					{ return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const		{ return const_reverse_iterator(begin()); }
+
+		bool empty() const						{ return _tree.GetSize() == 0; }
+		size_type size() const					{ return _tree.GetSize(); }
+		size_type max_size() const				{ return (size_type)-1 / sizeof(value_type); }
+
+		void clear()							{ _tree.Clear(); }
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			const std::pair<Position, bool> result = _tree.Insert(value);
+			return std::make_pair(iterator(&_tree, result.first, result.second), result.second);
+		}
+
+		iterator insert(iterator hint, const value_type& value)
+		{ return insert(value).first; }
+
+		template < class InputIterator >
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		size_type erase(const key_type& key)
+		{ return _tree.Erase(key) ? 1 : 0; }
+
+		void erase(iterator pos)
+		{ _tree.Erase(Tree::GetValue(pos._position).first); }
+
+		void erase(iterator first, iterator last)
+		{
+			std::vector<key_type> keys;
+			for (; first != last; first.increment())
+				keys.push_back(Tree::GetValue(first._position).first);
+
+			for (typename std::vector<key_type>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+				_tree.Erase(*it);
+		}
+
+		void swap(persistent_map& other)		{ _tree.Swap(other._tree); }
+
+		iterator find(const Key& key)				{ return iterator(&_tree, _tree.Find(key)); }
+		const_iterator find(const Key& key) const	{ return const_iterator(&_tree, _tree.Find(key)); }
+
+		size_type count(const Key& key) const
+		{ return _tree.Find(key) == _tree.End() ? 0 : 1; }
+
+		Value& at(const Key& key)
+		{
+			value_type* const result = _tree.FindMutable(key);
+			STINGRAYKIT_CHECK(result, CreateKeyNotFoundException(key));
+			return result->second;
+		}
+
+		const Value& at(const Key& key) const
+		{
+			const_iterator result = find(key);
+			STINGRAYKIT_CHECK(result != end(), CreateKeyNotFoundException(key));
+			return result->second;
+		}
+
+		Value& operator [] (const Key& key)
+		{
+			value_type* const result = _tree.FindMutable(key);
+			if (result)
+				return result->second;
+			return Tree::GetInsertedValue(_tree.Insert(value_type(key, Value())).first).second;
+		}
+
+		iterator lower_bound(const Key& key)										{ return iterator(&_tree, _tree.LowerBound(key)); }
+		const_iterator lower_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.LowerBound(key)); }
+		iterator upper_bound(const Key& key)										{ return iterator(&_tree, _tree.UpperBound(key)); }
+		const_iterator upper_bound(const Key& key) const							{ return const_iterator(&_tree, _tree.UpperBound(key)); }
+
+		std::pair<iterator,iterator> equal_range(const Key& key)					{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+		std::pair<const_iterator,const_iterator> equal_range(const Key& key) const	{ return std::make_pair(lower_bound(key), upper_bound(key)); }
+
+		key_compare key_comp() const												{ return _tree.GetCompare(); }
+		value_compare value_comp() const											{ return value_compare(_tree.GetCompare()); }
+	};
+
+	template < class K, class V, class C, class A >
+	bool operator == (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin()); }
+
+	template < class K, class V, class C, class A >
+	bool operator != (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return !(lhs == rhs); }
+
+	template < class K, class V, class C, class A >
+	bool operator < (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()); }
+
+	template < class K, class V, class C, class A >
+	bool operator <= (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return !(rhs < lhs); }
+
+	template < class K, class V, class C, class A >
+	bool operator > (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return rhs < lhs; }
+
+	template < class K, class V, class C, class A >
+	bool operator >= (const persistent_map<K, V, C, A>& lhs, const persistent_map<K, V, C, A>& rhs)
+	{ return !(lhs < rhs); }
+
+	/** @} */
+
+}
+
+#endif
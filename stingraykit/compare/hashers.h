@@ -0,0 +1,106 @@
+#ifndef STINGRAYKIT_COMPARE_HASHERS_H
+#define STINGRAYKIT_COMPARE_HASHERS_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/function/function_info.h>
+#include <stingraykit/metaprogramming/NestedTypeCheck.h>
+#include <stingraykit/toolkit.h>
+
+#include <string>
+
+namespace stingray
+{
+
+	namespace hashers
+	{
+
+		namespace Detail
+		{
+			STINGRAYKIT_DECLARE_METHOD_CHECK(GetHash);
+
+			/// @brief Murmur3 finalizer, every bit of the value affects the low bits, so the result may be masked by a power of two table size
+			inline size_t MixHash(u64 value)
+			{
+				value ^= value >> 33;
+				value *= 0xff51afd7ed558ccdULL;
+				value ^= value >> 33;
+				value *= 0xc4ceb9fe1a85ec53ULL;
+				value ^= value >> 33;
+				return (size_t)value;
+			}
+
+			/// @brief FNV-1a
+			inline size_t HashBytes(const char* data, size_t size)
+			{
+				u64 result = 14695981039346656037ULL;
+				for (size_t i = 0; i < size; ++i)
+					result = (result ^ (u8)data[i]) * 1099511628211ULL;
+				return MixHash(result);
+			}
+
+			struct HashKind
+			{
+				enum Enum { Method, Integral, EnumClass, Pointer, String };
+			};
+
+			template < typename T >
+			struct GetHashKind
+			{
+				static const HashKind::Enum Value =
+						HasMethod_GetHash<T>::Value ? HashKind::Method :
+						IsEnumClass<T>::Value ? HashKind::EnumClass :
+						IsPointer<T>::Value ? HashKind::Pointer :
+						SameType<T, std::string>::Value ? HashKind::String :
+						HashKind::Integral;
+			};
+
+			template < typename T, HashKind::Enum Kind_ = GetHashKind<T>::Value >
+			struct HashImpl;
+
+			template < typename T >
+			struct HashImpl<T, HashKind::Method>
+			{ static size_t Do(const T& value) { return MixHash((u64)value.GetHash()); } };
+
+			template < typename T >
+			struct HashImpl<T, HashKind::Integral>
+			{ static size_t Do(const T& value) { return MixHash((u64)value); } };
+
+			template < typename T >
+			struct HashImpl<T, HashKind::EnumClass>
+			{ static size_t Do(const T& value) { return MixHash((u64)value.val()); } };
+
+			template < typename T >
+			struct HashImpl<T, HashKind::Pointer>
+			{ static size_t Do(const T& value) { return MixHash((u64)(uintptr_t)value); } };
+
+			template < typename T >
+			struct HashImpl<T, HashKind::String>
+			{ static size_t Do(const T& value) { return HashBytes(value.data(), value.size()); } };
+		}
+
+
+		/// @brief Hashes integers, enum classes, pointers and strings, other types have to provide a size_t GetHash() const method
+		/// @par Values that are equal according to comparers::Equals must have the same hash. The GetHash results are mixed as the integers are,
+		/// so that the users may take either the low or the high bits of the hash, e.g. HashDictionary and ShardedCache do
+		struct Hash : public function_info<size_t, UnspecifiedParamTypes>
+		{
+			template < typename T >
+			size_t operator () (const T& value) const
+			{ return Detail::HashImpl<T>::Do(value); }
+		};
+
+
+		inline size_t CombineHashes(size_t seed, size_t hash)
+		{ return Detail::MixHash((u64)seed * 31 + hash); }
+
+	}
+
+}
+
+#endif
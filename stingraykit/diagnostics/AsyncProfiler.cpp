@@ -15,10 +15,12 @@ namespace stingray
 
 	AsyncProfiler::SessionImpl::SessionImpl(const char* name) :
 		_name(name),
+		_backtrace(Backtrace()),
 		_threadInfo(Thread::GetCurrentThreadInfo()),
 		_startTime(TimeEngine::GetMonotonicMicroseconds())
 	{ }
 
+	// Name getter sessions are opened by executors, whose backtrace always ends in the executor loop, so capturing it is a waste of time
 	AsyncProfiler::SessionImpl::SessionImpl(const optional<NameGetterFunc>& nameGetter) :
 		_name(null),
 		_nameGetter(nameGetter),
@@ -87,9 +89,11 @@ namespace stingray
 		MutexLock l(_mutex);
 		while (token)
 		{
+			// sessions are queued in order of their timeouts, and a new one never expires earlier than the current wait ends,
+			// so AddSession and RemoveSession don't need to wake this thread up
 			if (_sessions.empty())
 			{
-				_condition.Wait(_mutex, token);
+				_condition.TimedWait(_mutex, TimeDuration::FromMicroseconds(_timeoutMicroseconds), token);
 				continue;
 			}
 
@@ -97,7 +101,7 @@ namespace stingray
 			u64 timeNow = TimeEngine::GetMonotonicMicroseconds();
 			if (timeNow < top.GetAbsoluteTimeout())
 			{
-				_condition.TimedWait(_mutex, TimeDuration::FromMicroseconds(top.GetAbsoluteTimeout() - timeNow));
+				_condition.TimedWait(_mutex, TimeDuration::FromMicroseconds(top.GetAbsoluteTimeout() - timeNow), token);
 				continue;
 			}
 
@@ -109,10 +113,13 @@ namespace stingray
 			std::string name(top.GetName());
 			std::string tname(top.GetThreadName());
 			u64 startTime = top.GetStartTime();
-			std::string backtrace(top.GetBacktrace());
+			optional<std::string> backtrace(top.GetBacktrace());
 
 			MutexUnlock ul(l);
-			s_logger.Error() << "Task " << name << " in thread " << tname << " is being executed for more than " << TimeDuration::FromMicroseconds(timeNow - startTime) << " invoked from: " << backtrace;
+			if (backtrace)
+				s_logger.Error() << "Task " << name << " in thread " << tname << " is being executed for more than " << TimeDuration::FromMicroseconds(timeNow - startTime) << " invoked from: " << *backtrace;
+			else
+				s_logger.Error() << "Task " << name << " in thread " << tname << " is being executed for more than " << TimeDuration::FromMicroseconds(timeNow - startTime);
 		}
 	}
 
@@ -120,18 +127,14 @@ namespace stingray
 	void AsyncProfiler::AddSession(SessionImpl& session)
 	{
 		MutexLock l(_mutex);
-		session.SetAbsoluteTimeout(TimeEngine::GetMonotonicMicroseconds() + _timeoutMicroseconds);
+		session.SetAbsoluteTimeout(session.GetStartTime() + _timeoutMicroseconds);
 		_sessions.push_back(session);
-		if (&*_sessions.begin() == &session)
-			_condition.Broadcast();
 	}
 
 
 	void AsyncProfiler::RemoveSession(SessionImpl& session)
 	{
 		MutexLock l(_mutex);
-		if (&*_sessions.begin() == &session)
-			_condition.Broadcast();
 		_sessions.erase(session);
 	}
 
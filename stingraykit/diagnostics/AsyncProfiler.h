@@ -57,7 +57,8 @@ namespace stingray
 		private:
 			const char*					_name;
 			optional<NameGetterFunc>	_nameGetter;
-			Backtrace					_backtrace;
+			optional<std::string>		_cachedName;
+			optional<Backtrace>			_backtrace;
 			IThreadInfoPtr				_threadInfo;
 			u64							_startTime;
 			u64							_timeoutTime;
@@ -68,16 +69,18 @@ namespace stingray
 
 			std::string GetName()
 			{
-				if (!_name)
-					return _nameGetter.get()();
-				return _name;
+				if (_name)
+					return _name;
+				if (!_cachedName)
+					_cachedName = _nameGetter.get()();
+				return *_cachedName;
 			}
 
 			std::string GetThreadName() const
 			{ return _threadInfo->GetName(); }
 
-			std::string GetBacktrace() const
-			{ return _backtrace.Get(); }
+			optional<std::string> GetBacktrace() const
+			{ return _backtrace ? _backtrace->Get() : optional<std::string>(); }
 
 			u64 GetStartTime() const
 			{ return _startTime; }
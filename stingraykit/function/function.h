@@ -263,12 +263,15 @@ namespace stingray
 
 	class function_storage
 	{
+		typedef Detail::IInvokableBase::VTable::InvokePtr	InvokePtr;
+
 	private:
 		self_count_ptr<Detail::IInvokableBase>	_invokable;
+		InvokePtr								_invoke; // resolved once, so that Invoke doesn't have to query the vtable
 
 	public:
 		template<typename Signature>
-		explicit function_storage(const function<Signature> &func) : _invokable(func._invokable)
+		explicit function_storage(const function<Signature> &func) : _invokable(func._invokable), _invoke(func._invokable->_getVTable().Invoke)
 		{ }
 
 		template<typename Signature>
@@ -277,6 +280,16 @@ namespace stingray
 			typedef typename function<Signature>::InvokableTypePtr TargetInvokablePtr;
 			return function<Signature>(TargetInvokablePtr(_invokable, static_cast_tag()), Dummy());
 		}
+
+		/// @brief Invokes the stored function without constructing an intermediate function object. Signature must match the one the storage was created from.
+		template<typename Signature>
+		typename function_info<Signature>::RetType Invoke(const Tuple<typename function_info<Signature>::ParamTypes>& p) const
+		{
+			typedef Detail::IInvokable<Signature>			InvokableType;
+			typedef typename InvokableType::InvokeFunc		InvokeFunc;
+
+			return reinterpret_cast<InvokeFunc*>(_invoke)(static_cast<InvokableType*>(_invokable.get()), p);
+		}
 	};
 
 #else
@@ -0,0 +1,387 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/FlightRecorder.h>
+
+#include <stingraykit/string/ToString.h>
+#include <stingraykit/thread/Thread.h>
+#include <stingraykit/thread/atomic/AtomicInt.h>
+#include <stingraykit/thread/posix/ThreadLocal.h>
+#include <stingraykit/time/TimeEngine.h>
+#include <stingraykit/unique_ptr.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace stingray
+{
+
+	namespace
+	{
+
+		typedef BasicAtomicInt<intptr_t>	AtomicPtr;
+
+		const size_t MaxRecordSize = 1024;
+		const size_t MaxThreadNameSize = 32;
+
+		const char LevelLetters[] = { 'T', 'D', 'I', 'W', 'E', 'S' };
+
+
+		struct SlotHeader
+		{
+			AtomicU32::Type		Sequence; // odd while the slot is being written
+			u32					Size;
+			s64					Time;
+			u32					Level;
+		};
+
+
+		struct RingHeader
+		{
+			AtomicU32::Type		Owned;
+			AtomicU32::Type		Count; // number of messages recorded since the ring was taken
+			char				ThreadName[MaxThreadNameSize];
+		};
+
+
+		class FlightRecorderRings
+		{
+			typedef std::vector<u64>		Storage;
+
+		private:
+			const size_t		_maxThreads;
+			const size_t		_recordsPerThread;
+			const size_t		_recordSize;
+			const size_t		_slotSize;
+			const size_t		_ringSize;
+			Storage				_storage;
+
+		public:
+			FlightRecorderRings(size_t maxThreads, size_t recordsPerThread, size_t recordSize) :
+				_maxThreads(maxThreads),
+				_recordsPerThread(recordsPerThread),
+				_recordSize(recordSize),
+				_slotSize(AlignUp(sizeof(SlotHeader) + recordSize)),
+				_ringSize(AlignUp(sizeof(RingHeader)) + _slotSize * recordsPerThread),
+				_storage(_ringSize * maxThreads / sizeof(u64))
+			{ }
+
+			RingHeader* TakeRing()
+			{
+				const std::string& threadName = Thread::GetCurrentThreadName();
+
+				// rings of the exited threads are reused only when there are no unused ones, so that their messages are kept as long as possible
+				for (size_t i = 0; i < 2 * _maxThreads; ++i)
+				{
+					RingHeader* const ring = GetRing(i % _maxThreads);
+					if (i < _maxThreads && AtomicU32::Load(ring->Count, MemoryOrderRelaxed) != 0)
+						continue;
+					if (AtomicU32::CompareAndExchange(ring->Owned, 0, 1) != 0)
+						continue;
+
+					AtomicU32::Store(ring->Count, 0);
+					const size_t size = std::min(threadName.size(), MaxThreadNameSize - 1);
+					std::copy(threadName.begin(), threadName.begin() + size, ring->ThreadName);
+					ring->ThreadName[size] = 0;
+					return ring;
+				}
+
+				return NULL;
+			}
+
+			void ReleaseRing(RingHeader* ring)
+			{ AtomicU32::Store(ring->Owned, 0); }
+
+			void Record(RingHeader* ring, const char* loggerName, LogLevel logLevel, const string_ostream& message)
+			{
+				const u32 index = AtomicU32::Load(ring->Count, MemoryOrderRelaxed);
+				SlotHeader* const slot = GetSlot(ring, index % _recordsPerThread);
+				char* const text = reinterpret_cast<char*>(slot + 1);
+
+				const u32 sequence = AtomicU32::Load(slot->Sequence, MemoryOrderRelaxed);
+				AtomicU32::Store(slot->Sequence, sequence + 1); // seq_cst, so that the text is not written before the slot is marked
+
+				size_t size = 0;
+				if (loggerName)
+				{
+					size = AppendText(text, size, "[");
+					size = AppendText(text, size, loggerName);
+					size = AppendText(text, size, "] ");
+				}
+				size += message.copy_to(text + size, _recordSize - size);
+
+				slot->Size = size;
+				slot->Time = TimeEngine::GetMillisecondsSinceEpoch();
+				slot->Level = logLevel.val();
+
+				AtomicU32::Store(slot->Sequence, sequence + 2, MemoryOrderRelease);
+				AtomicU32::Store(ring->Count, index + 1, MemoryOrderRelease);
+			}
+
+			void Dump(int fd)
+			{
+				WriteText(fd, "Flight recorder dump:\n");
+
+				char line[MaxRecordSize + 32];
+				for (size_t i = 0; i < _maxThreads; ++i)
+				{
+					RingHeader* const ring = GetRing(i);
+					const u32 count = AtomicU32::Load(ring->Count, MemoryOrderAcquire);
+					if (count == 0)
+						continue;
+
+					WriteText(fd, "Thread '");
+					WriteText(fd, ring->ThreadName);
+					WriteText(fd, AtomicU32::Load(ring->Owned, MemoryOrderRelaxed) ? "':\n" : "' (exited):\n");
+
+					for (u32 index = count > _recordsPerThread ? count - _recordsPerThread : 0; index != count; ++index)
+					{
+						SlotHeader* const slot = GetSlot(ring, index % _recordsPerThread);
+
+						const u32 sequence = AtomicU32::Load(slot->Sequence, MemoryOrderAcquire);
+						if (sequence == 0 || sequence % 2 != 0)
+							continue;
+
+						const size_t prefixSize = FormatPrefix(line, slot->Time, slot->Level);
+						const size_t size = std::min((size_t)slot->Size, _recordSize);
+						memcpy(line + prefixSize, slot + 1, size);
+
+						// the slot is overwritten by its owner, if it is still logging
+						if (AtomicU32::Load(slot->Sequence, MemoryOrderAcquire) != sequence)
+							continue;
+
+						line[prefixSize + size] = '\n';
+						WriteData(fd, line, prefixSize + size + 1);
+					}
+				}
+			}
+
+		private:
+			static size_t AlignUp(size_t size)
+			{ return (size + sizeof(u64) - 1) / sizeof(u64) * sizeof(u64); }
+
+			RingHeader* GetRing(size_t index)
+			{ return reinterpret_cast<RingHeader*>(reinterpret_cast<u8*>(&_storage[0]) + _ringSize * index); }
+
+			SlotHeader* GetSlot(RingHeader* ring, size_t index)
+			{ return reinterpret_cast<SlotHeader*>(reinterpret_cast<u8*>(ring) + AlignUp(sizeof(RingHeader)) + _slotSize * index); }
+
+			size_t AppendText(char* text, size_t offset, const char* str)
+			{
+				while (*str && offset < _recordSize)
+					text[offset++] = *str++;
+				return offset;
+			}
+
+			static size_t FormatPrefix(char* line, s64 time, u32 level)
+			{
+				const s64 msPerDay = 24 * 60 * 60 * 1000;
+				s64 ms = (time + (s64)TimeEngine::GetMinutesFromUtc() * 60 * 1000) % msPerDay;
+				if (ms < 0)
+					ms += msPerDay;
+
+				char* p = line;
+				p = FormatNumber(p, ms / (60 * 60 * 1000), 2);
+				*p++ = ':';
+				p = FormatNumber(p, ms / (60 * 1000) % 60, 2);
+				*p++ = ':';
+				p = FormatNumber(p, ms / 1000 % 60, 2);
+				*p++ = '.';
+				p = FormatNumber(p, ms % 1000, 3);
+				*p++ = ' ';
+				*p++ = level < sizeof(LevelLetters) ? LevelLetters[level] : '?';
+				*p++ = ' ';
+				return p - line;
+			}
+
+			static char* FormatNumber(char* p, s64 value, int digits)
+			{
+				for (int i = digits - 1; i >= 0; --i, value /= 10)
+					p[i] = (char)('0' + value % 10);
+				return p + digits;
+			}
+
+			static void WriteText(int fd, const char* str)
+			{ WriteData(fd, str, strlen(str)); }
+
+			static void WriteData(int fd, const char* data, size_t size)
+			{
+				while (size != 0)
+				{
+					const ssize_t written = write(fd, data, size);
+					if (written < 0 && errno == EINTR)
+						continue;
+					if (written <= 0)
+						return;
+
+					data += written;
+					size -= written;
+				}
+			}
+		};
+
+
+		struct FlightRecorderSignalDumper
+		{
+			static struct sigaction		s_previousActions[NSIG];
+
+			/// @brief Sets the handler directly rather than with posix::SignalHandlerSetter, since the recorder is never disabled and must work regardless of STINGRAY_SIGNAL_HANDLING_ENABLED
+			/// @par The previous action is saved before the handler is set, so that the handler never sees an action that is not saved yet
+			static void Install(int signalNum)
+			{
+				struct sigaction action;
+				memset(&action, 0, sizeof(action));
+				action.sa_sigaction = &HandlerFunc;
+				action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+				sigemptyset(&action.sa_mask);
+
+				STINGRAYKIT_CHECK(sigaction(signalNum, NULL, &s_previousActions[signalNum]) == 0, SystemException("sigaction"));
+				STINGRAYKIT_CHECK(sigaction(signalNum, &action, NULL) == 0, SystemException("sigaction"));
+			}
+
+			static void HandlerFunc(int signalNum, siginfo_t* sigInfo, void* ctx)
+			{
+				FlightRecorder::DumpOnFatalError();
+
+				// the application crash handlers that were set before the recorder are chained to
+				const struct sigaction& previous = s_previousActions[signalNum];
+				if (previous.sa_flags & SA_SIGINFO)
+				{
+					if (previous.sa_flags & SA_RESETHAND)
+						signal(signalNum, SIG_DFL);
+					previous.sa_sigaction(signalNum, sigInfo, ctx);
+				}
+				else if (previous.sa_handler == SIG_DFL || previous.sa_handler == SIG_IGN)
+				{
+					// the signal is blocked within the handler, so the restored action takes it as soon as the handler returns
+					sigaction(signalNum, &previous, NULL);
+					if (previous.sa_handler == SIG_DFL)
+						raise(signalNum);
+				}
+				else
+				{
+					if (previous.sa_flags & SA_RESETHAND)
+						signal(signalNum, SIG_DFL);
+					previous.sa_handler(signalNum);
+				}
+			}
+		};
+		struct sigaction FlightRecorderSignalDumper::s_previousActions[NSIG];
+
+		const int DumpSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
+
+		/// @brief Is never destroyed once enabled, since recording threads don't synchronize with anything
+		struct FlightRecorderState
+		{
+			FlightRecorderRings		Rings;
+
+			FlightRecorderState(size_t maxThreads, size_t recordsPerThread, size_t recordSize) :
+				Rings(maxThreads, recordsPerThread, recordSize)
+			{ }
+		};
+
+
+		intptr_t s_state = 0;
+		u32 s_dumping = 0;
+		u32 s_fatalErrorDumped = 0;
+
+
+		FlightRecorderRings* GetRings()
+		{
+			FlightRecorderState* const state = reinterpret_cast<FlightRecorderState*>(AtomicPtr::Load(s_state, MemoryOrderAcquire));
+			return state ? &state->Rings : NULL;
+		}
+
+
+		struct FlightRecorderRingHolder
+		{
+			RingHeader*		Ring;
+			bool			Taken;
+
+			FlightRecorderRingHolder() : Ring(NULL), Taken(false) { }
+
+			~FlightRecorderRingHolder()
+			{
+				if (Ring)
+					GetRings()->ReleaseRing(Ring);
+			}
+		};
+
+		STINGRAYKIT_DECLARE_THREAD_LOCAL(FlightRecorderRingHolder, FlightRecorderRingHolderHolder);
+		STINGRAYKIT_DEFINE_THREAD_LOCAL(FlightRecorderRingHolder, FlightRecorderRingHolderHolder);
+
+	}
+
+
+	u32 FlightRecorder::s_logLevel = ~0u;
+
+
+	void FlightRecorder::Enable(size_t maxThreads, size_t recordsPerThread, size_t recordSize, LogLevel logLevel, bool dumpOnSignals)
+	{
+		STINGRAYKIT_CHECK(maxThreads != 0, ArgumentException("maxThreads"));
+		STINGRAYKIT_CHECK(recordsPerThread != 0, ArgumentException("recordsPerThread"));
+		STINGRAYKIT_CHECK(recordSize != 0 && recordSize <= MaxRecordSize, ArgumentException("recordSize", recordSize));
+
+		unique_ptr<FlightRecorderState> state(new FlightRecorderState(maxThreads, recordsPerThread, recordSize));
+		STINGRAYKIT_CHECK(AtomicPtr::CompareAndExchange(s_state, 0, reinterpret_cast<intptr_t>(state.get())) == 0, InvalidOperationException("Flight recorder is already enabled"));
+		state.release();
+
+		AtomicU32::Store(s_logLevel, logLevel.val());
+
+		// only the call that enabled the recorder gets here, so the saved actions are never the recorder handler itself
+		if (dumpOnSignals)
+			for (size_t i = 0; i < ArraySize(DumpSignals); ++i)
+				FlightRecorderSignalDumper::Install(DumpSignals[i]);
+	}
+
+
+	void FlightRecorder::Record(const char* loggerName, LogLevel logLevel, const string_ostream& message)
+	{
+		FlightRecorderRings* const rings = GetRings();
+		if (!rings)
+			return;
+
+		FlightRecorderRingHolder& holder = FlightRecorderRingHolderHolder::Get();
+		if (!holder.Taken)
+		{
+			holder.Ring = rings->TakeRing();
+			holder.Taken = true;
+		}
+
+		if (holder.Ring)
+			rings->Record(holder.Ring, loggerName, logLevel, message);
+	}
+
+
+	void FlightRecorder::Dump(int fd)
+	{
+		FlightRecorderRings* const rings = GetRings();
+		if (!rings || AtomicU32::CompareAndExchange(s_dumping, 0, 1) != 0)
+			return;
+
+		rings->Dump(fd);
+		AtomicU32::Store(s_dumping, 0);
+	}
+
+
+	void FlightRecorder::Dump()
+	{ Dump(STDERR_FILENO); }
+
+
+	void FlightRecorder::DumpOnFatalError()
+	{
+		if (AtomicU32::CompareAndExchange(s_fatalErrorDumped, 0, 1) == 0)
+			Dump();
+	}
+
+}
@@ -0,0 +1,58 @@
+#ifndef STINGRAYKIT_LOG_FLIGHTRECORDER_H
+#define STINGRAYKIT_LOG_FLIGHTRECORDER_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/LogLevel.h>
+#include <stingraykit/thread/atomic/AtomicInt.h>
+#include <stingraykit/string/string_stream.h>
+
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief Keeps the most recent messages of every thread in memory, so that the context of a crash can be dumped even if it was not logged
+	 * @par Messages at or above the recorder log level are recorded regardless of the Logger and NamedLogger log levels.
+	 * All the memory is allocated by Enable, each thread takes one of the fixed-size rings on its first message and gives it back on exit,
+	 * so recording neither allocates nor locks. Threads that don't get a ring are not recorded.
+	 * The rings are dumped by STINGRAYKIT_FATAL, by fatal signals and by Dump calls.
+	 */
+	class FlightRecorder
+	{
+		static u32		s_logLevel; // lowest recorded level, or a value above any level if the recorder is disabled
+
+	public:
+		/// @brief Allocates the rings, the recorder stays enabled until the process exits
+		/// @param maxThreads number of rings
+		/// @param recordSize maximum length of the recorded message text, longer ones are truncated
+		/// @param dumpOnSignals makes SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT dump the rings to stderr, the handlers that were set before are called after the dump
+		static void Enable(size_t maxThreads = 64, size_t recordsPerThread = 256, size_t recordSize = 200, LogLevel logLevel = LogLevel::Trace, bool dumpOnSignals = true);
+
+		static bool IsEnabled(LogLevel logLevel)	{ return (u32)logLevel.val() >= AtomicU32::Load(s_logLevel, MemoryOrderRelaxed); }
+
+		static void Record(const char* loggerName, LogLevel logLevel, const string_ostream& message);
+
+		/// @brief Writes the recorded messages to the given file descriptor, uses only async-signal-safe calls
+		static void Dump(int fd);
+		static void Dump();
+
+		/// @brief Dumps the rings to stderr only once per process, so that a fatal error followed by the SIGABRT of std::terminate is not dumped twice
+		static void DumpOnFatalError();
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -26,6 +26,9 @@ namespace stingray
 		virtual ~ILoggerSink() { }
 
 		virtual void Log(const LoggerMessage& message) = 0;
+
+		/// @brief Called after a batch of messages is logged, sinks that buffer messages write them out here
+		virtual void Flush() { }
 	};
 	STINGRAYKIT_DECLARE_PTR(ILoggerSink);
 
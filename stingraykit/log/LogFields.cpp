@@ -0,0 +1,167 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/LogFields.h>
+
+#include <stingraykit/exception.h>
+
+#include <limits>
+
+namespace stingray
+{
+
+	// field layout: type (u8), key size (u16), key, value; string values are prefixed with their size (u32)
+
+	namespace
+	{
+
+		const size_t FieldHeaderSize = sizeof(u8) + sizeof(u16);
+
+		template < typename T >
+		T ReadRaw(const u8* pos)
+		{
+			T result;
+			memcpy(&result, pos, sizeof(T));
+			return result;
+		}
+
+	}
+
+
+	const char* LogFields::Field::GetStringData() const
+	{
+		CheckType(FieldType::String);
+		return reinterpret_cast<const char*>(_value + sizeof(u32));
+	}
+
+
+	size_t LogFields::Field::GetStringSize() const
+	{
+		CheckType(FieldType::String);
+		return _valueSize - sizeof(u32);
+	}
+
+
+	void LogFields::Field::FormatValue(string_ostream& result) const
+	{
+		switch (_type)
+		{
+		case FieldType::Bool:		stingray::ToString(result, GetBool()); break;
+		case FieldType::Int:		stingray::ToString(result, GetInt()); break;
+		case FieldType::UInt:		stingray::ToString(result, GetUInt()); break;
+		case FieldType::Double:		stingray::ToString(result, GetDouble()); break;
+		case FieldType::String:		result.write(GetStringData(), GetStringSize()); break;
+		}
+	}
+
+
+	void LogFields::Field::CheckType(FieldType type) const
+	{ STINGRAYKIT_CHECK(_type == type.val(), InvalidOperationException(StringBuilder() % "Field '" % GetKey() % "' is " % FieldType(_type) % ", not " % type)); }
+
+
+	LogFields::const_iterator::const_iterator(const u8* pos, const u8* end) :
+		_pos(pos), _end(end)
+	{ Parse(); }
+
+
+	void LogFields::const_iterator::increment()
+	{
+		_pos = reinterpret_cast<const u8*>(_field._value) + _field._valueSize;
+		Parse();
+	}
+
+
+	void LogFields::const_iterator::Parse()
+	{
+		if (_pos == _end)
+			return;
+
+		_field._type = (FieldType::Enum)_pos[0];
+		_field._keySize = ReadRaw<u16>(_pos + sizeof(u8));
+		_field._key = reinterpret_cast<const char*>(_pos + FieldHeaderSize);
+		_field._value = _pos + FieldHeaderSize + _field._keySize;
+
+		switch (_field._type)
+		{
+		case FieldType::Bool:		_field._valueSize = sizeof(u8); break;
+		case FieldType::Int:		_field._valueSize = sizeof(s64); break;
+		case FieldType::UInt:		_field._valueSize = sizeof(u64); break;
+		case FieldType::Double:		_field._valueSize = sizeof(double); break;
+		case FieldType::String:		_field._valueSize = sizeof(u32) + ReadRaw<u32>(_field._value); break;
+		}
+	}
+
+
+	LogFields::const_iterator LogFields::begin() const
+	{ return _data.empty() ? const_iterator() : const_iterator(&_data[0], &_data[0] + _data.size()); }
+
+
+	LogFields::const_iterator LogFields::end() const
+	{ return _data.empty() ? const_iterator() : const_iterator(&_data[0] + _data.size(), &_data[0] + _data.size()); }
+
+
+	void LogFields::AddBool(const char* key, bool value)
+	{ *AddField(FieldType::Bool, key, sizeof(u8)) = value ? 1 : 0; }
+
+
+	void LogFields::AddInt(const char* key, s64 value)
+	{ memcpy(AddField(FieldType::Int, key, sizeof(s64)), &value, sizeof(s64)); }
+
+
+	void LogFields::AddUInt(const char* key, u64 value)
+	{ memcpy(AddField(FieldType::UInt, key, sizeof(u64)), &value, sizeof(u64)); }
+
+
+	void LogFields::AddDouble(const char* key, double value)
+	{ memcpy(AddField(FieldType::Double, key, sizeof(double)), &value, sizeof(double)); }
+
+
+	void LogFields::AddString(const char* key, const char* value, size_t size)
+	{
+		const u32 size32 = (u32)std::min(size, (size_t)std::numeric_limits<u32>::max());
+		u8* const dst = AddField(FieldType::String, key, sizeof(u32) + size32);
+		memcpy(dst, &size32, sizeof(u32));
+		if (size32)
+			memcpy(dst + sizeof(u32), value, size32);
+	}
+
+
+	void LogFields::Format(string_ostream& result) const
+	{
+		for (const_iterator it = begin(); it != end(); ++it)
+		{
+			result << " ";
+			result.write(it->GetKeyData(), it->GetKeySize());
+			result << "=";
+			it->FormatValue(result);
+		}
+	}
+
+
+	std::string LogFields::ToString() const
+	{
+		string_ostream result;
+		Format(result);
+		return result.str();
+	}
+
+
+	u8* LogFields::AddField(FieldType type, const char* key, size_t valueSize)
+	{
+		const u16 keySize = (u16)std::min(strlen(key), (size_t)std::numeric_limits<u16>::max());
+
+		const size_t offset = _data.size();
+		_data.resize(offset + FieldHeaderSize + keySize + valueSize);
+
+		u8* const dst = &_data[offset];
+		dst[0] = (u8)type.val();
+		memcpy(dst + sizeof(u8), &keySize, sizeof(u16));
+		memcpy(dst + FieldHeaderSize, key, keySize);
+		return dst + FieldHeaderSize + keySize;
+	}
+
+}
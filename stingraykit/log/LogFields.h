@@ -0,0 +1,233 @@
+#ifndef STINGRAYKIT_LOG_LOGFIELDS_H
+#define STINGRAYKIT_LOG_LOGFIELDS_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <stingraykit/collection/iterator_base.h>
+#include <stingraykit/string/ToString.h>
+
+#include <vector>
+
+#include <string.h>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief Typed key-value fields of a log message, they are passed to the sinks as they are, so machine-readable sinks don't have to parse the text
+	 * @par Booleans, integers, floating-point numbers and strings keep their types, values of any other type are formatted with ToString when they are added.
+	 * The fields are kept in a single buffer, so clearing and refilling the same object doesn't allocate.
+	 * @par Example: s_logger.Info() << "Request done" << MakeLogField("status", status) << MakeLogField("path", path);
+	 */
+	class LogFields
+	{
+	public:
+		struct FieldType
+		{
+			STINGRAYKIT_ENUM_VALUES(Bool, Int, UInt, Double, String);
+			STINGRAYKIT_DECLARE_ENUM_CLASS(FieldType);
+		};
+
+		/// @brief View of a field, which points into the LogFields storage
+		class Field
+		{
+			friend class LogFields;
+
+		private:
+			FieldType::Enum		_type;
+			const char*			_key;
+			size_t				_keySize;
+			const u8*			_value;
+			size_t				_valueSize;
+
+		public:
+			Field() : _type(FieldType::Bool), _key(NULL), _keySize(0), _value(NULL), _valueSize(0) { }
+
+			FieldType GetType() const			{ return _type; }
+
+			const char* GetKeyData() const		{ return _key; }
+			size_t GetKeySize() const			{ return _keySize; }
+			std::string GetKey() const			{ return std::string(_key, _keySize); }
+
+			bool GetBool() const				{ return ReadValue<u8>(FieldType::Bool) != 0; }
+			s64 GetInt() const					{ return ReadValue<s64>(FieldType::Int); }
+			u64 GetUInt() const					{ return ReadValue<u64>(FieldType::UInt); }
+			double GetDouble() const			{ return ReadValue<double>(FieldType::Double); }
+
+			const char* GetStringData() const;
+			size_t GetStringSize() const;
+			std::string GetString() const		{ return std::string(GetStringData(), GetStringSize()); }
+
+			/// @brief Formats the value as it is formatted by LoggerStream
+			void FormatValue(string_ostream& result) const;
+
+		private:
+			template < typename T >
+			T ReadValue(FieldType type) const
+			{
+				CheckType(type);
+				T result;
+				memcpy(&result, _value, sizeof(T));
+				return result;
+			}
+
+			void CheckType(FieldType type) const;
+		};
+
+		class const_iterator : public iterator_base<const_iterator, const Field, std::forward_iterator_tag>
+		{
+			friend class LogFields;
+
+		private:
+			const u8*	_pos;
+			const u8*	_end;
+			Field		_field;
+
+		public:
+			const_iterator() : _pos(NULL), _end(NULL) { }
+
+			const Field& dereference() const				{ return _field; }
+			bool equal(const const_iterator& other) const	{ return _pos == other._pos; }
+			void increment();
+
+		private:
+			const_iterator(const u8* pos, const u8* end);
+
+			void Parse();
+		};
+
+	private:
+		std::vector<u8>		_data;
+
+	public:
+		bool IsEmpty() const		{ return _data.empty(); }
+		void Clear()				{ _data.clear(); }
+
+		const_iterator begin() const;
+		const_iterator end() const;
+
+		void AddBool(const char* key, bool value);
+		void AddInt(const char* key, s64 value);
+		void AddUInt(const char* key, u64 value);
+		void AddDouble(const char* key, double value);
+		void AddString(const char* key, const char* value, size_t size);
+		void AddString(const char* key, const std::string& value)	{ AddString(key, value.data(), value.size()); }
+
+		template < typename T >
+		void Add(const char* key, const T& value);
+
+		/// @brief Formats the fields as " key=value" pairs, which text sinks append to the message
+		void Format(string_ostream& result) const;
+		std::string ToString() const;
+
+		void swap(LogFields& other)	{ _data.swap(other._data); }
+
+	private:
+		u8* AddField(FieldType type, const char* key, size_t valueSize);
+	};
+
+
+	namespace Detail
+	{
+		template < typename T >
+		struct LogFieldWriter
+		{
+			static void Write(LogFields& fields, const char* key, const T& value)
+			{ fields.AddString(key, stingray::ToString(value)); }
+		};
+
+#define DETAIL_LOG_FIELD_WRITER(Type_, Method_, ValueType_) \
+		template < > \
+		struct LogFieldWriter<Type_> \
+		{ \
+			static void Write(LogFields& fields, const char* key, Type_ value) \
+			{ fields.Method_(key, (ValueType_)value); } \
+		}
+
+		DETAIL_LOG_FIELD_WRITER(bool, AddBool, bool);
+		DETAIL_LOG_FIELD_WRITER(signed char, AddInt, s64);
+		DETAIL_LOG_FIELD_WRITER(unsigned char, AddUInt, u64);
+		DETAIL_LOG_FIELD_WRITER(short, AddInt, s64);
+		DETAIL_LOG_FIELD_WRITER(unsigned short, AddUInt, u64);
+		DETAIL_LOG_FIELD_WRITER(int, AddInt, s64);
+		DETAIL_LOG_FIELD_WRITER(unsigned int, AddUInt, u64);
+		DETAIL_LOG_FIELD_WRITER(long, AddInt, s64);
+		DETAIL_LOG_FIELD_WRITER(unsigned long, AddUInt, u64);
+		DETAIL_LOG_FIELD_WRITER(long long, AddInt, s64);
+		DETAIL_LOG_FIELD_WRITER(unsigned long long, AddUInt, u64);
+		DETAIL_LOG_FIELD_WRITER(float, AddDouble, double);
+		DETAIL_LOG_FIELD_WRITER(double, AddDouble, double);
+
+#undef DETAIL_LOG_FIELD_WRITER
+
+		template < >
+		struct LogFieldWriter<char>
+		{
+			static void Write(LogFields& fields, const char* key, char value)
+			{ fields.AddString(key, &value, 1); }
+		};
+
+		template < >
+		struct LogFieldWriter<const char*>
+		{
+			static void Write(LogFields& fields, const char* key, const char* value)
+			{ fields.AddString(key, value, strlen(value)); }
+		};
+
+		template < >
+		struct LogFieldWriter<char*> : public LogFieldWriter<const char*>
+		{ };
+
+		template < size_t N >
+		struct LogFieldWriter<char[N]> : public LogFieldWriter<const char*>
+		{ };
+
+		template < size_t N >
+		struct LogFieldWriter<const char[N]> : public LogFieldWriter<const char*>
+		{ };
+
+		template < >
+		struct LogFieldWriter<std::string>
+		{
+			static void Write(LogFields& fields, const char* key, const std::string& value)
+			{ fields.AddString(key, value); }
+		};
+
+
+		template < typename T >
+		struct LogFieldArg
+		{
+			const char*		Key;
+			const T&		Value;
+
+			LogFieldArg(const char* key, const T& value) : Key(key), Value(value) { }
+		};
+	}
+
+
+	template < typename T >
+	void LogFields::Add(const char* key, const T& value)
+	{ Detail::LogFieldWriter<T>::Write(*this, key, value); }
+
+
+	/// @brief Makes a typed field of the log statement, see LogFields
+	template < typename T >
+	Detail::LogFieldArg<T> MakeLogField(const char* key, const T& value)
+	{ return Detail::LogFieldArg<T>(key, value); }
+
+	/** @} */
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/LogRateLimit.h>
+
+#include <stingraykit/time/TimeEngine.h>
+
+#include <algorithm>
+
+namespace stingray {
+namespace Detail
+{
+
+	bool AdmitRateLimited(LogSiteState& state, u32 messagesPerSecond, u32 burst)
+	{
+		// GCRA form of the token bucket: NextAdmission is the time the bucket becomes full again, so one CAS updates the whole state
+		const s64 interval = 1000000 / std::max(messagesPerSecond, 1u);
+		const s64 tolerance = interval * (std::max(burst, 1u) - 1);
+		const s64 now = TimeEngine::GetMonotonicMicroseconds();
+
+		s64 next = BasicAtomicInt<s64>::Load(state.NextAdmission, MemoryOrderRelaxed);
+		while (true)
+		{
+			if (now < next - tolerance)
+			{
+				AtomicU32::Inc(state.Suppressed, MemoryOrderRelaxed);
+				return false;
+			}
+
+			const s64 prev = BasicAtomicInt<s64>::CompareAndExchange(state.NextAdmission, next, std::max(next, now) + interval);
+			if (prev == next)
+				return true;
+
+			next = prev;
+		}
+	}
+
+
+	bool AdmitSampled(LogSiteState& state, u32 n)
+	{
+		if ((AtomicU32::Inc(state.Counter, MemoryOrderRelaxed) - 1) % std::max(n, 1u) == 0)
+			return true;
+
+		AtomicU32::Inc(state.Suppressed, MemoryOrderRelaxed);
+		return false;
+	}
+
+
+	SuppressedLogs TakeSuppressed(LogSiteState& state)
+	{
+		// subtracting the taken count keeps the messages suppressed concurrently for the next summary
+		const u32 count = AtomicU32::Load(state.Suppressed, MemoryOrderRelaxed);
+		if (count != 0)
+			AtomicU32::Sub(state.Suppressed, count, MemoryOrderRelaxed);
+		return SuppressedLogs(count);
+	}
+
+}}
@@ -0,0 +1,54 @@
+#ifndef STINGRAYKIT_LOG_LOGRATELIMIT_H
+#define STINGRAYKIT_LOG_LOGRATELIMIT_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <stingraykit/thread/atomic/AtomicInt.h>
+
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	namespace Detail
+	{
+
+		/// @brief State of a rate limited or sampled log statement, it is a static POD, so it is zero-initialized without any guard
+		struct LogSiteState
+		{
+			BasicAtomicInt<s64>::Type	NextAdmission; // monotonic microseconds, see AdmitRateLimited
+			AtomicU32::Type				Counter;
+			AtomicU32::Type				Suppressed;
+		};
+
+
+		struct SuppressedLogs
+		{
+			u32		Count;
+
+			explicit SuppressedLogs(u32 count) : Count(count) { }
+		};
+
+
+		bool AdmitRateLimited(LogSiteState& state, u32 messagesPerSecond, u32 burst);
+		bool AdmitSampled(LogSiteState& state, u32 n);
+
+		SuppressedLogs TakeSuppressed(LogSiteState& state);
+
+	}
+
+	/** @} */
+
+}
+
+#endif
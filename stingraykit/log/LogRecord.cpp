@@ -0,0 +1,109 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/LogRecord.h>
+
+#include <stingraykit/exception.h>
+
+namespace stingray
+{
+
+	namespace
+	{
+
+		class LogRecordReader
+		{
+		private:
+			const u8*	_pos;
+			const u8*	_end;
+
+		public:
+			LogRecordReader(const u8* begin, const u8* end) : _pos(begin), _end(end)
+			{ }
+
+			bool HasData() const
+			{ return _pos != _end; }
+
+			template < typename T >
+			T Read()
+			{
+				STINGRAYKIT_CHECK((size_t)(_end - _pos) >= sizeof(T), "Malformed log record");
+				T result;
+				memcpy(&result, _pos, sizeof(T));
+				_pos += sizeof(T);
+				return result;
+			}
+
+			template < typename T >
+			void FormatValue(string_ostream& result)
+			{ ToString(result, Read<T>()); }
+
+			void FormatString(string_ostream& result)
+			{
+				const u32 size = Read<u32>();
+				STINGRAYKIT_CHECK((size_t)(_end - _pos) >= size, "Malformed log record");
+				result.write(reinterpret_cast<const char*>(_pos), size);
+				_pos += size;
+			}
+		};
+
+	}
+
+
+	void LogRecord::AppendString(const char* str, size_t size)
+	{
+		const size_t offset = _data.size();
+		_data.resize(offset + 1 + sizeof(u32) + size);
+		_data[offset] = (u8)ArgType::String;
+
+		const u32 size32 = size;
+		memcpy(&_data[offset + 1], &size32, sizeof(u32));
+		if (size)
+			memcpy(&_data[offset + 1 + sizeof(u32)], str, size);
+	}
+
+
+	void LogRecord::Format(string_ostream& result) const
+	{
+		if (_data.empty())
+			return;
+
+		LogRecordReader reader(&_data[0], &_data[0] + _data.size());
+		while (reader.HasData())
+		{
+			switch (reader.Read<u8>())
+			{
+			case ArgType::Bool:			reader.FormatValue<bool>(result); break;
+			case ArgType::Char:			reader.FormatValue<char>(result); break;
+			case ArgType::SChar:		reader.FormatValue<signed char>(result); break;
+			case ArgType::UChar:		reader.FormatValue<unsigned char>(result); break;
+			case ArgType::Short:		reader.FormatValue<short>(result); break;
+			case ArgType::UShort:		reader.FormatValue<unsigned short>(result); break;
+			case ArgType::Int:			reader.FormatValue<int>(result); break;
+			case ArgType::UInt:			reader.FormatValue<unsigned int>(result); break;
+			case ArgType::Long:			reader.FormatValue<long>(result); break;
+			case ArgType::ULong:		reader.FormatValue<unsigned long>(result); break;
+			case ArgType::LongLong:		reader.FormatValue<long long>(result); break;
+			case ArgType::ULongLong:	reader.FormatValue<unsigned long long>(result); break;
+			case ArgType::Float:		reader.FormatValue<float>(result); break;
+			case ArgType::Double:		reader.FormatValue<double>(result); break;
+			case ArgType::Pointer:		reader.FormatValue<const void*>(result); break;
+			case ArgType::String:		reader.FormatString(result); break;
+			default:					STINGRAYKIT_THROW("Malformed log record");
+			}
+		}
+	}
+
+
+	std::string LogRecord::ToString() const
+	{
+		string_ostream result;
+		Format(result);
+		return result.str();
+	}
+
+}
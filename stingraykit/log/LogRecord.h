@@ -0,0 +1,175 @@
+#ifndef STINGRAYKIT_LOG_LOGRECORD_H
+#define STINGRAYKIT_LOG_LOGRECORD_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <stingraykit/metaprogramming/If.h>
+#include <stingraykit/string/ToString.h>
+
+#include <vector>
+
+#include <string.h>
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief Binary image of the LoggerStream arguments, which is formatted to text only when the message is delivered
+	 * @par Builtin values and strings are stored as a type tag followed by their raw bytes, arguments of any other type are formatted right away
+	 */
+	class LogRecord
+	{
+	public:
+		struct ArgType
+		{
+			STINGRAYKIT_ENUM_VALUES(Bool, Char, SChar, UChar, Short, UShort, Int, UInt, Long, ULong, LongLong, ULongLong, Float, Double, Pointer, String);
+			STINGRAYKIT_DECLARE_ENUM_CLASS(ArgType);
+		};
+
+		template < typename T >
+		struct BuiltinArgType
+		{ static const bool Captured = false; };
+
+	private:
+		std::vector<u8>		_data;
+
+	public:
+		bool IsEmpty() const		{ return _data.empty(); }
+		size_t GetSize() const		{ return _data.size(); }
+
+		void Clear()				{ _data.clear(); }
+		void Reserve(size_t size)	{ _data.reserve(size); }
+
+		template < typename T >
+		void Append(const T& val);
+
+		void AppendString(const char* str, size_t size);
+
+		void Format(string_ostream& result) const;
+		std::string ToString() const;
+
+		void swap(LogRecord& other)	{ _data.swap(other._data); }
+
+	private:
+		template < typename T >
+		void AppendBuiltin(ArgType type, T val)
+		{
+			const size_t offset = _data.size();
+			_data.resize(offset + 1 + sizeof(T));
+			_data[offset] = (u8)type.val();
+			memcpy(&_data[offset + 1], &val, sizeof(T));
+		}
+
+		template < typename T, typename Kind >
+		friend struct LogRecordArgWriter;
+	};
+
+
+#define DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(Type_, ArgType_) \
+	template < > \
+	struct LogRecord::BuiltinArgType<Type_> \
+	{ \
+		static const bool Captured = true; \
+		static LogRecord::ArgType Get() { return LogRecord::ArgType::ArgType_; } \
+	}
+
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(bool, Bool);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(char, Char);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(signed char, SChar);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(unsigned char, UChar);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(short, Short);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(unsigned short, UShort);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(int, Int);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(unsigned int, UInt);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(long, Long);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(unsigned long, ULong);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(long long, LongLong);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(unsigned long long, ULongLong);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(float, Float);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(double, Double);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(const void*, Pointer);
+	DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE(void*, Pointer);
+
+#undef DETAIL_LOG_RECORD_BUILTIN_ARG_TYPE
+
+
+	namespace Detail
+	{
+		struct LogRecordArgKind
+		{
+			struct Builtin { };
+			struct CString { };
+			struct Other { };
+		};
+
+		template < typename T >
+		struct GetLogRecordArgKind
+		{
+			typedef typename If<LogRecord::BuiltinArgType<T>::Captured, LogRecordArgKind::Builtin, LogRecordArgKind::Other>::ValueT	ValueT;
+		};
+
+		template < > struct GetLogRecordArgKind<char*>			{ typedef LogRecordArgKind::CString ValueT; };
+		template < > struct GetLogRecordArgKind<const char*>	{ typedef LogRecordArgKind::CString ValueT; };
+		template < size_t N > struct GetLogRecordArgKind<char[N]>			{ typedef LogRecordArgKind::CString ValueT; };
+		template < size_t N > struct GetLogRecordArgKind<const char[N]>	{ typedef LogRecordArgKind::CString ValueT; };
+	}
+
+
+	template < typename T, typename Kind = typename Detail::GetLogRecordArgKind<T>::ValueT >
+	struct LogRecordArgWriter;
+
+	template < typename T >
+	struct LogRecordArgWriter<T, Detail::LogRecordArgKind::Builtin>
+	{
+		static void Write(LogRecord& record, const T& val)
+		{ record.AppendBuiltin(LogRecord::BuiltinArgType<T>::Get(), val); }
+	};
+
+	template < typename T >
+	struct LogRecordArgWriter<T, Detail::LogRecordArgKind::CString>
+	{
+		static void Write(LogRecord& record, const T& val)
+		{
+			const char* str = val;
+			record.AppendString(str, strlen(str));
+		}
+	};
+
+	template < >
+	struct LogRecordArgWriter<std::string, Detail::LogRecordArgKind::Other>
+	{
+		static void Write(LogRecord& record, const std::string& val)
+		{ record.AppendString(val.data(), val.size()); }
+	};
+
+	template < typename T >
+	struct LogRecordArgWriter<T, Detail::LogRecordArgKind::Other>
+	{
+		static void Write(LogRecord& record, const T& val)
+		{
+			const std::string str = stingray::ToString(val);
+			record.AppendString(str.data(), str.size());
+		}
+	};
+
+
+	template < typename T >
+	void LogRecord::Append(const T& val)
+	{ LogRecordArgWriter<T>::Write(*this, val); }
+
+	/** @} */
+
+}
+
+#endif
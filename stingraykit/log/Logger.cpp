@@ -11,16 +11,22 @@
 #include <stingraykit/diagnostics/Backtrace.h>
 #include <stingraykit/log/SystemLogger.h>
 #include <stingraykit/string/StringFormat.h>
+#include <stingraykit/thread/ConditionVariable.h>
+#include <stingraykit/thread/call_once.h>
+#include <stingraykit/thread/posix/ThreadLocal.h>
 #include <stingraykit/time/TimeEngine.h>
+#include <stingraykit/CheckedDelete.h>
 #include <stingraykit/FunctionToken.h>
 #include <stingraykit/PhoenixSingleton.h>
-#include <stingraykit/SafeSingleton.h>
+#include <stingraykit/unique_ptr.h>
 
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
 #include <map>
 #include <sstream>
+#include <vector>
 
 namespace stingray
 {
@@ -32,6 +38,209 @@ namespace stingray
 	}}
 
 
+	/// @brief Record of the reads of one thread, its counter is kept on a cache line of its own, so that the readers don't write to any shared one
+	struct LoggerReaderRecord
+	{
+		static const size_t		CacheLineSize = 64;
+
+		u8						Padding0[CacheLineSize];
+		AtomicU32::Type			Sequence; // odd while the owner reads
+		AtomicU32::Type			Owned;
+		u32						Depth; // nesting of the read sections, touched only by the owner
+		LoggerReaderRecord*		Next;
+		u8						Padding1[CacheLineSize];
+
+		LoggerReaderRecord() : Sequence(0), Owned(1), Depth(0), Next() { }
+	};
+
+
+	/// @brief Records of the current thread, they are given back on the thread exit and taken over by new threads
+	struct LoggerReaderRecordsHolder
+	{
+		static const size_t		MaxDomains = 2;
+
+		LoggerReaderRecord*		Records[MaxDomains];
+
+		LoggerReaderRecordsHolder()
+		{ std::fill(Records, Records + MaxDomains, (LoggerReaderRecord*)NULL); }
+
+		~LoggerReaderRecordsHolder()
+		{
+			for (size_t i = 0; i < MaxDomains; ++i)
+				if (Records[i])
+					AtomicU32::Store(Records[i]->Owned, 0);
+		}
+	};
+
+	STINGRAYKIT_DECLARE_THREAD_LOCAL(LoggerReaderRecordsHolder, LoggerReaderRecordsHolderHolder);
+	STINGRAYKIT_DEFINE_THREAD_LOCAL(LoggerReaderRecordsHolder, LoggerReaderRecordsHolderHolder);
+
+
+	/**
+	 * @brief Lets threads read published snapshots without a lock: a reader marks its reads in its own record,
+	 * and a writer that has replaced a snapshot waits for the reads that were in progress before deleting it
+	 * @par Each domain has its own records, so that waiting for the readers of one domain does not wait for the readers of another one
+	 */
+	class LoggerReaders
+	{
+		STINGRAYKIT_NONCOPYABLE(LoggerReaders);
+
+		typedef BasicAtomicInt<intptr_t>	AtomicPtr;
+
+	public:
+		class ReadSection
+		{
+			STINGRAYKIT_NONCOPYABLE(ReadSection);
+
+		private:
+			LoggerReaderRecord*		_record;
+
+		public:
+			explicit ReadSection(LoggerReaders& readers) : _record(readers.GetRecord())
+			{
+				// the full barrier of the increment orders it before the snapshot loads
+				if (_record->Depth++ == 0)
+					AtomicU32::Inc(_record->Sequence);
+			}
+
+			~ReadSection()
+			{
+				if (--_record->Depth == 0)
+					AtomicU32::Inc(_record->Sequence);
+			}
+		};
+
+	private:
+		const size_t		_domain;
+		AtomicPtr::Type		_records;
+
+	public:
+		explicit LoggerReaders(size_t domain) : _domain(domain), _records(0)
+		{ STINGRAYKIT_CHECK(domain < LoggerReaderRecordsHolder::MaxDomains, ArgumentException("domain", domain)); }
+
+		/// @brief Waits for the reads that were in progress when it was called
+		/// @return False without waiting if the calling thread is reading itself, so a sink that changes the logger does not wait for itself
+		bool Synchronize()
+		{
+			if (GetRecord()->Depth != 0)
+				return false;
+
+			for (const LoggerReaderRecord* record = reinterpret_cast<const LoggerReaderRecord*>(AtomicPtr::Load(_records)); record; record = record->Next)
+			{
+				const u32 sequence = AtomicU32::Load(const_cast<LoggerReaderRecord*>(record)->Sequence);
+				if (sequence % 2 == 0)
+					continue;
+
+				while (AtomicU32::Load(const_cast<LoggerReaderRecord*>(record)->Sequence) == sequence)
+					Thread::Yield();
+			}
+			return true;
+		}
+
+	private:
+		LoggerReaderRecord* GetRecord()
+		{
+			LoggerReaderRecordsHolder& holder = LoggerReaderRecordsHolderHolder::Get();
+			if (!holder.Records[_domain])
+				holder.Records[_domain] = AcquireRecord();
+			return holder.Records[_domain];
+		}
+
+		LoggerReaderRecord* AcquireRecord()
+		{
+			// the records are never freed, so the list is walked without any protection
+			for (LoggerReaderRecord* record = reinterpret_cast<LoggerReaderRecord*>(AtomicPtr::Load(_records)); record; record = record->Next)
+				if (AtomicU32::Load(record->Owned, MemoryOrderRelaxed) == 0 && AtomicU32::CompareAndExchange(record->Owned, 0, 1) == 0)
+					return record;
+
+			LoggerReaderRecord* const record = new LoggerReaderRecord();
+			for (intptr_t head = AtomicPtr::Load(_records); ; )
+			{
+				record->Next = reinterpret_cast<LoggerReaderRecord*>(head);
+				const intptr_t prev = AtomicPtr::CompareAndExchange(_records, head, reinterpret_cast<intptr_t>(record));
+				if (prev == head)
+					return record;
+				head = prev;
+			}
+		}
+	};
+
+
+	/// @brief Immutable value that is replaced as a whole, it is read within a LoggerReaders::ReadSection and deleted once no read may see it
+	template < typename T >
+	class LoggerSnapshot
+	{
+		STINGRAYKIT_NONCOPYABLE(LoggerSnapshot);
+
+		typedef BasicAtomicInt<intptr_t>	AtomicPtr;
+		typedef std::vector<T*>				Snapshots;
+
+	private:
+		LoggerReaders&			_readers;
+		mutable AtomicPtr::Type	_current;
+
+		Mutex					_retiredMutex;
+		Snapshots				_retired; // replaced by writers that were reading themselves
+
+	public:
+		LoggerSnapshot(LoggerReaders& readers, T* initial) : _readers(readers), _current(reinterpret_cast<intptr_t>(initial))
+		{ }
+
+		~LoggerSnapshot()
+		{
+			CheckedDelete(&Get());
+			std::for_each(_retired.begin(), _retired.end(), &CheckedDelete<T>);
+		}
+
+		/// @brief Must be called within a read section, or by a writer, since the writers are serialized by their owner
+		const T& Get() const
+		{ return *reinterpret_cast<const T*>(AtomicPtr::Load(_current, MemoryOrderAcquire)); }
+
+		/// @return The replaced snapshot, it is to be retired once the writer lock is released
+		T* Exchange(T* snapshot)
+		{
+			const intptr_t next = reinterpret_cast<intptr_t>(snapshot);
+			for (intptr_t current = AtomicPtr::Load(_current); ; )
+			{
+				const intptr_t prev = AtomicPtr::CompareAndExchange(_current, current, next);
+				if (prev == current)
+					return reinterpret_cast<T*>(prev);
+				current = prev;
+			}
+		}
+
+		/// @brief Deletes the snapshot on the calling thread, after the reads that may see it, or defers it if the calling thread is reading itself
+		void Retire(T* snapshot)
+		{
+			Snapshots retired;
+			{
+				MutexLock l(_retiredMutex);
+				retired.swap(_retired);
+			}
+			retired.push_back(snapshot);
+
+			if (!_readers.Synchronize())
+			{
+				MutexLock l(_retiredMutex);
+				_retired.insert(_retired.end(), retired.begin(), retired.end());
+				return;
+			}
+
+			std::for_each(retired.begin(), retired.end(), &CheckedDelete<T>);
+		}
+	};
+
+
+	struct LoggerReadDomain
+	{
+		enum Enum
+		{
+			State,
+			Registry
+		};
+	};
+
+
 	struct NamedLoggerSettings
 	{
 	private:
@@ -66,40 +275,77 @@ namespace stingray
 
 		typedef std::map<std::string, NamedLoggerSettings>			SettingsRegistry;
 		typedef std::multimap<const char*, NamedLogger*, StrLess>	ObjectsRegistry;
+		typedef std::vector<std::pair<const char*, NamedLogger*> >	ObjectsSnapshot;
 
 	private:
-		Mutex				_mutex;
-		SettingsRegistry	_settings;
-		ObjectsRegistry		_objects;
+		Mutex							_mutex;
+		SettingsRegistry				_settings;
+		ObjectsRegistry					_objects;
+
+		LoggerReaders					_readers;
+		LoggerSnapshot<ObjectsSnapshot>	_snapshot; // copy of _objects that is read without the mutex
 
 	public:
-		NamedLoggerRegistry()
+		NamedLoggerRegistry() :
+			_readers(LoggerReadDomain::Registry),
+			_snapshot(_readers, new ObjectsSnapshot())
 		{ }
 
 		ObjectsRegistry::iterator Register(const char* loggerName, NamedLogger* logger)
 		{
-			MutexLock l(_mutex);
-			SettingsRegistry::iterator it = _settings.find(loggerName);
-			if (it != _settings.end())
+			ObjectsRegistry::iterator result;
+			ObjectsSnapshot* replaced = NULL;
 			{
-				logger->SetLogLevel(it->second.GetLogLevel());
-				logger->EnableBacktrace(it->second.BacktraceEnabled());
-				logger->EnableHighlight(it->second.HighlightEnabled());
+				MutexLock l(_mutex);
+				SettingsRegistry::iterator it = _settings.find(loggerName);
+				if (it != _settings.end())
+				{
+					logger->SetLogLevel(it->second.GetLogLevel());
+					logger->EnableBacktrace(it->second.BacktraceEnabled());
+					logger->EnableHighlight(it->second.HighlightEnabled());
+				}
+
+				unique_ptr<ObjectsSnapshot> snapshot(new ObjectsSnapshot(_snapshot.Get()));
+				snapshot->push_back(std::make_pair(loggerName, logger));
+				result = _objects.insert(std::make_pair(loggerName, logger));
+				replaced = _snapshot.Exchange(snapshot.release());
 			}
-			return _objects.insert(std::make_pair(loggerName, logger));
+			_snapshot.Retire(replaced);
+			return result;
 		}
 
+		/// @brief Returns once no reader sees the logger, so that it can be destroyed
 		void Unregister(ObjectsRegistry::iterator it)
 		{
-			MutexLock l(_mutex);
-			_objects.erase(it);
+			ObjectsSnapshot* replaced = NULL;
+			{
+				MutexLock l(_mutex);
+				unique_ptr<ObjectsSnapshot> snapshot(new ObjectsSnapshot());
+				snapshot->reserve(_objects.size() - 1);
+				for (ObjectsRegistry::const_iterator object = _objects.begin(); object != _objects.end(); ++object)
+					if (object != it)
+						snapshot->push_back(*object);
+				_objects.erase(it);
+				replaced = _snapshot.Exchange(snapshot.release());
+			}
+			// the registry readers don't log, so the calling thread can't be reading the replaced snapshot
+			_snapshot.Retire(replaced);
 		}
 
-		void GetLoggerNames(std::set<std::string>& out) const
+		void UpdateEffectiveLogLevels()
+		{
+			const LoggerReaders::ReadSection section(_readers);
+			const ObjectsSnapshot& objects = _snapshot.Get();
+			for (ObjectsSnapshot::const_iterator it = objects.begin(); it != objects.end(); ++it)
+				it->second->UpdateEffectiveLogLevel();
+		}
+
+		void GetLoggerNames(std::set<std::string>& out)
 		{
-			MutexLock l(_mutex);
 			out.clear();
-			std::copy(keys_iterator(_objects.begin()), keys_iterator(_objects.end()), std::inserter(out, out.begin()));
+			const LoggerReaders::ReadSection section(_readers);
+			const ObjectsSnapshot& objects = _snapshot.Get();
+			std::copy(keys_iterator(objects.begin()), keys_iterator(objects.end()), std::inserter(out, out.begin()));
 		}
 
 		void SetLogLevel(const std::string& loggerName, optional<LogLevel> logLevel)
@@ -147,40 +393,395 @@ namespace stingray
 				_settings.erase(it);
 		}
 	};
-	STINGRAYKIT_DECLARE_PTR(NamedLoggerRegistry);
+
+
+	class AsyncLogDelivery
+	{
+		STINGRAYKIT_NONCOPYABLE(AsyncLogDelivery);
+
+	public:
+		typedef std::vector<const LoggerMessage*>		MessagesBatch;
+		typedef function<void (const MessagesBatch&)>	DeliverFunc;
+
+	private:
+		typedef BasicAtomicInt<size_t>					AtomicSize;
+
+		struct Cell
+		{
+			AtomicSize::Type			Sequence;
+			optional<LoggerMessage>		Message;
+
+			Cell() : Sequence(0) { }
+		};
+
+		typedef std::vector<Cell>						Cells;
+
+		static const size_t								BatchSize = 64;
+		static const size_t								DeliveryPeriodMs = 10;
+
+	private:
+		const LogOverflowPolicy		_overflowPolicy;
+		const DeliverFunc			_deliver;
+
+		Cells						_cells;
+		const size_t				_mask;
+		const size_t				_wakeThreshold;
+		AtomicSize::Type			_enqueuePos;
+		AtomicSize::Type			_dequeuePos;
+		AtomicSize::Type			_dropped;
+
+		Mutex						_drainMutex;
+		ConditionVariable			_drainCond;
+		optional<ThreadId>			_drainerId;
+		MessagesBatch				_batch;
+
+		Mutex						_wakeMutex;
+		ConditionVariable			_wakeCond;
+		ConditionVariable			_spaceCond;
+		AtomicU32::Type				_consumerSleeping;
+		AtomicU32::Type				_blockedProducers;
+		optional<ThreadId>			_threadId;
+
+		ThreadPtr					_thread;
+
+	public:
+		AsyncLogDelivery(size_t queueSize, LogOverflowPolicy overflowPolicy, const DeliverFunc& deliver) :
+			_overflowPolicy(overflowPolicy),
+			_deliver(deliver),
+			_cells(GetCapacity(queueSize)),
+			_mask(_cells.size() - 1),
+			_wakeThreshold(std::min(_cells.size() / 8, (size_t)BatchSize)),
+			_enqueuePos(0),
+			_dequeuePos(0),
+			_dropped(0),
+			_consumerSleeping(0),
+			_blockedProducers(0)
+		{
+			for (size_t i = 0; i < _cells.size(); ++i)
+				_cells[i].Sequence = i;
+			_batch.reserve(BatchSize + 1);
+			_thread = make_shared<Thread>("asyncLogger", bind(&AsyncLogDelivery::ThreadFunc, this, _1));
+
+			// the thread logs on start, it must be done before the delivery is published, otherwise it could wait for its own queue
+			MutexLock l(_wakeMutex);
+			while (!_threadId)
+				_wakeCond.Wait(_wakeMutex);
+		}
+
+		~AsyncLogDelivery()
+		{
+			_thread.reset();
+			Flush();
+		}
+
+		void Push(const LoggerMessage& message)
+		{
+			if (const optional<size_t> pos = TryPush(message))
+			{
+				// waking the delivery thread per message would cost the caller a syscall, so it is woken up only when the queue fills up,
+				// otherwise it picks messages up within DeliveryPeriodMs
+				if (*pos - AtomicSize::Load(_dequeuePos, MemoryOrderRelaxed) >= _wakeThreshold && AtomicU32::Load(_consumerSleeping, MemoryOrderRelaxed))
+				{
+					MutexLock l(_wakeMutex);
+					_wakeCond.Broadcast();
+				}
+				return;
+			}
+
+			switch (_overflowPolicy)
+			{
+			case LogOverflowPolicy::Block:		PushBlocking(message); break;
+			case LogOverflowPolicy::Drop:		break;
+			case LogOverflowPolicy::CountDrops:	AtomicSize::Inc(_dropped); break;
+			}
+		}
+
+		void Flush()
+		{
+			while (Drain())
+				;
+		}
+
+	private:
+		static size_t GetCapacity(size_t queueSize)
+		{
+			size_t result = 2;
+			while (result < queueSize)
+				result <<= 1;
+			return result;
+		}
+
+		optional<size_t> TryPush(const LoggerMessage& message)
+		{
+			size_t pos = AtomicSize::Load(_enqueuePos, MemoryOrderRelaxed);
+			for (;;)
+			{
+				Cell& cell = _cells[pos & _mask];
+				const ptrdiff_t diff = (ptrdiff_t)AtomicSize::Load(cell.Sequence, MemoryOrderAcquire) - (ptrdiff_t)pos;
+
+				if (diff < 0)
+					return null;
+
+				if (diff > 0)
+				{
+					pos = AtomicSize::Load(_enqueuePos, MemoryOrderRelaxed);
+					continue;
+				}
+
+				const size_t prev = AtomicSize::CompareAndExchange(_enqueuePos, pos, pos + 1);
+				if (prev != pos)
+				{
+					pos = prev;
+					continue;
+				}
+
+				// the cell is reserved now, so it must be published even if copying fails, otherwise the consumer would stop on it
+				try
+				{ cell.Message = message; }
+				catch (const std::exception&)
+				{ cell.Message.reset(); }
+
+				AtomicSize::Store(cell.Sequence, pos + 1);
+				return pos;
+			}
+		}
+
+		void PushBlocking(const LoggerMessage& message)
+		{
+			if (IsDrainingThread())
+			{
+				// the cells can't be released until the batch this thread delivers is done
+				AtomicSize::Inc(_dropped);
+				return;
+			}
+
+			MutexLock l(_wakeMutex);
+			if (_threadId && *_threadId == Thread::GetCurrentThreadId())
+			{
+				// delivery thread can't wait for itself
+				AtomicSize::Inc(_dropped);
+				return;
+			}
+
+			AtomicU32::Inc(_blockedProducers);
+			while (!TryPush(message))
+			{
+				_wakeCond.Broadcast();
+				_spaceCond.TimedWait(_wakeMutex, TimeDuration::FromMilliseconds(10));
+			}
+			AtomicU32::Dec(_blockedProducers);
+			_wakeCond.Broadcast();
+		}
+
+		bool IsEmpty()
+		{
+			const size_t pos = AtomicSize::Load(_dequeuePos, MemoryOrderRelaxed);
+			return AtomicSize::Load(_cells[pos & _mask].Sequence, MemoryOrderAcquire) != pos + 1;
+		}
+
+		bool DoDrain()
+		{
+			const size_t first = AtomicSize::Load(_dequeuePos, MemoryOrderRelaxed);
+			size_t pos = first;
+			for (; pos - first < BatchSize; ++pos)
+			{
+				Cell& cell = _cells[pos & _mask];
+				if (AtomicSize::Load(cell.Sequence, MemoryOrderAcquire) != pos + 1)
+					break;
+				if (cell.Message)
+				{
+					STINGRAYKIT_TRY_NO_MESSAGE(cell.Message->FormatRecord());
+					_batch.push_back(cell.Message.get_ptr());
+				}
+			}
+
+			optional<LoggerMessage> droppedReport;
+			if (const size_t dropped = AtomicSize::Load(_dropped, MemoryOrderRelaxed))
+			{
+				AtomicSize::Sub(_dropped, dropped);
+				droppedReport = LoggerMessage(LogLevel::Warning, StringBuilder() % dropped % " log message(s) were dropped due to the asynchronous delivery queue overflow", false);
+				_batch.push_back(droppedReport.get_ptr());
+			}
+
+			if (!_batch.empty())
+				STINGRAYKIT_TRY_NO_MESSAGE(_deliver(_batch));
+			_batch.clear();
+
+			// cells are released only after delivery, so that messages are not copied out of the ring
+			for (size_t i = first; i != pos; ++i)
+			{
+				Cell& cell = _cells[i & _mask];
+				cell.Message.reset();
+				AtomicSize::Store(cell.Sequence, i + _mask + 1, MemoryOrderRelease);
+			}
+			AtomicSize::Store(_dequeuePos, pos, MemoryOrderRelaxed);
+
+			if (pos != first && AtomicU32::Load(_blockedProducers, MemoryOrderRelaxed))
+				_spaceCond.Broadcast();
+
+			return pos != first || droppedReport;
+		}
+
+		/// @brief Takes the drain over and delivers a batch, the sinks are called without any lock held
+		/// @return False if there is nothing to deliver or if this thread is already delivering a batch, so that a sink which logs or flushes does not drain the cells of its own batch
+		bool Drain()
+		{
+			const ThreadId currentThreadId = Thread::GetCurrentThreadId();
+			{
+				MutexLock l(_drainMutex);
+				if (_drainerId && *_drainerId == currentThreadId)
+					return false;
+
+				while (_drainerId)
+					_drainCond.Wait(_drainMutex);
+				_drainerId = currentThreadId;
+			}
+
+			const DrainOwnership ownership(*this);
+			return DoDrain();
+		}
+
+		bool IsDrainingThread()
+		{
+			MutexLock l(_drainMutex);
+			return _drainerId && *_drainerId == Thread::GetCurrentThreadId();
+		}
+
+		struct DrainOwnership
+		{
+			AsyncLogDelivery&	Delivery;
+
+			explicit DrainOwnership(AsyncLogDelivery& delivery) : Delivery(delivery) { }
+
+			~DrainOwnership()
+			{
+				MutexLock l(Delivery._drainMutex);
+				Delivery._drainerId.reset();
+				Delivery._drainCond.Broadcast();
+			}
+		};
+
+		void ThreadFunc(const ICancellationToken& token)
+		{
+			{
+				MutexLock l(_wakeMutex);
+				_threadId = Thread::GetCurrentThreadId();
+				_wakeCond.Broadcast();
+			}
+
+			while (token)
+			{
+				if (Drain())
+					continue;
+
+				MutexLock l(_wakeMutex);
+				AtomicU32::Store(_consumerSleeping, 1);
+				if (IsEmpty())
+					_wakeCond.TimedWait(_wakeMutex, TimeDuration::FromMilliseconds(DeliveryPeriodMs), token);
+				AtomicU32::Store(_consumerSleeping, 0);
+			}
+		}
+	};
+	STINGRAYKIT_DECLARE_PTR(AsyncLogDelivery);
+
+
+	/// @brief Message reused by the synchronous logging path, so that it does not allocate in the steady state
+	struct LoggerMessageBuffer
+	{
+		optional<LoggerMessage>		Message;
+		bool						InUse;
+
+		LoggerMessageBuffer() : InUse(false) { }
+	};
+
+	STINGRAYKIT_DECLARE_THREAD_LOCAL(LoggerMessageBuffer, LoggerMessageBufferHolder);
+	STINGRAYKIT_DEFINE_THREAD_LOCAL(LoggerMessageBuffer, LoggerMessageBufferHolder);
+
+
+	struct LoggerMessageBufferReleaser
+	{
+		LoggerMessageBuffer&	Buffer;
+
+		explicit LoggerMessageBufferReleaser(LoggerMessageBuffer& buffer) : Buffer(buffer)
+		{ Buffer.InUse = true; }
+
+		~LoggerMessageBufferReleaser()
+		{ Buffer.InUse = false; }
+	};
+
+
+	struct DeferredFormattingHolder
+	{
+		static u32 s_enabled;
+	};
+
+
+	u32 DeferredFormattingHolder::s_enabled = 0;
 
 
 	class LoggerImpl
 	{
 		typedef std::vector<ILoggerSinkPtr>							SinksBundle;
 
+		struct State
+		{
+			SinksBundle				Sinks;
+			AsyncLogDeliveryPtr		AsyncDelivery;
+		};
+
 	private:
-		SinksBundle				_sinks;
-		Mutex					_logMutex;
+		Mutex					_logMutex; // serializes the state writers, the state itself is read without it
+		LoggerReaders			_readers;
+		LoggerSnapshot<State>	_state;
 		NamedLoggerRegistry		_registry;
 
 	public:
-		LoggerImpl()
+		LoggerImpl() :
+			_readers(LoggerReadDomain::State),
+			_state(_readers, new State())
 		{ }
 
 
-		~LoggerImpl()
-		{ }
+		void Shutdown()
+		{
+			DisableAsyncMode();
+
+			State* replaced = NULL;
+			{
+				MutexLock l(_logMutex);
+				replaced = _state.Exchange(new State());
+			}
+			_state.Retire(replaced);
+		}
 
 
 		void AddSink(const ILoggerSinkPtr& sink)
 		{
-			MutexLock l(_logMutex);
-			_sinks.push_back(sink);
+			State* replaced = NULL;
+			{
+				MutexLock l(_logMutex);
+				unique_ptr<State> state(new State(_state.Get()));
+				state->Sinks.push_back(sink);
+				replaced = _state.Exchange(state.release());
+			}
+			_state.Retire(replaced);
 		}
 
 
 		void RemoveSink(const ILoggerSinkPtr& sink)
 		{
-			MutexLock l(_logMutex);
-			SinksBundle::iterator it = std::find(_sinks.begin(), _sinks.end(), sink);
-			if (it != _sinks.end())
-				_sinks.erase(it);
+			State* replaced = NULL;
+			{
+				MutexLock l(_logMutex);
+				unique_ptr<State> state(new State(_state.Get()));
+				SinksBundle::iterator it = std::find(state->Sinks.begin(), state->Sinks.end(), sink);
+				if (it == state->Sinks.end())
+					return;
+
+				state->Sinks.erase(it);
+				replaced = _state.Exchange(state.release());
+			}
+			_state.Retire(replaced);
 		}
 
 
@@ -190,45 +791,151 @@ namespace stingray
 			{
 				EnableInterruptionPoints eip(false);
 
-				SinksBundle sinks;
-				{
-					MutexLock l(_logMutex);
-					sinks = _sinks;
-				}
+				const LoggerReaders::ReadSection section(_readers);
+				const State& state = _state.Get();
 
-				if (sinks.empty())
+				if (state.AsyncDelivery)
+					state.AsyncDelivery->Push(message);
+				else if (state.Sinks.empty())
 					SystemLogger::Log(message);
 				else
-					PutMessageToSinks(sinks, message);
+				{
+					PutMessageToSinks(state.Sinks, message);
+					FlushSinks(state.Sinks);
+				}
 			}
 			catch (const std::exception&)
 			{ }
 		}
 
 
+		void EnableAsyncMode(size_t queueSize, LogOverflowPolicy overflowPolicy, bool deferFormatting)
+		{
+			STINGRAYKIT_CHECK(queueSize != 0, ArgumentException("queueSize"));
+
+			const AsyncLogDeliveryPtr asyncDelivery = make_shared<AsyncLogDelivery>(queueSize, overflowPolicy, bind(&LoggerImpl::DeliverMessages, this, _1));
+
+			State* replaced = NULL;
+			{
+				MutexLock l(_logMutex);
+				STINGRAYKIT_CHECK(!_state.Get().AsyncDelivery, InvalidOperationException("Asynchronous mode is already enabled"));
+
+				unique_ptr<State> state(new State(_state.Get()));
+				state->AsyncDelivery = asyncDelivery;
+				replaced = _state.Exchange(state.release());
+				AtomicU32::Store(DeferredFormattingHolder::s_enabled, deferFormatting ? 1 : 0, MemoryOrderRelaxed);
+			}
+			_state.Retire(replaced);
+		}
+
+
+		/// @brief The delivery is flushed, joined and destroyed on the calling thread once no producer can see it,
+		/// unless it is called by a sink, then it is done by the next state change
+		void DisableAsyncMode()
+		{
+			State* replaced = NULL;
+			{
+				MutexLock l(_logMutex);
+				AtomicU32::Store(DeferredFormattingHolder::s_enabled, 0, MemoryOrderRelaxed);
+				if (!_state.Get().AsyncDelivery)
+					return;
+
+				unique_ptr<State> state(new State(_state.Get()));
+				state->AsyncDelivery.reset();
+				replaced = _state.Exchange(state.release());
+			}
+			_state.Retire(replaced);
+		}
+
+
+		void Flush()
+		{
+			const LoggerReaders::ReadSection section(_readers);
+			const State& state = _state.Get();
+
+			if (state.AsyncDelivery)
+				state.AsyncDelivery->Flush();
+		}
+
+
 		NamedLoggerRegistry& GetRegistry()
 		{ return _registry; }
 
 
 	private:
+		void DeliverMessages(const AsyncLogDelivery::MessagesBatch& messages)
+		{
+			EnableInterruptionPoints eip(false);
+
+			const LoggerReaders::ReadSection section(_readers);
+			const SinksBundle& sinks = _state.Get().Sinks;
+
+			for (AsyncLogDelivery::MessagesBatch::const_iterator it = messages.begin(); it != messages.end(); ++it)
+			{
+				if (sinks.empty())
+					SystemLogger::Log(**it);
+				else
+					PutMessageToSinks(sinks, **it);
+			}
+
+			FlushSinks(sinks);
+		}
+
 		static void PutMessageToSinks(const SinksBundle& sinks, const LoggerMessage& message)
 		{
 			for (SinksBundle::const_iterator it = sinks.begin(); it != sinks.end(); ++it)
 			{
 				try
-				{
-					ILoggerSinkPtr sink = *it;
-					sink->Log(message);
-				}
+				{ (*it)->Log(message); }
+				catch (const std::exception&)
+				{ }
+			}
+		}
+
+		static void FlushSinks(const SinksBundle& sinks)
+		{
+			for (SinksBundle::const_iterator it = sinks.begin(); it != sinks.end(); ++it)
+			{
+				try
+				{ (*it)->Flush(); }
 				catch (const std::exception&)
 				{ }
 			}
 		}
 	};
-	STINGRAYKIT_DECLARE_PTR(LoggerImpl);
 
 
-	typedef SafeSingleton<LoggerImpl> LoggerSingleton;
+	namespace
+	{
+
+		// the logger is intentionally leaked, so that the messages do not have to keep it alive, the sinks are released at exit instead
+		LoggerImpl*		s_loggerImpl = NULL;
+		STINGRAYKIT_DEFINE_ONCE_FLAG(s_loggerImplOnceFlag);
+
+		struct LoggerImplShutdown
+		{
+			~LoggerImplShutdown()
+			{ s_loggerImpl->Shutdown(); }
+		};
+
+		void CreateLoggerImpl()
+		{
+			try
+			{
+				s_loggerImpl = new LoggerImpl();
+				static LoggerImplShutdown shutdown;
+			}
+			catch (const std::exception& ex)
+			{ SystemLogger::Log(LoggerMessage(LogLevel::Error, "An exception in LoggerImpl constructor: " + diagnostic_information(ex), false)); }
+		}
+
+		LoggerImpl* GetLoggerImpl()
+		{
+			call_once(s_loggerImplOnceFlag, &CreateLoggerImpl);
+			return s_loggerImpl;
+		}
+
+	}
 
 
 	/////////////////////////////////////////////////////////////////
@@ -236,14 +943,18 @@ namespace stingray
 
 	NamedLogger::NamedLogger(const char* name) :
 		_params(name),
-		_logLevel(OptionalLogLevel::Null)
+		_logLevel(OptionalLogLevel::Null),
+		_effectiveLogLevel(Logger::GetLogLevel())
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (logger)
 		{
-			NamedLoggerRegistryPtr r(logger, &(logger->GetRegistry()));
+			NamedLoggerRegistry* r = &logger->GetRegistry();
 			_token = MakeToken<FunctionToken>(bind(&NamedLoggerRegistry::Unregister, r, r->Register(_params.GetName(), this)));
 		}
+
+		// global log level might have been changed before the registration
+		UpdateEffectiveLogLevel();
 	}
 
 
@@ -265,7 +976,12 @@ namespace stingray
 
 	void Logger::SetLogLevel(LogLevel logLevel)
 	{
-		AtomicU32::Store(LogLevelHolder::s_logLevel, (u32)logLevel.val(), MemoryOrderRelaxed);
+		AtomicU32::Store(LogLevelHolder::s_logLevel, (u32)logLevel.val());
+
+		LoggerImpl* logger = GetLoggerImpl();
+		if (logger)
+			logger->GetRegistry().UpdateEffectiveLogLevels();
+
 		Stream(logLevel) << "Log level is " << logLevel;
 	}
 
@@ -275,12 +991,12 @@ namespace stingray
 
 
 	LoggerStream Logger::Stream(LogLevel logLevel, DuplicatingLogsFilter* duplicatingLogsFilter)
-	{ return LoggerStream(null, GetLogLevel(), logLevel, duplicatingLogsFilter, &Logger::DoLog); }
+	{ return LoggerStream(null, GetLogLevel(), logLevel, duplicatingLogsFilter, &Logger::DoLog, GetLogRecordFunction()); }
 
 
 	void Logger::SetLogLevel(const std::string& loggerName, optional<LogLevel> logLevel)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (logger)
 			logger->GetRegistry().SetLogLevel(loggerName, logLevel);
 	}
@@ -288,7 +1004,7 @@ namespace stingray
 
 	void Logger::EnableBacktrace(const std::string& loggerName, bool enable)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (logger)
 			logger->GetRegistry().EnableBacktrace(loggerName, enable);
 	}
@@ -296,7 +1012,7 @@ namespace stingray
 
 	void Logger::EnableHighlight(const std::string& loggerName, bool enable)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (logger)
 			logger->GetRegistry().EnableHighlight(loggerName, enable);
 	}
@@ -304,7 +1020,7 @@ namespace stingray
 
 	void Logger::GetLoggerNames(std::set<std::string>& out)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (logger)
 			logger->GetRegistry().GetLoggerNames(out);
 	}
@@ -312,7 +1028,7 @@ namespace stingray
 
 	Token Logger::AddSink(const ILoggerSinkPtr& sink)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		if (!logger)
 			return null;
 
@@ -321,19 +1037,45 @@ namespace stingray
 	}
 
 
-	void Logger::DoLog(const NamedLoggerParams* loggerParams, LogLevel logLevel, const std::string& text)
+	Token Logger::EnableAsyncMode(size_t queueSize, LogOverflowPolicy overflowPolicy, bool deferFormatting)
+	{
+		LoggerImpl* logger = GetLoggerImpl();
+		if (!logger)
+			return null;
+
+		logger->EnableAsyncMode(queueSize, overflowPolicy, deferFormatting);
+		return MakeToken<FunctionToken>(bind(&LoggerImpl::DisableAsyncMode, logger));
+	}
+
+
+	void Logger::Flush()
+	{
+		LoggerImpl* logger = GetLoggerImpl();
+		if (logger)
+			logger->Flush();
+	}
+
+
+	LoggerStream::LogRecordFunction* Logger::GetLogRecordFunction()
+	{ return AtomicU32::Load(DeferredFormattingHolder::s_enabled, MemoryOrderRelaxed) ? &Logger::DoLogRecord : NULL; }
+
+
+	void Logger::DoLog(const NamedLoggerParams* loggerParams, LogLevel logLevel, const std::string& text, const LogFields* fields)
 	{
-		LoggerImplPtr logger = LoggerSingleton::Instance();
+		LoggerImpl* logger = GetLoggerImpl();
 		LogLevel ll = logger ? GetLogLevel() : LogLevel(LogLevel::Debug);
 		if (!loggerParams && logLevel < ll) // NamedLogger LoggerStream checks the log level in its destructor
 			return;
 
 		optional<LoggerMessage> msg;
 		if (loggerParams)
-			msg = LoggerMessage(loggerParams->GetName(), logLevel, text + (loggerParams->BacktraceEnabled() ? ": " + Backtrace().Get() : std::string()), loggerParams->HighlightEnabled());
+			msg = LoggerMessage(loggerParams->GetInternedName(), logLevel, text + (loggerParams->BacktraceEnabled() ? ": " + Backtrace().Get() : std::string()), loggerParams->HighlightEnabled());
 		else
 			msg = LoggerMessage(logLevel, text, false);
 
+		if (fields)
+			msg->SetFields(*fields);
+
 		if (logger)
 			logger->Log(*msg);
 		else
@@ -341,20 +1083,100 @@ namespace stingray
 	}
 
 
-	LogLevel NamedLogger::GetLogLevel() const
+	void Logger::DoLog(const NamedLoggerParams* loggerParams, LogLevel logLevel, const string_ostream& text, const LogFields* fields)
 	{
-		optional<LogLevel> logLevel = OptionalLogLevel::ToLogLevel(_logLevel.load(MemoryOrderRelaxed));
-		return logLevel ? *logLevel : Logger::GetLogLevel();
+		if (loggerParams && loggerParams->BacktraceEnabled())
+		{
+			DoLog(loggerParams, logLevel, text.str(), fields);
+			return;
+		}
+
+		LoggerImpl* logger = GetLoggerImpl();
+		LogLevel ll = logger ? GetLogLevel() : LogLevel(LogLevel::Debug);
+		if (!loggerParams && logLevel < ll)
+			return;
+
+		LoggerMessageBuffer& buffer = LoggerMessageBufferHolder::Get();
+		if (buffer.InUse) // sink is logging something
+		{
+			DoLog(loggerParams, logLevel, text.str(), fields);
+			return;
+		}
+
+		const LoggerMessageBufferReleaser releaser(buffer);
+		if (buffer.Message && loggerParams)
+			buffer.Message->Reset(loggerParams->GetInternedName(), logLevel, text, loggerParams->HighlightEnabled());
+		else if (buffer.Message)
+			buffer.Message->Reset(logLevel, text, false);
+		else if (loggerParams)
+			buffer.Message = LoggerMessage(loggerParams->GetInternedName(), logLevel, text.str(), loggerParams->HighlightEnabled());
+		else
+			buffer.Message = LoggerMessage(logLevel, text.str(), false);
+
+		if (fields)
+			buffer.Message->SetFields(*fields);
+
+		if (logger)
+			logger->Log(*buffer.Message);
+		else
+			SystemLogger::Log(*buffer.Message);
+	}
+
+
+	void Logger::DoLogRecord(const NamedLoggerParams* loggerParams, LogLevel logLevel, const LogRecord& record, const LogFields* fields)
+	{
+		if (loggerParams && loggerParams->BacktraceEnabled())
+		{
+			DoLog(loggerParams, logLevel, record.ToString(), fields);
+			return;
+		}
+
+		LoggerImpl* logger = GetLoggerImpl();
+		LogLevel ll = logger ? GetLogLevel() : LogLevel(LogLevel::Debug);
+		if (!loggerParams && logLevel < ll)
+			return;
+
+		optional<LoggerMessage> msg;
+		if (loggerParams)
+			msg = LoggerMessage(loggerParams->GetInternedName(), logLevel, record, loggerParams->HighlightEnabled());
+		else
+			msg = LoggerMessage(logLevel, record, false);
+
+		if (fields)
+			msg->SetFields(*fields);
+
+		if (logger)
+			logger->Log(*msg);
+		else
+			SystemLogger::Log(*msg);
 	}
 
 
 	void NamedLogger::SetLogLevel(optional<LogLevel> logLevel)
 	{
-		_logLevel.store(OptionalLogLevel::FromLogLevel(logLevel), MemoryOrderRelaxed);
+		_logLevel.store(OptionalLogLevel::FromLogLevel(logLevel));
+		UpdateEffectiveLogLevel();
 		Stream(GetLogLevel()) << "Log level is " << logLevel;
 	}
 
 
+	void NamedLogger::UpdateEffectiveLogLevel()
+	{
+		// both own and global log levels may be changed concurrently, so the result is stored only if they stay the same
+		for (;;)
+		{
+			const OptionalLogLevel logLevel = _logLevel.load();
+			const LogLevel globalLogLevel = (LogLevel::Enum)AtomicU32::Load(LogLevelHolder::s_logLevel);
+
+			const optional<LogLevel> ownLogLevel = OptionalLogLevel::ToLogLevel(logLevel);
+			_effectiveLogLevel.store(ownLogLevel ? *ownLogLevel : globalLogLevel);
+
+			if (_logLevel.load() == logLevel && (LogLevel::Enum)AtomicU32::Load(LogLevelHolder::s_logLevel) == globalLogLevel)
+				return;
+		}
+	}
+
+
 	bool NamedLogger::BacktraceEnabled() const
 	{ return _params.BacktraceEnabled(); }
 
@@ -375,7 +1197,7 @@ namespace stingray
 
 
 	LoggerStream NamedLogger::Stream(LogLevel logLevel) const
-	{ return LoggerStream(&_params, GetLogLevel(), logLevel, &_duplicatingLogsFilter, &Logger::DoLog); }
+	{ return LoggerStream(&_params, GetLogLevel(), logLevel, &_duplicatingLogsFilter, &Logger::DoLog, Logger::GetLogRecordFunction()); }
 
 
 	void NamedLogger::Log(LogLevel logLevel, const std::string& message)
@@ -71,6 +71,55 @@ namespace stingray
 		} while (0)
 
 
+	/**
+	 * @brief Logs to the given NamedLogger, the statement arguments are evaluated only if the log level is enabled
+	 * @par Example: STINGRAYKIT_LOG(s_logger, Debug) << "Value: " << ComputeValue();
+	 */
+#define STINGRAYKIT_LOG(Logger_, LogLevel_) \
+		if (!(Logger_).IsEnabled(::stingray::LogLevel::LogLevel_)) \
+			; \
+		else \
+			(Logger_).Stream(::stingray::LogLevel::LogLevel_)
+
+
+	/**
+	 * @brief Logs like STINGRAYKIT_LOG, but lets at most Burst_ messages at once and MessagesPerSecond_ messages on average through this statement
+	 * @par The number of messages suppressed since the previous one is prefixed to the next message passed, so a storm of them produces such a summary at the given rate.
+	 * The per-statement state is a static declared in the for-init, the checks are lock-free.
+	 * @par Example: STINGRAYKIT_LOG_RATE_LIMITED(s_logger, Error, 1, 5) << "Can't connect to " << host << ": " << ex;
+	 */
+#define STINGRAYKIT_LOG_RATE_LIMITED(Logger_, LogLevel_, MessagesPerSecond_, Burst_) \
+		DETAIL_STINGRAYKIT_LOG_SITE(Logger_, LogLevel_, ::stingray::Detail::AdmitRateLimited(detail_logSiteState, (MessagesPerSecond_), (Burst_)))
+
+	/**
+	 * @brief Logs like STINGRAYKIT_LOG, but lets only every N_-th message through this statement
+	 * @par The number of skipped messages is prefixed to the logged ones, as in STINGRAYKIT_LOG_RATE_LIMITED.
+	 */
+#define STINGRAYKIT_LOG_SAMPLED(Logger_, LogLevel_, N_) \
+		DETAIL_STINGRAYKIT_LOG_SITE(Logger_, LogLevel_, ::stingray::Detail::AdmitSampled(detail_logSiteState, (N_)))
+
+#define DETAIL_STINGRAYKIT_LOG_SITE(Logger_, LogLevel_, Admit_) \
+		for (bool detail_logSiteOnce = true; detail_logSiteOnce; detail_logSiteOnce = false) \
+			for (static ::stingray::Detail::LogSiteState detail_logSiteState; detail_logSiteOnce; detail_logSiteOnce = false) \
+				if (!(Logger_).IsEnabled(::stingray::LogLevel::LogLevel_) || !(Admit_)) \
+					; \
+				else \
+					(Logger_).Stream(::stingray::LogLevel::LogLevel_) << ::stingray::Detail::TakeSuppressed(detail_logSiteState)
+
+
+	struct LogOverflowPolicy
+	{
+		STINGRAYKIT_ENUM_VALUES
+		(
+			Block,		///< Caller waits until the delivery thread frees some space
+			Drop,		///< Message is silently discarded
+			CountDrops	///< Message is discarded, the delivery thread periodically reports the number of discarded messages
+		);
+
+		STINGRAYKIT_DECLARE_ENUM_CLASS(LogOverflowPolicy);
+	};
+
+
 	class Logger
 	{
 		friend class NamedLogger;
@@ -86,6 +135,8 @@ namespace stingray
 
 		static void SetLogLevel(LogLevel logLevel);
 		static LogLevel GetLogLevel();
+		/// @returns true if messages of the given level are delivered to the sinks or recorded by the FlightRecorder
+		static bool IsEnabled(LogLevel logLevel)	{ return logLevel >= GetLogLevel() || FlightRecorder::IsEnabled(logLevel); }
 
 		/// @name Named loggers control
 		/// @{
@@ -98,13 +149,30 @@ namespace stingray
 
 		static Token AddSink(const ILoggerSinkPtr& sink);
 
+		/// @name Asynchronous delivery
+		/// @{
+		/// @brief Makes callers put messages into a bounded queue, which is drained to the sinks by a dedicated thread
+		/// @param deferFormatting makes streams capture builtin and string arguments in binary form, so that they are formatted by the delivery thread
+		/// @returns Token that flushes the queue and switches back to synchronous delivery
+		static Token EnableAsyncMode(size_t queueSize = 4096, LogOverflowPolicy overflowPolicy = LogOverflowPolicy::CountDrops, bool deferFormatting = false);
+
+		/// @brief Delivers all the queued messages to the sinks on the calling thread
+		static void Flush();
+		/// @}
+
 	private:
-		static void DoLog(const NamedLoggerParams* namedLogger, LogLevel logLevel, const std::string& message);
+		static LoggerStream::LogRecordFunction* GetLogRecordFunction();
+
+		static void DoLog(const NamedLoggerParams* namedLogger, LogLevel logLevel, const std::string& message, const LogFields* fields);
+		static void DoLog(const NamedLoggerParams* namedLogger, LogLevel logLevel, const string_ostream& message, const LogFields* fields);
+		static void DoLogRecord(const NamedLoggerParams* namedLogger, LogLevel logLevel, const LogRecord& record, const LogFields* fields);
 	};
 
 
 	class NamedLogger
 	{
+		friend class NamedLoggerRegistry;
+
 		struct OptionalLogLevel
 		{
 			STINGRAYKIT_ENUM_VALUES(
@@ -133,6 +201,7 @@ namespace stingray
 		NamedLoggerParams				_params;
 		mutable DuplicatingLogsFilter	_duplicatingLogsFilter;
 		atomic<OptionalLogLevel>		_logLevel;
+		atomic<LogLevel>				_effectiveLogLevel; // own log level if any, global one otherwise
 		Token							_token;
 
 	public:
@@ -143,7 +212,9 @@ namespace stingray
 
 		/// @brief Gets log level for NamedLogger
 		/// @returns NamedLogger log level if it has one, or global Logger log level otherwise
-		LogLevel GetLogLevel() const;
+		LogLevel GetLogLevel() const				{ return _effectiveLogLevel.load(MemoryOrderRelaxed); }
+
+		bool IsEnabled(LogLevel logLevel) const		{ return logLevel >= GetLogLevel() || FlightRecorder::IsEnabled(logLevel); }
 
 		/// @brief Sets or removes specific log level for NamedLogger
 		/// @param logLevel log level value to set or null - to remove specific log level and use global one instead
@@ -164,6 +235,9 @@ namespace stingray
 		LoggerStream Error()	const { return Stream(LogLevel::Error); }
 
 		void Log(LogLevel logLevel, const std::string& text);
+
+	private:
+		void UpdateEffectiveLogLevel();
 	};
 
 
@@ -188,6 +262,7 @@ namespace stingray
 			{ _logger = &logger; return *this; }
 
 			LogLevel GetLogLevel() const			{ return _logger ? _logger->GetLogLevel() : Logger::GetLogLevel(); }
+			bool IsEnabled(LogLevel logLevel) const	{ return _logger ? _logger->IsEnabled(logLevel) : Logger::IsEnabled(logLevel); }
 
 			LoggerStream Stream(LogLevel logLevel)	{ return _logger ? _logger->Stream(logLevel) : Logger::Stream(logLevel); }
 
@@ -8,44 +8,134 @@
 #include <stingraykit/log/LoggerMessage.h>
 
 #include <stingraykit/compare/MemberListComparer.h>
-#include <stingraykit/string/StringFormat.h>
+#include <stingraykit/log/TimestampFormatter.h>
 #include <stingraykit/thread/Thread.h>
+#include <stingraykit/thread/posix/ThreadLocal.h>
 
 
 namespace stingray
 {
 
+	namespace
+	{
+
+		struct ThreadNameCache
+		{
+			std::string		Name;
+			InternedString	Interned;
+
+			ThreadNameCache() : Interned("__undefined__") { }
+		};
+
+		STINGRAYKIT_DECLARE_THREAD_LOCAL(ThreadNameCache, ThreadNameCacheHolder);
+		STINGRAYKIT_DEFINE_THREAD_LOCAL(ThreadNameCache, ThreadNameCacheHolder);
+
+		STINGRAYKIT_DECLARE_THREAD_LOCAL(TimestampFormatter, TimestampFormatterHolder);
+		STINGRAYKIT_DEFINE_THREAD_LOCAL(TimestampFormatter, TimestampFormatterHolder);
+
+		// the thread name is interned again only when it changes, otherwise it costs just a comparison
+		const InternedString& GetCurrentThreadName()
+		{
+			const std::string& name = Thread::GetCurrentThreadName();
+			ThreadNameCache& cache = ThreadNameCacheHolder::Get();
+			if (name != cache.Name)
+			{
+				cache.Interned = InternedString(name.empty() ? "__undefined__" : name.c_str());
+				cache.Name = name;
+			}
+			return cache.Interned;
+		}
+
+	}
+
+
 	LoggerMessage::LoggerMessage(const LogLevel& logLevel, const std::string& message, bool highlight) :
-		_logLevel(logLevel), _time(Time::Now()),
-		_threadName(Thread::GetCurrentThreadName().empty() ? "__undefined__" : Thread::GetCurrentThreadName()),
-		_message(message), _highlight(highlight)
+		_logLevel(logLevel), _time(Time::Now()), _threadName(GetCurrentThreadName()), _message(message), _highlight(highlight)
 	{ }
 
 
 	LoggerMessage::LoggerMessage(const std::string& loggerName, const LogLevel& logLevel, const std::string& message, bool highlight) :
-		_loggerName(loggerName), _logLevel(logLevel), _time(Time::Now()),
-		_threadName(Thread::GetCurrentThreadName().empty() ? "__undefined__" : Thread::GetCurrentThreadName()),
-		_message(message), _highlight(highlight)
+		_loggerName(InternedString(loggerName)), _logLevel(logLevel), _time(Time::Now()), _threadName(GetCurrentThreadName()), _message(message), _highlight(highlight)
+	{ }
+
+
+	LoggerMessage::LoggerMessage(const InternedString& loggerName, const LogLevel& logLevel, const std::string& message, bool highlight) :
+		_loggerName(loggerName), _logLevel(logLevel), _time(Time::Now()), _threadName(GetCurrentThreadName()), _message(message), _highlight(highlight)
+	{ }
+
+
+	LoggerMessage::LoggerMessage(const LogLevel& logLevel, const LogRecord& record, bool highlight) :
+		_logLevel(logLevel), _time(Time::Now()), _threadName(GetCurrentThreadName()), _record(record), _highlight(highlight)
+	{ }
+
+
+	LoggerMessage::LoggerMessage(const InternedString& loggerName, const LogLevel& logLevel, const LogRecord& record, bool highlight) :
+		_loggerName(loggerName), _logLevel(logLevel), _time(Time::Now()), _threadName(GetCurrentThreadName()), _record(record), _highlight(highlight)
 	{ }
 
 
-	std::string LoggerMessage::GetLoggerName() const
+	const InternedString& LoggerMessage::GetInternedLoggerName() const
 	{
 		STINGRAYKIT_CHECK(HasLoggerName(), LogicException());
 		return *_loggerName;
 	}
 
 
+	const std::string& LoggerMessage::GetMessage() const
+	{
+		if (!_record.IsEmpty())
+		{
+			_message = _record.ToString();
+			LogRecord().swap(_record);
+		}
+		return _message;
+	}
+
+
+	void LoggerMessage::FormatRecord()
+	{ GetMessage(); }
+
+
+	void LoggerMessage::Reset(const LogLevel& logLevel, const string_ostream& message, bool highlight)
+	{
+		_loggerName.reset();
+		_logLevel = logLevel;
+		_time = Time::Now();
+		_threadName = GetCurrentThreadName();
+		message.copy_to(_message);
+		_record.Clear();
+		_fields.Clear();
+		_highlight = highlight;
+	}
+
+
+	void LoggerMessage::Reset(const InternedString& loggerName, const LogLevel& logLevel, const string_ostream& message, bool highlight)
+	{
+		Reset(logLevel, message, highlight);
+		_loggerName = loggerName;
+	}
+
+
 	std::string LoggerMessage::ToString() const
 	{
+		string_ostream result;
+		result << "[";
+		TimestampFormatterHolder::Get().Format(result, _time);
+		result << "] [" << _logLevel.ToString() << "] {" << _threadName.str() << "} ";
 		if (_loggerName)
-			return StringFormat("[%1%] [%2%] {%3%} [%4%] %5%", _time.ToString(), _logLevel, _threadName, *_loggerName, _message);
+			result << "[" << _loggerName->str() << "] ";
+
+		if (_record.IsEmpty())
+			result << _message;
+		else
+			_record.Format(result);
 
-		return StringFormat("[%1%] [%2%] {%3%} %4%", _time.ToString(), _logLevel, _threadName, _message);
+		_fields.Format(result);
+		return result.str();
 	}
 
 
 	bool LoggerMessage::operator < (const LoggerMessage &other) const
-	{ return CompareMembersLess(&LoggerMessage::_loggerName, &LoggerMessage::_logLevel, &LoggerMessage::_time, &LoggerMessage::_threadName, &LoggerMessage::_message)(*this, other); }
+	{ return CompareMembersLess(&LoggerMessage::_loggerName, &LoggerMessage::_logLevel, &LoggerMessage::_time, &LoggerMessage::_threadName, &LoggerMessage::GetMessage)(*this, other); }
 
 }
@@ -9,7 +9,11 @@
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 
+#include <stingraykit/log/LogFields.h>
 #include <stingraykit/log/LogLevel.h>
+#include <stingraykit/log/LogRecord.h>
+#include <stingraykit/string/InternedString.h>
+#include <stingraykit/string/string_stream.h>
 #include <stingraykit/time/Time.h>
 #include <stingraykit/optional.h>
 
@@ -24,28 +28,54 @@ namespace stingray
 	 * @{
 	 */
 
+	/**
+	 * @brief Logged message, as it is passed to the sinks
+	 * @par The logger and thread names are interned, so creating and copying messages doesn't copy them.
+	 * The references returned by GetLoggerName and GetThreadName are valid as long as the message is.
+	 */
 	class LoggerMessage
 	{
 	private:
-		optional<std::string>	_loggerName;
-		LogLevel				_logLevel;
-		Time					_time;
-		std::string				_threadName;
-		std::string				_message;
-		bool					_highlight;
+		optional<InternedString>	_loggerName;
+		LogLevel					_logLevel;
+		Time						_time;
+		InternedString				_threadName;
+		mutable std::string			_message;
+		mutable LogRecord			_record;
+		LogFields					_fields;
+		bool						_highlight;
 
 	public:
 		LoggerMessage(const LogLevel& logLevel, const std::string& message, bool highlight);
 		LoggerMessage(const std::string& loggerName, const LogLevel& logLevel, const std::string& message, bool highlight);
+		LoggerMessage(const InternedString& loggerName, const LogLevel& logLevel, const std::string& message, bool highlight);
+
+		/// @brief Constructs message, which text is formatted from the record only when it is requested
+		LoggerMessage(const LogLevel& logLevel, const LogRecord& record, bool highlight);
+		LoggerMessage(const InternedString& loggerName, const LogLevel& logLevel, const LogRecord& record, bool highlight);
+
+		bool Highlight() const								{ return _highlight; }
+		bool HasLoggerName() const							{ return _loggerName; }
+		const std::string& GetLoggerName() const			{ return GetInternedLoggerName().str(); }
+		const InternedString& GetInternedLoggerName() const;
+
+		LogLevel GetLogLevel() const						{ return _logLevel; }
+		Time GetTime() const								{ return _time; }
+		const std::string& GetThreadName() const			{ return _threadName.str(); }
+		const InternedString& GetInternedThreadName() const	{ return _threadName; }
+
+		/// @brief Returns the message text, the deferred record is formatted on the first call
+		const std::string& GetMessage() const;
+
+		const LogFields& GetFields() const					{ return _fields; }
+		void SetFields(const LogFields& fields)				{ _fields = fields; }
 
-		bool Highlight() const				{ return _highlight; }
-		bool HasLoggerName() const			{ return _loggerName; }
-		std::string GetLoggerName() const;
+		/// @brief Formats the deferred record, if any, to the message text, so that the sinks get the message already formatted
+		void FormatRecord();
 
-		LogLevel GetLogLevel() const		{ return _logLevel; }
-		Time GetTime() const				{ return _time; }
-		std::string GetThreadName() const	{ return _threadName; }
-		std::string GetMessage() const		{ return _message; }
+		/// @brief Reinitializes the message in place without fields, reusing the storage of its text
+		void Reset(const LogLevel& logLevel, const string_ostream& message, bool highlight);
+		void Reset(const InternedString& loggerName, const LogLevel& logLevel, const string_ostream& message, bool highlight);
 
 		std::string ToString() const;
 
@@ -7,6 +7,8 @@
 
 #include <stingraykit/log/LoggerStream.h>
 
+#include <stingraykit/thread/posix/ThreadLocal.h>
+
 #include <cstring>
 
 namespace stingray
@@ -23,28 +25,133 @@ namespace stingray
 	}
 
 
-	LoggerStream::LoggerStream(const NamedLoggerParams* loggerParams, LogLevel loggerLogLevel, LogLevel streamLogLevel, DuplicatingLogsFilter* duplicatingLogsFilter, LogFunction* logFunction) :
-		_loggerParams(loggerParams), _loggerLogLevel(loggerLogLevel), _streamLogLevel(streamLogLevel), _duplicatingLogsFilter(duplicatingLogsFilter), _logFunction(logFunction)
-	{ }
+	namespace
+	{
+		STINGRAYKIT_DECLARE_THREAD_LOCAL(Detail::LoggerStreamBuffer, LoggerStreamBufferHolder);
+		STINGRAYKIT_DEFINE_THREAD_LOCAL(Detail::LoggerStreamBuffer, LoggerStreamBufferHolder);
+
+
+		struct LoggerStreamBufferReleaser
+		{
+			Detail::LoggerStreamBuffer*		Buffer;
+
+			explicit LoggerStreamBufferReleaser(Detail::LoggerStreamBuffer* buffer) : Buffer(buffer) { }
+
+			~LoggerStreamBufferReleaser()
+			{
+				if (!Buffer)
+					return;
+
+				Buffer->Text.clear();
+				Buffer->Record.Clear();
+				Buffer->Fields.Clear();
+				Buffer->InUse = false;
+			}
+		};
+	}
+
+
+	LoggerStream::LoggerStream(const NamedLoggerParams* loggerParams, LogLevel loggerLogLevel, LogLevel streamLogLevel, DuplicatingLogsFilter* duplicatingLogsFilter, LogFunction* logFunction, LogRecordFunction* logRecordFunction) :
+		_loggerParams(loggerParams), _loggerLogLevel(loggerLogLevel), _streamLogLevel(streamLogLevel), _enabled(streamLogLevel >= loggerLogLevel), _buffer(NULL), _written(false),
+		_duplicatingLogsFilter(duplicatingLogsFilter), _logFunction(logFunction), _logRecordFunction(logRecordFunction)
+	{
+		if (FlightRecorder::IsEnabled(_streamLogLevel))
+		{
+			// recorder needs the text right away
+			_enabled = true;
+			_logRecordFunction = NULL;
+		}
+
+		if (!_enabled)
+			return;
+
+		Detail::LoggerStreamBuffer& buffer = LoggerStreamBufferHolder::Get();
+		if (buffer.InUse) // nested stream, e.g. logging from ToString of an argument, formats to its own storage
+			return;
+
+		buffer.InUse = true;
+		_buffer = &buffer;
+	}
+
+
+	LoggerStream::LoggerStream(const LoggerStream& other) :
+		_loggerParams(other._loggerParams), _loggerLogLevel(other._loggerLogLevel), _streamLogLevel(other._streamLogLevel), _enabled(other._enabled), _buffer(other._buffer), _stream(other._stream), _fields(other._fields), _written(other._written),
+		_duplicatingLogsFilter(other._duplicatingLogsFilter), _hideDuplicatingLogs(other._hideDuplicatingLogs), _logFunction(other._logFunction), _logRecordFunction(other._logRecordFunction)
+	{ other._buffer = NULL; }
 
 
 	LoggerStream::~LoggerStream()
 	{
-		if (!_stream || !_stream.unique())
+		const LoggerStreamBufferReleaser releaser(_buffer);
+
+		if (std::uncaught_exception())
+		{
+			try
+			{ Flush(); }
+			catch(const std::exception &ex)
+			{ return; }
+		}
+		else
+			Flush();
+	}
+
+
+	LogFields& LoggerStream::GetFields()
+	{
+		if (_buffer)
+			return _buffer->Fields;
+
+		if (!_stream) // the message is logged only if it has the text stream
+			_stream.reset(new StreamType);
+		if (!_fields)
+			_fields.reset(new LogFields);
+		return *_fields;
+	}
+
+
+	const LogFields* LoggerStream::GetFieldsIfAny() const
+	{
+		const LogFields* fields = _buffer ? &_buffer->Fields : _fields.get();
+		return fields && !fields->IsEmpty() ? fields : NULL;
+	}
+
+
+	void LoggerStream::Flush()
+	{
+		if (!_written)
 			return;
 
-		if (_streamLogLevel >= _loggerLogLevel)
+		if (_buffer && _logRecordFunction) // streams with the record function are never recorded, so they are written only if enabled
 		{
-			if (std::uncaught_exception())
+			if (_duplicatingLogsFilter && _hideDuplicatingLogs)
 			{
-				try
-				{ DoLog(_stream->str()); }
-				catch(const std::exception &ex)
-				{ return; }
+				// duplicates are detected by the message text
+				_buffer->Record.Format(_buffer->Text);
+				DoLog(_buffer->Text);
 			}
 			else
-				DoLog(_stream->str());
+				_logRecordFunction(_loggerParams, _streamLogLevel, _buffer->Record, GetFieldsIfAny());
+			return;
 		}
+
+		const StreamType* const message = _buffer ? &_buffer->Text : (_stream.unique() ? _stream.get() : NULL);
+		if (!message)
+			return;
+
+		if (FlightRecorder::IsEnabled(_streamLogLevel))
+			FlightRecorder::Record(_loggerParams ? _loggerParams->GetName() : NULL, _streamLogLevel, *message);
+
+		if (_streamLogLevel >= _loggerLogLevel)
+			DoLog(*message);
+	}
+
+
+	void LoggerStream::DoLog(const StreamType& message)
+	{
+		if (_duplicatingLogsFilter && _hideDuplicatingLogs)
+			DoLog(message.str());
+		else
+			_logFunction(_loggerParams, _streamLogLevel, message, GetFieldsIfAny());
 	}
 
 
@@ -80,6 +187,10 @@ namespace stingray
 
 
 	void LoggerStream::DoLogImpl(const std::string& message)
-	{ _logFunction(_loggerParams, _streamLogLevel, message); }
+	{
+		StreamType stream;
+		stream << message;
+		_logFunction(_loggerParams, _streamLogLevel, stream, GetFieldsIfAny());
+	}
 
 }
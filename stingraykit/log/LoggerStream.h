@@ -9,8 +9,13 @@
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 
+#include <stingraykit/log/FlightRecorder.h>
+#include <stingraykit/log/LogFields.h>
 #include <stingraykit/log/LogLevel.h>
+#include <stingraykit/log/LogRateLimit.h>
+#include <stingraykit/log/LogRecord.h>
 #include <stingraykit/log/NamedLoggerParams.h>
+#include <stingraykit/optional.h>
 #include <stingraykit/shared_ptr.h>
 #include <stingraykit/string/ToString.h>
 #include <stingraykit/string/string_stream.h>
@@ -76,46 +81,62 @@ namespace stingray
 #define STINGRAYKIT_HIDE_DUPLICATING_LOGS(N_, ...) stingray::Detail::HideDuplicatingLogs(N_, __FILE__, __LINE__, ##__VA_ARGS__)
 
 
+	namespace Detail
+	{
+		struct LoggerStreamBuffer
+		{
+			string_ostream	Text;
+			LogRecord		Record;
+			LogFields		Fields;
+			bool			InUse;
+
+			LoggerStreamBuffer() : InUse(false) { }
+		};
+	}
+
+
 	class LoggerStream
 	{
 		STINGRAYKIT_NONASSIGNABLE(LoggerStream);
 		typedef string_ostream					StreamType;
 
-		typedef void LogFunction(const NamedLoggerParams* loggerParams, LogLevel logLevel, const std::string& message);
+	public:
+		typedef void LogFunction(const NamedLoggerParams* loggerParams, LogLevel logLevel, const string_ostream& message, const LogFields* fields);
+		typedef void LogRecordFunction(const NamedLoggerParams* loggerParams, LogLevel logLevel, const LogRecord& record, const LogFields* fields);
 
+	private:
 		const NamedLoggerParams*				_loggerParams;
 		LogLevel								_loggerLogLevel;
 		LogLevel								_streamLogLevel;
-		shared_ptr<StreamType>					_stream;
+		bool									_enabled; // delivered to the sinks or recorded by the FlightRecorder
+		mutable Detail::LoggerStreamBuffer*		_buffer; // per-thread buffer, owned by the last copy of the stream
+		shared_ptr<StreamType>					_stream; // used instead of the per-thread buffer by the streams nested into formatting of another one
+		shared_ptr<LogFields>					_fields; // same as _stream
+		bool									_written;
 		DuplicatingLogsFilter*					_duplicatingLogsFilter;
-		shared_ptr<Detail::HideDuplicatingLogs>	_hideDuplicatingLogs;
+		optional<Detail::HideDuplicatingLogs>	_hideDuplicatingLogs;
 		LogFunction*							_logFunction;
+		LogRecordFunction*						_logRecordFunction;
 
 	public:
-		LoggerStream(const NamedLoggerParams* loggerParams, LogLevel loggerLogLevel, LogLevel streamLogLevel, DuplicatingLogsFilter* duplicatingLogsFilter, LogFunction* logFunction);
+		/// @param logRecordFunction if not null, the arguments are captured to a LogRecord instead of being formatted on the calling thread
+		LoggerStream(const NamedLoggerParams* loggerParams, LogLevel loggerLogLevel, LogLevel streamLogLevel, DuplicatingLogsFilter* duplicatingLogsFilter, LogFunction* logFunction, LogRecordFunction* logRecordFunction = NULL);
+		LoggerStream(const LoggerStream& other);
 		~LoggerStream();
 
 		template < typename T >
 		typename EnableIf<!IsIntType<T>::Value, LoggerStream&>::ValueT operator << (const T& val)
 		{
-			if (_streamLogLevel < _loggerLogLevel)
-				return *this;
-
-			if (!_stream)
-				_stream.reset(new StreamType);
-			ToString(*_stream, val);
+			if (_enabled)
+				Write(val);
 			return *this;
 		}
 
 		template < typename T >
 		typename EnableIf<IsIntType<T>::Value, LoggerStream&>::ValueT operator << (T val)
 		{
-			if (_streamLogLevel < _loggerLogLevel)
-				return *this;
-
-			if (!_stream)
-				_stream.reset(new StreamType);
-			ToString(*_stream, val);
+			if (_enabled)
+				Write(val);
 			return *this;
 		}
 
@@ -125,12 +146,56 @@ namespace stingray
 				_duplicatingLogsFilter = val.Filter;
 
 			if (_duplicatingLogsFilter)
-				_hideDuplicatingLogs.reset(new Detail::HideDuplicatingLogs(val));
+				_hideDuplicatingLogs.emplace(val);
 
 			return *this;
 		}
 
+		template < typename T >
+		LoggerStream& operator << (const Detail::LogFieldArg<T>& field)
+		{
+			if (_enabled)
+			{
+				GetFields().Add(field.Key, field.Value);
+				_written = true;
+			}
+			return *this;
+		}
+
+		LoggerStream& operator << (const Detail::SuppressedLogs& val)
+		{
+			if (_enabled && val.Count != 0)
+			{
+				Write("[");
+				Write(val.Count);
+				Write(" suppressed] ");
+			}
+			return *this;
+		}
+
 	private:
+		template < typename T >
+		void Write(const T& val)
+		{
+			if (!_buffer)
+			{
+				if (!_stream)
+					_stream.reset(new StreamType);
+				ToString(*_stream, val);
+			}
+			else if (_logRecordFunction)
+				_buffer->Record.Append(val);
+			else
+				ToString(_buffer->Text, val);
+
+			_written = true;
+		}
+
+		LogFields& GetFields();
+		const LogFields* GetFieldsIfAny() const;
+
+		void Flush();
+		void DoLog(const StreamType& message);
 		void DoLog(const std::string& message);
 		void DoLogImpl(const std::string& message);
 	};
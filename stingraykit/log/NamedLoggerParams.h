@@ -9,6 +9,7 @@
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 
+#include <stingraykit/string/InternedString.h>
 #include <stingraykit/thread/atomic.h>
 
 
@@ -19,14 +20,16 @@ namespace stingray
 	{
 	private:
 		const char*						_name;
+		InternedString					_internedName;
 		atomic<bool>					_backtrace;
 		atomic<bool>					_highlight;
 
 	public:
-		NamedLoggerParams(const char* name) : _name(name), _backtrace(false), _highlight(false)
+		NamedLoggerParams(const char* name) : _name(name), _internedName(name), _backtrace(false), _highlight(false)
 		{ }
 
-		const char* GetName() const			{ return _name; }
+		const char* GetName() const						{ return _name; }
+		const InternedString& GetInternedName() const	{ return _internedName; }
 
 		bool BacktraceEnabled() const		{ return _backtrace; }
 		void EnableBacktrace(bool enable)	{ _backtrace = enable; }
@@ -0,0 +1,106 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/TimestampFormatter.h>
+
+#include <stingraykit/time/BrokenDownTime.h>
+#include <stingraykit/time/TimeEngine.h>
+
+#include <limits>
+
+namespace stingray
+{
+
+	namespace
+	{
+
+		const char DefaultFormat[] = "dd/MM/YYYY hh:mm:ss.lll";
+		const char MillisecondsPattern[] = "lll";
+
+		std::string FormatPart(const BrokenDownTime& bdt, const std::string& format)
+		{ return format.empty() ? std::string() : bdt.ToString(format); }
+
+	}
+
+
+	TimestampFormatter::TimestampFormatter(const std::string& format, TimeKind kind) :
+		_kind(kind), _second(std::numeric_limits<s64>::min())
+	{
+		const std::string fullFormat = format.empty() ? std::string(DefaultFormat) : format;
+		const size_t pos = fullFormat.find(MillisecondsPattern);
+
+		_hasMilliseconds = pos != std::string::npos;
+		_prefixFormat = fullFormat.substr(0, pos);
+		if (_hasMilliseconds)
+			_suffixFormat = fullFormat.substr(pos + sizeof(MillisecondsPattern) - 1);
+	}
+
+
+	void TimestampFormatter::Format(string_ostream& result, const Time& time)
+	{
+		const int milliseconds = Update(time);
+
+		result.write(_prefix.data(), _prefix.size());
+		if (_hasMilliseconds)
+		{
+			result.push_back((char)('0' + milliseconds / 100));
+			result.push_back((char)('0' + milliseconds / 10 % 10));
+			result.push_back((char)('0' + milliseconds % 10));
+		}
+		result.write(_suffix.data(), _suffix.size());
+	}
+
+
+	void TimestampFormatter::Format(std::string& result, const Time& time)
+	{
+		const int milliseconds = Update(time);
+
+		result.append(_prefix);
+		if (_hasMilliseconds)
+		{
+			result.push_back((char)('0' + milliseconds / 100));
+			result.push_back((char)('0' + milliseconds / 10 % 10));
+			result.push_back((char)('0' + milliseconds % 10));
+		}
+		result.append(_suffix);
+	}
+
+
+	std::string TimestampFormatter::ToString(const Time& time)
+	{
+		std::string result;
+		Format(result, time);
+		return result;
+	}
+
+
+	int TimestampFormatter::Update(const Time& time)
+	{
+		// the offset is a part of the key, so that the cached text is rendered again if the time zone changes
+		const s64 offset = _kind == TimeKind::Utc ? 0 : (s64)TimeEngine::GetMinutesFromUtc() * 60 * 1000;
+		const s64 milliseconds = time.GetMilliseconds() + offset;
+
+		s64 second = milliseconds / 1000;
+		int subsecond = (int)(milliseconds % 1000);
+		if (subsecond < 0)
+		{
+			--second;
+			subsecond += 1000;
+		}
+
+		if (second != _second)
+		{
+			const BrokenDownTime bdt = time.BreakDown(_kind);
+			_prefix = FormatPart(bdt, _prefixFormat);
+			_suffix = FormatPart(bdt, _suffixFormat);
+			_second = second;
+		}
+
+		return subsecond;
+	}
+
+}
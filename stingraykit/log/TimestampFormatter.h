@@ -0,0 +1,56 @@
+#ifndef STINGRAYKIT_LOG_TIMESTAMPFORMATTER_H
+#define STINGRAYKIT_LOG_TIMESTAMPFORMATTER_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/string/string_stream.h>
+#include <stingraykit/time/Time.h>
+
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief Formats message times, the broken-down time is rendered only when the second changes, otherwise just the milliseconds are updated
+	 * @par The format takes the BrokenDownTime::ToString patterns, empty one stands for the Time::ToString default "dd/MM/YYYY hh:mm:ss.lll".
+	 * The formatter is not thread-safe, so each sink (or thread) should have its own one.
+	 */
+	class TimestampFormatter
+	{
+	private:
+		std::string		_prefixFormat; // part of the format before the milliseconds
+		std::string		_suffixFormat; // part of the format after the milliseconds
+		bool			_hasMilliseconds;
+		TimeKind		_kind;
+
+		s64				_second;
+		std::string		_prefix;
+		std::string		_suffix;
+
+	public:
+		explicit TimestampFormatter(const std::string& format = std::string(), TimeKind kind = TimeKind::Local);
+
+		void Format(string_ostream& result, const Time& time);
+		void Format(std::string& result, const Time& time);
+
+		std::string ToString(const Time& time);
+
+	private:
+		int Update(const Time& time);
+	};
+
+	/** @} */
+
+}
+
+#endif
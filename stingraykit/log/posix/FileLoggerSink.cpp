@@ -0,0 +1,294 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/posix/FileLoggerSink.h>
+
+#include <stingraykit/string/ToString.h>
+#include <stingraykit/SystemException.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace stingray {
+namespace posix
+{
+
+	namespace
+	{
+
+		const int MaxIoVectors = 64;
+
+		const char LevelLetters[] = { 'T', 'D', 'I', 'W', 'E', 'S' };
+
+		std::string GetBackupPath(const std::string& path, size_t index)
+		{ return index == 0 ? path : path + "." + ToString(index); }
+
+	}
+
+
+	FileLoggerSink::FileLoggerSink(const std::string& path, u64 maxFileSize, size_t maxBackupFiles, const optional<TimeDuration>& rotationInterval, const optional<TimeDuration>& syncInterval) :
+		_path(path),
+		_maxFileSize(maxFileSize),
+		_maxBackupFiles(maxBackupFiles),
+		_rotationInterval(rotationInterval),
+		_syncInterval(syncInterval),
+		_fd(-1),
+		_fileSize(0),
+		_syncPending(false),
+		_usedChunks(0),
+		_bufferedSize(0),
+		_timestampFormatter("YYYY-MM-dd hh:mm:ss.lll")
+	{ Open(); }
+
+
+	FileLoggerSink::~FileLoggerSink()
+	{
+		try
+		{
+			DoFlush();
+			if (_syncPending)
+				Sync();
+		}
+		catch (const std::exception&)
+		{ }
+
+		Close();
+	}
+
+
+	void FileLoggerSink::Log(const LoggerMessage& message)
+	{
+		MutexLock l(_mutex);
+
+		FormatLine(message);
+		if (_bufferedSize >= MaxBufferedSize)
+			DoFlush();
+	}
+
+
+	void FileLoggerSink::Flush()
+	{
+		MutexLock l(_mutex);
+		DoFlush();
+	}
+
+
+	void FileLoggerSink::FormatLine(const LoggerMessage& message)
+	{
+		_timestamp.clear();
+		_timestampFormatter.Format(_timestamp, message.GetTime());
+
+		const char level[] = { ' ', LevelLetters[message.GetLogLevel().val()], ' ', '{' };
+
+		Append(_timestamp.data(), _timestamp.size());
+		Append(level, sizeof(level));
+
+		const std::string& threadName = message.GetThreadName();
+		Append(threadName.data(), threadName.size());
+
+		if (message.HasLoggerName())
+		{
+			const std::string& loggerName = message.GetLoggerName();
+			Append("} [", 3);
+			Append(loggerName.data(), loggerName.size());
+			Append("] ", 2);
+		}
+		else
+			Append("} ", 2);
+
+		const std::string& text = message.GetMessage();
+		Append(text.data(), text.size());
+
+		if (!message.GetFields().IsEmpty())
+		{
+			_fieldsText.clear();
+			message.GetFields().Format(_fieldsText);
+			_fieldsText.copy_to(_fieldsLine);
+			Append(_fieldsLine.data(), _fieldsLine.size());
+		}
+
+		Append("\n", 1);
+	}
+
+
+	void FileLoggerSink::Append(const char* data, size_t size)
+	{
+		if (_usedChunks == 0 || _chunks[_usedChunks - 1].size() + size > ChunkSize)
+		{
+			// a line longer than the chunk just grows it, so a message is never lost because of its size
+			if (_usedChunks == 0 || !_chunks[_usedChunks - 1].empty())
+			{
+				if (_usedChunks == _chunks.size())
+				{
+					_chunks.push_back(std::string());
+					_chunks.back().reserve(ChunkSize);
+				}
+				++_usedChunks;
+			}
+		}
+
+		_chunks[_usedChunks - 1].append(data, size);
+		_bufferedSize += size;
+	}
+
+
+	void FileLoggerSink::DoFlush()
+	{
+		if (_bufferedSize == 0)
+			return;
+
+		try
+		{
+			// the file is left closed if it failed to reopen after the rotation, it is reopened without rotating again, so that the backups are kept
+			if (_fd < 0)
+				Open();
+			else if (NeedsRotation())
+				Rotate();
+		}
+		catch (const std::exception&)
+		{
+			ClearBuffer();
+			throw;
+		}
+
+		WriteBuffered();
+
+		if (_syncInterval && _sinceSync.Elapsed() >= *_syncInterval)
+			Sync();
+	}
+
+
+	void FileLoggerSink::WriteBuffered()
+	{
+		size_t chunk = 0;
+		size_t offset = 0;
+
+		while (chunk < _usedChunks)
+		{
+			iovec iov[MaxIoVectors];
+			int count = 0;
+			for (size_t i = chunk; i < _usedChunks && count < MaxIoVectors; ++i, ++count)
+			{
+				const size_t skip = i == chunk ? offset : 0;
+				iov[count].iov_base = const_cast<char*>(_chunks[i].data() + skip);
+				iov[count].iov_len = _chunks[i].size() - skip;
+			}
+
+			const ssize_t written = writev(_fd, iov, count);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				const int err = errno;
+				ClearBuffer();
+				STINGRAYKIT_THROW_SYSTEM_EXCEPTION("writev", _path, err);
+			}
+
+			_fileSize += written;
+			_syncPending = true;
+
+			for (size_t left = written; left != 0; )
+			{
+				const size_t rest = _chunks[chunk].size() - offset;
+				if (left < rest)
+				{
+					offset += left;
+					left = 0;
+				}
+				else
+				{
+					left -= rest;
+					offset = 0;
+					++chunk;
+				}
+			}
+		}
+
+		ClearBuffer();
+	}
+
+
+	void FileLoggerSink::ClearBuffer()
+	{
+		for (size_t i = 0; i < _usedChunks; ++i)
+			_chunks[i].clear();
+
+		_usedChunks = 0;
+		_bufferedSize = 0;
+	}
+
+
+	void FileLoggerSink::Sync()
+	{
+		if (fdatasync(_fd) != 0)
+			STINGRAYKIT_THROW(SystemException("fdatasync", _path, errno));
+
+		_sinceSync.Restart();
+		_syncPending = false;
+	}
+
+
+	bool FileLoggerSink::NeedsRotation() const
+	{
+		if (_fileSize == 0)
+			return false;
+
+		if (_maxFileSize != 0 && _fileSize + _bufferedSize > _maxFileSize)
+			return true;
+
+		return _rotationInterval && _fileAge.Elapsed() >= *_rotationInterval;
+	}
+
+
+	void FileLoggerSink::Rotate()
+	{
+		if (_syncPending)
+			Sync();
+
+		Close();
+		_fileSize = 0;
+		_fileAge.Restart();
+
+		// renaming is best effort, the file is reopened anyway so that logging goes on
+		if (_maxBackupFiles == 0)
+			unlink(_path.c_str());
+
+		for (size_t i = _maxBackupFiles; i != 0; --i)
+			rename(GetBackupPath(_path, i - 1).c_str(), GetBackupPath(_path, i).c_str());
+
+		Open();
+	}
+
+
+	void FileLoggerSink::Open()
+	{
+		_fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (_fd < 0)
+			STINGRAYKIT_THROW_SYSTEM_EXCEPTION("open", _path, errno);
+
+		struct stat st;
+		_fileSize = fstat(_fd, &st) == 0 ? st.st_size : 0;
+		_fileAge.Restart();
+		_sinceSync.Restart();
+	}
+
+
+	void FileLoggerSink::Close()
+	{
+		if (_fd < 0)
+			return;
+
+		close(_fd);
+		_fd = -1;
+	}
+
+}}
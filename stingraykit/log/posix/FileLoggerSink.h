@@ -0,0 +1,96 @@
+#ifndef STINGRAYKIT_LOG_POSIX_FILELOGGERSINK_H
+#define STINGRAYKIT_LOG_POSIX_FILELOGGERSINK_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/ILoggerSink.h>
+#include <stingraykit/log/TimestampFormatter.h>
+#include <stingraykit/thread/Thread.h>
+#include <stingraykit/time/ElapsedTime.h>
+
+#include <vector>
+
+
+namespace stingray {
+namespace posix
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief Appends messages to a file as "YYYY-MM-DD HH:MM:SS.mmm L {thread} [logger] text key=value" lines
+	 * @par Lines are buffered until Flush, which writes all of them with a single writev, so with asynchronous delivery there is one syscall per delivered batch.
+	 * The file is rotated to path.1 ... path.N when it grows beyond maxFileSize or gets older than rotationInterval, zero maxFileSize disables size-based rotation.
+	 * If syncInterval is set, the written data is flushed to the storage with fdatasync at most once per that interval.
+	 */
+	class FileLoggerSink : public ILoggerSink
+	{
+		STINGRAYKIT_NONCOPYABLE(FileLoggerSink);
+
+		typedef std::vector<std::string>	Chunks;
+
+		static const size_t ChunkSize = 16 * 1024;
+		static const size_t MaxBufferedSize = 256 * 1024;
+
+	private:
+		std::string					_path;
+		u64							_maxFileSize;
+		size_t						_maxBackupFiles;
+		optional<TimeDuration>		_rotationInterval;
+		optional<TimeDuration>		_syncInterval;
+
+		Mutex						_mutex;
+		int							_fd;
+		u64							_fileSize;
+		ElapsedTime					_fileAge;
+		ElapsedTime					_sinceSync;
+		bool						_syncPending;
+
+		Chunks						_chunks;
+		size_t						_usedChunks;
+		size_t						_bufferedSize;
+
+		TimestampFormatter			_timestampFormatter;
+		std::string					_timestamp;
+		string_ostream				_fieldsText;
+		std::string					_fieldsLine;
+
+	public:
+		FileLoggerSink(const std::string& path, u64 maxFileSize = 0, size_t maxBackupFiles = 1, const optional<TimeDuration>& rotationInterval = null, const optional<TimeDuration>& syncInterval = null);
+		virtual ~FileLoggerSink();
+
+		virtual void Log(const LoggerMessage& message);
+		virtual void Flush();
+
+	protected:
+		/// @brief Appends the line of the message to the buffer, is called with the sink mutex locked
+		virtual void FormatLine(const LoggerMessage& message);
+		void Append(const char* data, size_t size);
+
+	private:
+		void DoFlush();
+		void WriteBuffered();
+		void ClearBuffer();
+		void Sync();
+
+		bool NeedsRotation() const;
+		void Rotate();
+		void Open();
+		void Close();
+	};
+	STINGRAYKIT_DECLARE_PTR(FileLoggerSink);
+
+	/** @} */
+
+}}
+
+
+#endif
@@ -0,0 +1,138 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/log/posix/JsonLinesLoggerSink.h>
+
+#include <math.h>
+#include <stdio.h>
+
+namespace stingray {
+namespace posix
+{
+
+	namespace
+	{
+
+		const char HexDigits[] = "0123456789abcdef";
+
+		const char* const LevelNames[] = { "Trace", "Debug", "Info", "Warning", "Error", "Silent" };
+
+		void AppendJsonString(std::string& result, const char* str, size_t size)
+		{
+			result.push_back('"');
+			for (size_t i = 0; i < size; ++i)
+			{
+				const unsigned char c = str[i];
+				switch (c)
+				{
+				case '"':	result.append("\\\"", 2); break;
+				case '\\':	result.append("\\\\", 2); break;
+				case '\n':	result.append("\\n", 2); break;
+				case '\r':	result.append("\\r", 2); break;
+				case '\t':	result.append("\\t", 2); break;
+				default:
+					if (c < 0x20)
+					{
+						const char escaped[] = { '\\', 'u', '0', '0', HexDigits[c >> 4], HexDigits[c & 0xf] };
+						result.append(escaped, sizeof(escaped));
+					}
+					else
+						result.push_back((char)c);
+				}
+			}
+			result.push_back('"');
+		}
+
+		void AppendJsonString(std::string& result, const std::string& str)
+		{ AppendJsonString(result, str.data(), str.size()); }
+
+		void AppendJsonKey(std::string& result, const char* key, size_t size)
+		{
+			AppendJsonString(result, key, size);
+			result.push_back(':');
+		}
+
+		void AppendJsonValue(std::string& result, const LogFields::Field& field)
+		{
+			char buf[32];
+			int size = 0;
+
+			switch (field.GetType())
+			{
+			case LogFields::FieldType::Bool:
+				result.append(field.GetBool() ? "true" : "false");
+				return;
+			case LogFields::FieldType::Int:
+				size = snprintf(buf, sizeof(buf), "%lld", (long long)field.GetInt());
+				break;
+			case LogFields::FieldType::UInt:
+				size = snprintf(buf, sizeof(buf), "%llu", (unsigned long long)field.GetUInt());
+				break;
+			case LogFields::FieldType::Double:
+				if (!isfinite(field.GetDouble())) // JSON has no representation for them
+				{
+					result.append("null");
+					return;
+				}
+				size = snprintf(buf, sizeof(buf), "%.17g", field.GetDouble());
+				break;
+			case LogFields::FieldType::String:
+				AppendJsonString(result, field.GetStringData(), field.GetStringSize());
+				return;
+			}
+
+			result.append(buf, std::min((size_t)std::max(size, 0), sizeof(buf) - 1));
+		}
+
+	}
+
+
+	JsonLinesLoggerSink::JsonLinesLoggerSink(const std::string& path, u64 maxFileSize, size_t maxBackupFiles, const optional<TimeDuration>& rotationInterval, const optional<TimeDuration>& syncInterval) :
+		FileLoggerSink(path, maxFileSize, maxBackupFiles, rotationInterval, syncInterval),
+		_timestampFormatter("YYYY-MM-ddThh:mm:ss.lllZ", TimeKind::Utc)
+	{ }
+
+
+	void JsonLinesLoggerSink::FormatLine(const LoggerMessage& message)
+	{
+		_line.clear();
+
+		_line.append("{\"time\":\"");
+		_timestampFormatter.Format(_line, message.GetTime());
+		_line.append("\",\"level\":\"");
+		_line.append(LevelNames[message.GetLogLevel().val()]);
+		_line.append("\",\"thread\":");
+		AppendJsonString(_line, message.GetThreadName());
+
+		if (message.HasLoggerName())
+		{
+			_line.append(",\"logger\":");
+			AppendJsonString(_line, message.GetLoggerName());
+		}
+
+		_line.append(",\"message\":");
+		AppendJsonString(_line, message.GetMessage());
+
+		const LogFields& fields = message.GetFields();
+		if (!fields.IsEmpty())
+		{
+			_line.append(",\"fields\":{");
+			for (LogFields::const_iterator it = fields.begin(); it != fields.end(); ++it)
+			{
+				if (it != fields.begin())
+					_line.push_back(',');
+				AppendJsonKey(_line, it->GetKeyData(), it->GetKeySize());
+				AppendJsonValue(_line, *it);
+			}
+			_line.push_back('}');
+		}
+
+		_line.append("}\n");
+		Append(_line.data(), _line.size());
+	}
+
+}}
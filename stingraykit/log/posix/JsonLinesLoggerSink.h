@@ -0,0 +1,47 @@
+#ifndef STINGRAYKIT_LOG_POSIX_JSONLINESLOGGERSINK_H
+#define STINGRAYKIT_LOG_POSIX_JSONLINESLOGGERSINK_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <stingraykit/log/posix/FileLoggerSink.h>
+
+namespace stingray {
+namespace posix
+{
+
+	/**
+	 * @addtogroup toolkit_log
+	 * @{
+	 */
+
+	/**
+	 * @brief FileLoggerSink, which writes messages as JSON objects, one per line, so that log shippers don't have to parse the text
+	 * @par Line example: {"time":"2017-05-17T10:17:37.443Z","level":"Info","thread":"main","logger":"Foo","message":"text","fields":{"status":200,"path":"/x"}}
+	 * The time is in UTC, "logger" and "fields" are omitted if the message has none, the field values keep their types.
+	 */
+	class JsonLinesLoggerSink : public FileLoggerSink
+	{
+	private:
+		TimestampFormatter		_timestampFormatter;
+		std::string				_line;
+
+	public:
+		JsonLinesLoggerSink(const std::string& path, u64 maxFileSize = 0, size_t maxBackupFiles = 1, const optional<TimeDuration>& rotationInterval = null, const optional<TimeDuration>& syncInterval = null);
+
+	protected:
+		virtual void FormatLine(const LoggerMessage& message);
+	};
+	STINGRAYKIT_DECLARE_PTR(JsonLinesLoggerSink);
+
+	/** @} */
+
+}}
+
+
+#endif
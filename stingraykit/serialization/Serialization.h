@@ -329,7 +329,7 @@ namespace stingray
 
 			shared_ptr<IFactoryObject> factory_object = dynamic_caster(value);
 			if (!factory_object)
-				STINGRAYKIT_THROW(std::string("type ") + Demangle(typeid(*value).name()) + " cannot be serialized, no IFactoryObject interface found");
+				STINGRAYKIT_THROW(std::string("type ") + Demangle(typeid(*value)) + " cannot be serialized, no IFactoryObject interface found");
 
 			std::string classname(_context->GetClassName(typeid(*value)));
 			BeginObject();
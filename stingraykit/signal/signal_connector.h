@@ -14,6 +14,8 @@
 #include <stingraykit/TaskLifeToken.h>
 #include <stingraykit/Token.h>
 
+#include <vector>
+
 namespace stingray
 {
 
@@ -30,6 +32,7 @@ namespace stingray
 			virtual ~ISignalConnector() { }
 
 			virtual Token Connect(const function_storage& func, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken, bool sendCurrentState) = 0;
+			virtual Token ConnectBatch(const std::vector<function_storage>& funcs, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken, bool sendCurrentState) = 0;
 			virtual void SendCurrentState(const function_storage& slot) const = 0;
 
 			virtual TaskLifeToken CreateSyncToken() const = 0;
@@ -38,6 +41,28 @@ namespace stingray
 			virtual ConnectionPolicy GetConnectionPolicy() const = 0;
 		};
 
+
+		template < typename Signature_ >
+		std::vector<function_storage> MakeSlotStorages(const std::vector<function<Signature_> >& slots)
+		{
+			std::vector<function_storage> result;
+			result.reserve(slots.size());
+			for (typename std::vector<function<Signature_> >::const_iterator it = slots.begin(); it != slots.end(); ++it)
+				result.push_back(function_storage(*it));
+			return result;
+		}
+
+
+		template < typename Signature_ >
+		std::vector<function_storage> MakeAsyncSlotStorages(const ITaskExecutorPtr& worker, const std::vector<function<Signature_> >& slots, const FutureExecutionTester& tester)
+		{
+			std::vector<function_storage> result;
+			result.reserve(slots.size());
+			for (typename std::vector<function<Signature_> >::const_iterator it = slots.begin(); it != slots.end(); ++it)
+				result.push_back(function_storage(function<Signature_>(MakeAsyncFunction(worker, *it, tester))));
+			return result;
+		}
+
 	}
 
 
@@ -85,6 +110,27 @@ namespace stingray
 			STINGRAYKIT_CHECK(_impl->GetConnectionPolicy() == ConnectionPolicy::Any || _impl->GetConnectionPolicy() == ConnectionPolicy::AsyncOnly, "async-connect to sync-only signal");
 			return _impl->Connect(function_storage(function<Signature_>(MakeAsyncFunction(worker, slot, token.GetExecutionTester()))), null, token, sendCurrentState);
 		}
+
+		/// @brief Connects all the slots under a single signal lock, the returned token disconnects them at once
+		Token connect(const std::vector<function<Signature_> >& slots, bool sendCurrentState = true) const
+		{
+			if (STINGRAYKIT_UNLIKELY(!_impl))
+				return Token();
+
+			TaskLifeToken token(_impl->CreateSyncToken());
+			STINGRAYKIT_CHECK(_impl->GetConnectionPolicy() == ConnectionPolicy::Any || _impl->GetConnectionPolicy() == ConnectionPolicy::SyncOnly, "sync-connect to async-only signal");
+			return _impl->ConnectBatch(Detail::MakeSlotStorages(slots), token.GetExecutionTester(), token, sendCurrentState);
+		}
+
+		Token connect(const ITaskExecutorPtr& worker, const std::vector<function<Signature_> >& slots, bool sendCurrentState = true) const
+		{
+			if (STINGRAYKIT_UNLIKELY(!_impl))
+				return Token();
+
+			TaskLifeToken token(_impl->CreateAsyncToken());
+			STINGRAYKIT_CHECK(_impl->GetConnectionPolicy() == ConnectionPolicy::Any || _impl->GetConnectionPolicy() == ConnectionPolicy::AsyncOnly, "async-connect to sync-only signal");
+			return _impl->ConnectBatch(Detail::MakeAsyncSlotStorages(worker, slots, token.GetExecutionTester()), null, token, sendCurrentState);
+		}
 	};
 
 
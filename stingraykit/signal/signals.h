@@ -8,6 +8,7 @@
 // IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
 // WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
+#include <stingraykit/PooledAllocator.h>
 #include <stingraykit/Token.h>
 #include <stingraykit/assert.h>
 #include <stingraykit/collection/IntrusiveList.h>
@@ -29,6 +30,15 @@ namespace stingray
 
 #ifndef DOXYGEN_PREPROCESSOR
 
+	template < typename Signature_,
+		typename ThreadingPolicy_ = signal_policies::threading::Multithreaded,
+		typename ExceptionPolicy_ = signal_policies::exception_handling::Configurable,
+		typename PopulatorsPolicy_ = signal_policies::populators::Configurable,
+		typename ConnectionPolicyControl_ = signal_policies::connection_policy_control::Checked,
+		typename CreationPolicy_ = signal_policies::creation::Default>
+	class signal;
+
+
 	namespace Detail
 	{
 
@@ -43,12 +53,12 @@ namespace stingray
 				_functionStorage(func), _tester(tester)
 			{ }
 
-			template <typename Signature_, typename Params_>
-			void Invoke(const Params_& p) const
+			template <typename Signature_>
+			void Invoke(const Tuple<typename function_info<Signature_>::ParamTypes>& p) const
 			{
 				LocalExecutionGuard guard(_tester);
 				if (guard)
-					FunctorInvoker::Invoke(_functionStorage.ToFunction<Signature_>(), p);
+					_functionStorage.Invoke<Signature_>(p);
 			}
 		};
 
@@ -63,9 +73,9 @@ namespace stingray
 				_functionStorage(func)
 			{ STINGRAYKIT_CHECK(tester.IsDummy(), "ThreadlessStorage can't be used with real tokens!"); }
 
-			template <typename Signature_, typename Params_>
-			void Invoke(const Params_& p) const
-			{ FunctorInvoker::Invoke(_functionStorage.ToFunction<Signature_>(), p); }
+			template <typename Signature_>
+			void Invoke(const Tuple<typename function_info<Signature_>::ParamTypes>& p) const
+			{ _functionStorage.Invoke<Signature_>(p); }
 		};
 
 
@@ -132,6 +142,7 @@ namespace stingray
 			virtual TaskLifeToken CreateAsyncToken() const	{ return TaskLifeToken(); }
 
 			virtual Token Connect(const function_storage& func, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken, bool sendCurrentState);
+			virtual Token ConnectBatch(const std::vector<function_storage>& funcs, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken, bool sendCurrentState);
 
 			virtual void SendCurrentState(const function_storage& slot) const
 			{
@@ -151,6 +162,14 @@ namespace stingray
 				_handlers.erase(handler);
 			}
 
+			template < typename HandlerIterator >
+			void RemoveHandlers(HandlerIterator first, HandlerIterator last)
+			{
+				LockType l(DoGetSync());
+				for (; first != last; ++first)
+					_handlers.erase(*first);
+			}
+
 		protected:
 			void CopyHandlersToLocal(LocalHandlersCopy& localCopy) const
 			{ std::copy(_handlers.begin(), _handlers.end(), std::back_inserter(localCopy)); }
@@ -185,6 +204,45 @@ namespace stingray
 				_signalImpl->RemoveHandler(_handler);
 				_token.Release();
 			}
+
+			static void* operator new(size_t size)				{ return PooledAllocator<sizeof(Connection)>::Allocate(size); }
+			static void operator delete(void* ptr, size_t size)	{ PooledAllocator<sizeof(Connection)>::Deallocate(ptr, size); }
+		};
+
+
+		template <bool IsThreadsafe>
+		class ConnectionBatch : public IToken
+		{
+		public:
+			typedef SignalImplBase<IsThreadsafe>	Impl;
+			typedef self_count_ptr<Impl>			ImplPtr;
+			typedef typename Impl::FuncType			FuncType;
+			typedef typename Impl::Handler			Handler;
+			typedef std::vector<Handler>			Handlers;
+
+		private:
+			ImplPtr				_signalImpl;
+			Handlers			_handlers;
+			TaskLifeToken		_token;
+
+		public:
+			ConnectionBatch(const ImplPtr& signalImpl, const std::vector<function_storage>& funcs, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken) :
+				_signalImpl(signalImpl), _token(connectionToken)
+			{
+				// handlers are linked into the signal list, so they must not be moved after that
+				_handlers.reserve(funcs.size());
+				for (std::vector<function_storage>::const_iterator it = funcs.begin(); it != funcs.end(); ++it)
+					_handlers.push_back(FuncType(*it, invokeTester));
+
+				for (typename Handlers::iterator it = _handlers.begin(); it != _handlers.end(); ++it)
+					_signalImpl->AddHandler(*it);
+			}
+
+			virtual ~ConnectionBatch()
+			{
+				_signalImpl->RemoveHandlers(_handlers.begin(), _handlers.end());
+				_token.Release();
+			}
 		};
 
 
@@ -203,11 +261,27 @@ namespace stingray
 		}
 
 
+		template < bool IsThreadsafe >
+		Token SignalImplBase<IsThreadsafe>::ConnectBatch(const std::vector<function_storage>& funcs, const FutureExecutionTester& invokeTester, const TaskLifeToken& connectionToken, bool sendCurrentState)
+		{
+			LockType l(DoGetSync());
+			if (sendCurrentState)
+				for (std::vector<function_storage>::const_iterator it = funcs.begin(); it != funcs.end(); ++it)
+					DoSendCurrentState(*it);
+
+			typedef ConnectionBatch<IsThreadsafe> ConnectionBatch;
+			typename ConnectionBatch::ImplPtr impl(this);
+			this->add_ref();
+
+			return MakeToken<ConnectionBatch>(impl, funcs, invokeTester, connectionToken);
+		}
+
+
 		template < typename Signature_, typename ThreadingPolicy_, typename ExceptionPolicy_, typename PopulatorsPolicy_, typename ConnectionPolicyControl_ >
 		class SignalImpl : public ThreadingPolicy_, public ExceptionPolicy_, public PopulatorsPolicy_, public ConnectionPolicyControl_, public SignalImplBase<ThreadingPolicy_::IsThreadsafe>
 		{
 			template < typename Signature2_, typename ThreadingPolicy2_, typename ExceptionPolicy2_, typename PopulatorsPolicy2_, typename ConnectionPolicyControl2_, typename CreationPolicy2_ >
-			friend class signal;
+			friend class stingray::signal;
 
 			typedef SignalImplBase<ThreadingPolicy_::IsThreadsafe>	base;
 			typedef typename function_info<Signature_>::ParamTypes	ParamTypes;
@@ -295,14 +369,6 @@ namespace stingray
 		{ }
 	};
 
-	template < typename Signature_,
-		typename ThreadingPolicy_ = signal_policies::threading::Multithreaded,
-		typename ExceptionPolicy_ = signal_policies::exception_handling::Configurable,
-		typename PopulatorsPolicy_ = signal_policies::populators::Configurable,
-		typename ConnectionPolicyControl_ = signal_policies::connection_policy_control::Checked,
-		typename CreationPolicy_ = signal_policies::creation::Default>
-	class signal;
-
 #define DETAIL_SIGNAL_TEMPLATE_PARAM_DECL(Index_, UserArg_) typename T##Index_,
 #define DETAIL_SIGNAL_TEMPLATE_PARAM_USAGE(Index_, UserArg_) STINGRAYKIT_COMMA_IF(Index_) T##Index_
 #define DETAIL_SIGNAL_PARAM_DECL(Index_, UserArg_) STINGRAYKIT_COMMA_IF(Index_) T##Index_ p##Index_
@@ -381,6 +447,22 @@ namespace stingray
 			return _impl->Connect(function_storage(function<Signature>(MakeAsyncFunction(worker, slot, token.GetExecutionTester()))), null, token, sendCurrentState); \
 		} \
 		\
+		Token connect(const std::vector<function<Signature> >& slots, bool sendCurrentState = true) const \
+		{ \
+			CreationPolicy_::template LazyCreate(_impl); \
+			STINGRAYKIT_CHECK(_impl->GetConnectionPolicy() == ConnectionPolicy::Any || _impl->GetConnectionPolicy() == ConnectionPolicy::SyncOnly, "sync-connect to async-only signal"); \
+			TaskLifeToken token(_impl->CreateSyncToken()); \
+			return _impl->ConnectBatch(Detail::MakeSlotStorages(slots), token.GetExecutionTester(), token, sendCurrentState); \
+		} \
+		\
+		Token connect(const ITaskExecutorPtr& worker, const std::vector<function<Signature> >& slots, bool sendCurrentState = true) const \
+		{ \
+			CreationPolicy_::template LazyCreate(_impl); \
+			STINGRAYKIT_CHECK(_impl->GetConnectionPolicy() == ConnectionPolicy::Any || _impl->GetConnectionPolicy() == ConnectionPolicy::AsyncOnly, "async-connect to sync-only signal"); \
+			TaskLifeToken token(_impl->CreateAsyncToken()); \
+			return _impl->ConnectBatch(Detail::MakeAsyncSlotStorages(worker, slots, token.GetExecutionTester()), null, token, sendCurrentState); \
+		} \
+		\
 		signal_connector<Signature> connector() const { CreationPolicy_::template LazyCreate(_impl); return signal_connector<Signature>(_impl); } \
 		Invoker invoker() const { CreationPolicy_::template LazyCreate(_impl); return Invoker(_impl); } \
 		\
@@ -0,0 +1,90 @@
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include <stingraykit/string/InternedString.h>
+
+#include <stingraykit/thread/Thread.h>
+#include <stingraykit/thread/call_once.h>
+
+#include <set>
+
+namespace stingray
+{
+
+	namespace
+	{
+
+		class InternedStringPool
+		{
+			typedef std::set<std::string>	Strings;
+
+			static const size_t				MaxSize = 4096;
+
+		private:
+			Mutex		_mutex;
+			Strings		_strings;
+
+		public:
+			/// @return NULL if the string is missing and the pool is full
+			const std::string* TryIntern(const std::string& str)
+			{
+				MutexLock l(_mutex);
+				const Strings::const_iterator it = _strings.find(str);
+				if (it != _strings.end())
+					return &*it;
+
+				return _strings.size() < MaxSize ? &*_strings.insert(str).first : NULL;
+			}
+		};
+
+
+		// the pool is intentionally leaked, so that the handles stay valid while static objects are destroyed
+		InternedStringPool*				s_pool = NULL;
+		const std::string*				s_empty = NULL;
+		STINGRAYKIT_DEFINE_ONCE_FLAG(s_poolOnceFlag);
+
+		void CreatePool()
+		{
+			s_pool = new InternedStringPool();
+			s_empty = s_pool->TryIntern(std::string());
+		}
+
+		InternedStringPool& GetPool()
+		{
+			call_once(s_poolOnceFlag, &CreatePool);
+			return *s_pool;
+		}
+
+	}
+
+
+	InternedString::InternedString()
+	{
+		GetPool();
+		_str = s_empty;
+	}
+
+
+	InternedString::InternedString(const char* str)
+	{ Init(str); }
+
+
+	InternedString::InternedString(const std::string& str)
+	{ Init(str); }
+
+
+	void InternedString::Init(const std::string& str)
+	{
+		_str = GetPool().TryIntern(str);
+		if (_str)
+			return;
+
+		_unpooled = make_shared<std::string>(str);
+		_str = _unpooled.get();
+	}
+
+}
@@ -0,0 +1,66 @@
+#ifndef STINGRAYKIT_STRING_INTERNEDSTRING_H
+#define STINGRAYKIT_STRING_INTERNEDSTRING_H
+
+// Copyright (c) 2011 - 2017, GS Group, https://github.com/GSGroup
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby granted,
+// provided that the above copyright notice and this permission notice appear in all copies.
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <stingraykit/shared_ptr.h>
+#include <stingraykit/toolkit.h>
+
+#include <string>
+
+
+namespace stingray
+{
+
+	/**
+	 * @addtogroup toolkit_strings
+	 * @{
+	 */
+
+	/**
+	 * @brief Immutable handle of a string kept in a process-wide pool, so equal strings share one copy and copying or comparing handles for equality costs a pointer
+	 * @par The pool is never shrunk or destroyed, the references it gives stay valid until the process exits. It is meant for small sets of strings
+	 * like logger and thread names, and it is capped, so that dynamic names can't grow it without bound: once it is full, a handle of a string
+	 * that is missing from it holds a shared copy of its own, and the references to that copy are valid as long as the handle is.
+	 */
+	class InternedString
+	{
+	private:
+		const std::string*		_str;
+		shared_ptr<std::string>	_unpooled; // set only if the pool was full
+
+	public:
+		InternedString();
+		explicit InternedString(const char* str);
+		explicit InternedString(const std::string& str);
+
+		const std::string& str() const		{ return *_str; }
+		const char* c_str() const			{ return _str->c_str(); }
+		size_t size() const					{ return _str->size(); }
+		bool empty() const					{ return _str->empty(); }
+
+		std::string ToString() const		{ return *_str; }
+
+		bool operator == (const InternedString& other) const	{ return _str == other._str || (_unpooled && other._unpooled && *_str == *other._str); }
+		bool operator != (const InternedString& other) const	{ return !(*this == other); }
+
+		bool operator < (const InternedString& other) const		{ return _str != other._str && *_str < *other._str; }
+		bool operator > (const InternedString& other) const		{ return other < *this; }
+		bool operator <= (const InternedString& other) const	{ return !(other < *this); }
+		bool operator >= (const InternedString& other) const	{ return !(*this < other); }
+
+	private:
+		void Init(const std::string& str);
+	};
+
+	/** @} */
+
+}
+
+#endif
@@ -15,6 +15,7 @@
 #else
 #	include <vector>
 #endif
+#include <algorithm>
 #include <string>
 
 namespace stingray
@@ -49,10 +50,30 @@ namespace stingray
 
 	public:
 		inline bool empty() const { return _buf.empty(); }
+		inline size_t size() const { return _buf.size(); }
+
+		/// @brief Discards the contents, the allocated storage is kept for reuse
+		inline void clear() { _buf.clear(); }
 
 		std::string str() const
 		{ return std::string(_buf.begin(), _buf.end()); }
 
+		/// @brief Copies the contents to the given string, reusing its storage
+		void copy_to(std::basic_string<value_type>& result) const
+		{
+			result.resize(_buf.size());
+			std::copy(_buf.begin(), _buf.end(), result.begin());
+		}
+
+		/// @brief Copies at most maxSize characters of the contents to the given buffer
+		/// @returns number of the copied characters
+		size_t copy_to(value_type* result, size_t maxSize) const
+		{
+			const size_t size = std::min(_buf.size(), maxSize);
+			std::copy(_buf.begin(), _buf.begin() + size, result);
+			return size;
+		}
+
 		void str(const std::string &value)
 		{ _buf.assign(value.begin(), value.end()); }
 
@@ -17,6 +17,7 @@ namespace stingray
 	{
 	private:
 		const bool			_profileCalls;
+		const function<std::string()>	_profilerMessageGetter; // made once, so that the profiled tasks don't allocate it
 
 		Mutex				_guard;
 		optional<Task>		_task;
@@ -26,7 +27,9 @@ namespace stingray
 
 	public:
 		explicit WorkerWrapper(const std::string& name, bool profileCalls = true) :
-			_profileCalls(profileCalls), _worker(new Thread(name, bind(&WorkerWrapper::ThreadFunc, this, _1)))
+			_profileCalls(profileCalls),
+			_profilerMessageGetter(bind(&WorkerWrapper::GetProfilerMessage, this)),
+			_worker(new Thread(name, bind(&WorkerWrapper::ThreadFunc, this, _1)))
 		{ }
 
 		bool TryAddTask(const Task& task)
@@ -41,6 +44,10 @@ namespace stingray
 		}
 
 	private:
+		// the task is not replaced until the profiler session ends
+		std::string GetProfilerMessage() const
+		{ return StringBuilder() % get_function_name(*_task) % " in ThreadPool worker"; }
+
 		void ThreadFunc(const ICancellationToken& token)
 		{
 			MutexLock l(_guard);
@@ -56,7 +63,7 @@ namespace stingray
 					MutexUnlock ul(l);
 					if (_profileCalls)
 					{
-						AsyncProfiler::Session profilerSession(ExecutorsProfiler::Instance().GetProfiler(), StringBuilder() % get_function_name(*_task) % " in ThreadPool worker", 10000);
+						AsyncProfiler::Session profilerSession(ExecutorsProfiler::Instance().GetProfiler(), _profilerMessageGetter, 10000, AsyncProfiler::Session::NameGetterTag());
 						(*_task)(token);
 					}
 					else
@@ -23,6 +23,8 @@ namespace stingray
 		:	_name(name),
 			_profileTimeout(profileTimeout),
 			_exceptionHandler(exceptionHandler),
+			_profiledTask(),
+			_profilerMessageGetter(bind(&ThreadTaskExecutor::GetProfilerMessage, this)),
 			_worker(make_shared<Thread>(name, bind(&ThreadTaskExecutor::ThreadFunc, this, _1)))
 	{ }
 
@@ -42,8 +44,8 @@ namespace stingray
 	{ s_logger.Error() << "Executor func exception: " << ex; }
 
 
-	std::string ThreadTaskExecutor::GetProfilerMessage(const function<void()>& func) const
-	{ return StringBuilder() % get_function_name(func) % " in ThreadTaskExecutor '" % _name % "'"; }
+	std::string ThreadTaskExecutor::GetProfilerMessage() const
+	{ return StringBuilder() % get_function_name(*_profiledTask) % " in ThreadTaskExecutor '" % _name % "'"; }
 
 
 	void ThreadTaskExecutor::ThreadFunc(const ICancellationToken& token)
@@ -79,7 +81,8 @@ namespace stingray
 
 			if (_profileTimeout)
 			{
-				AsyncProfiler::Session profiler_session(ExecutorsProfiler::Instance().GetProfiler(), bind(&ThreadTaskExecutor::GetProfilerMessage, this, ref(task.first)), _profileTimeout->GetMilliseconds(), AsyncProfiler::Session::NameGetterTag());
+				_profiledTask = &task.first;
+				AsyncProfiler::Session profiler_session(ExecutorsProfiler::Instance().GetProfiler(), _profilerMessageGetter, _profileTimeout->GetMilliseconds(), AsyncProfiler::Session::NameGetterTag());
 				task.first();
 			}
 			else
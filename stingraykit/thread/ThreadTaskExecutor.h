@@ -49,6 +49,9 @@ namespace stingray
 		optional<TimeDuration>	_profileTimeout;
 		ExceptionHandlerType	_exceptionHandler;
 
+		mutable const TaskType*	_profiledTask; // read by the profiler only while the session of that task is open
+		function<std::string()>	_profilerMessageGetter; // made once, so that the profiled tasks don't allocate it
+
 		Mutex					_syncRoot;
 		QueueType				_queue;
 		ConditionVariable		_condVar;
@@ -63,7 +66,7 @@ namespace stingray
 		static void DefaultExceptionHandler(const std::exception& ex);
 
 	private:
-		std::string GetProfilerMessage(const function<void()>& func) const;
+		std::string GetProfilerMessage() const;
 
 		void ThreadFunc(const ICancellationToken& token);
 		void ExecuteTask(const TaskPair& task) const;
@@ -63,7 +63,14 @@ namespace stingray
 			static inline IntType Dec(Type& atomic, MemoryOrderImpl::Enum order)              { return __sync_sub_and_fetch(&atomic, 1); }
 			static inline IntType Add(Type& atomic, IntType val, MemoryOrderImpl::Enum order) { return __sync_add_and_fetch(&atomic, val); }
 			static inline IntType Sub(Type& atomic, IntType val, MemoryOrderImpl::Enum order) { return __sync_sub_and_fetch(&atomic, val); }
-			static inline IntType Load(Type& atomic, MemoryOrderImpl::Enum order)             { return __sync_add_and_fetch(&atomic, 0); }
+
+			static inline IntType Load(Type& atomic, MemoryOrderImpl::Enum order)
+			{
+				// an aligned word is read atomically anyway, so a relaxed load does not need to take the cache line exclusively
+				if (order == MemoryOrderImpl::Relaxed && sizeof(IntType) <= sizeof(void*))
+					return *static_cast<volatile IntType*>(&atomic);
+				return __sync_add_and_fetch(&atomic, 0);
+			}
 
 			static inline void Store(Type& atomic, IntType val, MemoryOrderImpl::Enum order)
 			{
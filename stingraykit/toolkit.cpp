@@ -20,6 +20,7 @@
 #include <stingraykit/string/ToString.h>
 #include <stingraykit/collection/array.h>
 #include <stingraykit/function/bind.h>
+#include <stingraykit/thread/atomic/AtomicInt.h>
 
 namespace stingray
 {
@@ -49,6 +50,11 @@ namespace stingray
 	{
 		std::string backtrace = Backtrace().Get();
 		Logger::Error() << "Terminate was requested: " << str << (backtrace.empty() ? "" : ("\nbacktrace: " + backtrace));
+		try
+		{ Logger::Flush(); }
+		catch (const std::exception&)
+		{ }
+		FlightRecorder::DumpOnFatalError();
 		std::terminate();
 	}
 
@@ -65,6 +71,117 @@ namespace stingray
 	}
 #endif
 
+
+	namespace
+	{
+
+		/// @brief Lock-free open addressing table, entries are published once and live until the process exits
+		/// @par The entries that don't fit into the probe window go to a lock-free list, so every returned reference stays valid
+		class DemangledNamesCache
+		{
+			typedef BasicAtomicInt<intptr_t>	AtomicEntry;
+
+			static const size_t Capacity = 1024;
+			static const size_t MaxProbes = 16;
+
+			struct Entry
+			{
+				std::string		RawName;
+				std::string		Name;
+				const Entry*	Next;
+
+				Entry(const char* rawName, const std::string& name) : RawName(rawName), Name(name), Next() { }
+			};
+
+		private:
+			static AtomicEntry::Type	s_entries[Capacity];
+			static AtomicEntry::Type	s_overflow;
+
+		public:
+			static const std::string& Get(const std::type_info& info)
+			{
+				// the name pointer may be reused by another type after dlclose, so the entries are matched by the contents
+				const char* const rawName = info.name();
+				const size_t hash = Hash(rawName);
+
+				bool probesFull = true;
+				for (size_t i = 0; i < MaxProbes; ++i)
+				{
+					const Entry* const entry = reinterpret_cast<const Entry*>(AtomicEntry::Load(s_entries[(hash + i) % Capacity]));
+					if (!entry)
+					{
+						probesFull = false;
+						break;
+					}
+					if (entry->RawName == rawName)
+						return entry->Name;
+				}
+
+				// the names that didn't fit into the table are looked up before demangling, so that they are allocated only once
+				if (probesFull)
+				{
+					const Entry* const entry = FindOverflow(AtomicEntry::Load(s_overflow), rawName);
+					if (entry)
+						return entry->Name;
+				}
+
+				Entry* const newEntry = new Entry(rawName, Demangle(std::string(rawName)));
+				for (size_t i = 0; i < MaxProbes; ++i)
+				{
+					AtomicEntry::Type& slot = s_entries[(hash + i) % Capacity];
+					const Entry* const entry = reinterpret_cast<const Entry*>(AtomicEntry::CompareAndExchange(slot, 0, reinterpret_cast<intptr_t>(newEntry)));
+					if (!entry)
+						return newEntry->Name;
+					if (entry->RawName == rawName)
+					{
+						delete newEntry;
+						return entry->Name;
+					}
+				}
+
+				while (true)
+				{
+					const intptr_t head = AtomicEntry::Load(s_overflow);
+					const Entry* const entry = FindOverflow(head, rawName);
+					if (entry)
+					{
+						delete newEntry;
+						return entry->Name;
+					}
+
+					newEntry->Next = reinterpret_cast<const Entry*>(head);
+					if (AtomicEntry::CompareAndExchange(s_overflow, head, reinterpret_cast<intptr_t>(newEntry)) == head)
+						return newEntry->Name;
+				}
+			}
+
+		private:
+			static const Entry* FindOverflow(intptr_t head, const char* rawName)
+			{
+				for (const Entry* entry = reinterpret_cast<const Entry*>(head); entry; entry = entry->Next)
+					if (entry->RawName == rawName)
+						return entry;
+				return NULL;
+			}
+
+			static size_t Hash(const char* str)
+			{
+				size_t result = 2166136261u;
+				for (; *str; ++str)
+					result = (result ^ (unsigned char)*str) * 16777619u;
+				return result;
+			}
+		};
+
+		DemangledNamesCache::AtomicEntry::Type DemangledNamesCache::s_entries[DemangledNamesCache::Capacity];
+		DemangledNamesCache::AtomicEntry::Type DemangledNamesCache::s_overflow;
+
+	}
+
+
+	const std::string& Demangle(const std::type_info& info)
+	{ return DemangledNamesCache::Get(info); }
+
 }
 
 #ifdef _STLP_DEBUG_MESSAGE
@@ -16,6 +16,7 @@
 #include <stingraykit/metaprogramming/NestedTypeCheck.h>
 
 #include <stdexcept>
+#include <typeinfo>
 
 namespace stingray
 {
@@ -290,6 +291,9 @@ namespace stingray
 
 	std::string Demangle(const std::string& s);
 
+	/// @brief Demangles the type name, results are cached for the process lifetime, one entry per distinct name
+	const std::string& Demangle(const std::type_info& info);
+
 }
 
 
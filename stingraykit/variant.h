@@ -280,7 +280,7 @@ namespace stingray
 
 			template<typename T>
 			void ThrowBadVariantGet() const
-			{ STINGRAYKIT_THROW(bad_variant_get(Demangle(typeid(T).name()), Demangle(type().name()))); }
+			{ STINGRAYKIT_THROW(bad_variant_get(Demangle(typeid(T)), Demangle(type()))); }
 
 			struct GetTypeInfoVisitor : static_visitor<const std::type_info*>
 			{